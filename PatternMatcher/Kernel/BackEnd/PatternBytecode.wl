@@ -10,6 +10,7 @@ Begin["`Private`"]
 
 Needs["DanielS`PatternMatcher`"]
 Needs["DanielS`PatternMatcher`BackEnd`PatternBytecodeFormat`"]
+Needs["DanielS`PatternMatcher`BackEnd`VirtualMachine`"] (* for PatternMatcherVirtualMachineQ *)
 
 
 (*=============================================================================
@@ -50,6 +51,13 @@ Options[OptimizePatternBytecode] =
 OptimizePatternBytecode[obj_?PatternBytecodeQ] :=
 	obj["optimize"];
 
+(*
+	Recompiles the VM's pattern with the interchangeable alternatives it has
+	matched most often tried first. The bytecode object itself is unchanged.
+*)
+OptimizePatternBytecode[vm_?PatternMatcherVirtualMachineQ] :=
+	vm["reorderAlternatives"];
+
 
 (*=============================================================================
 	PatternBytecodeInformation
@@ -63,11 +71,14 @@ PatternBytecodeInformation[obj_?PatternBytecodeQ] :=
 		"LabelCount" -> obj["getLabelCount"],
 		"ExprRegisterCount" -> obj["getExprRegisterCount"],
 		"BoolRegisterCount" -> obj["getBoolRegisterCount"],
+		"ExprVirtualRegisterCount" -> obj["getExprVirtualRegisterCount"],
+		"BoolVirtualRegisterCount" -> obj["getBoolVirtualRegisterCount"],
 		"BlockCount" -> obj["getBlockCount"],
 		"MaxBlockDepth" -> obj["getMaxBlockDepth"],
 		"JumpCount" -> obj["getJumpCount"],
 		"BacktrackPointCount" -> obj["getBacktrackPointCount"],
-		"LexicalBindings" -> obj["getLexicalBindings"]
+		"LexicalBindings" -> obj["getLexicalBindings"],
+		"VariableSlots" -> obj["getVariableSlots"]
 	|>;
 
 PatternBytecodeInformation[x_] :=
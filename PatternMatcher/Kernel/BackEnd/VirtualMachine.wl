@@ -36,8 +36,14 @@ CreatePatternMatcherVirtualMachine[] :=
 		vm
 	];
 
-CreatePatternMatcherVirtualMachine[pattExpr_] :=
-	Module[{vm, patt},
+Options[CreatePatternMatcherVirtualMachine] =
+	{
+		(* Reorder disjoint alternatives by branch profile every n matches (None: only on OptimizePatternBytecode[vm]) *)
+		"ReorderAlternativesAfter" -> None
+	};
+
+CreatePatternMatcherVirtualMachine[pattExpr_, OptionsPattern[]] :=
+	Module[{vm, patt, interval},
 		vm = CreatePatternMatcherVirtualMachine[];
 		patt = If[PatternBytecodeQ[pattExpr],
 			pattExpr
@@ -45,6 +51,10 @@ CreatePatternMatcherVirtualMachine[pattExpr_] :=
 			CompilePatternToBytecode[pattExpr, vm]
 		];
 		vm["initialize", patt];
+		interval = OptionValue["ReorderAlternativesAfter"];
+		If[IntegerQ[interval] && interval > 0,
+			vm["setReorderInterval", interval]
+		];
 		vm
 	];
 
@@ -53,6 +63,21 @@ CreatePatternMatcherVirtualMachine[__] :=
 	$Failed;
 
 
+(*=============================================================================
+	PatternMatcherEnableTrace
+=============================================================================*)
+
+(*
+	Selects the execution engine of a single VM. Other VMs keep following the
+	global flag set by PatternMatcherEnableTrace[True|False].
+*)
+DanielS`PatternMatcher`PatternMatcherEnableTrace[vm_?PatternMatcherVirtualMachineQ, enabled:(True|False)] :=
+	Module[{},
+		vm["setEngine", If[enabled, "Trace", "NoTrace"]];
+		enabled
+	];
+
+
 (*=============================================================================
 	PatternMatcherVirtualMachineQ
 =============================================================================*)
@@ -69,11 +94,12 @@ PatternMatcherVirtualMachineQ[_] :=
 =============================================================================*)
 
 toBoxes[obj_, fmt_] :=
-	Module[{initialized, halted, cycles, pc},
+	Module[{initialized, halted, cycles, pc, engine},
 		initialized = obj["isInitialized"];
 		halted = obj["isHalted"];
 		cycles = obj["getCycles"];
 		pc = obj["getPC"];
+		engine = obj["getEngine"];
 		BoxForm`ArrangeSummaryBox[
 			"PatternMatcherVirtualMachine",
 			obj,
@@ -85,6 +111,7 @@ toBoxes[obj_, fmt_] :=
 				BoxForm`SummaryItem[{"Cycles: ", cycles}]
 			},
 			{
+				BoxForm`SummaryItem[{"Engine: ", engine}],
 				If[initialized,
 					BoxForm`SummaryItem[{"Bytecode: ", obj["getBytecode"]}],
 					Nothing
@@ -18,19 +18,25 @@ CompilePatternToBytecode::unsup =
 	"The pattern expression `1` is currently not supported.";
 
 SyntaxInformation[CompilePatternToBytecode] =
-	{"ArgumentsPattern" -> {_, _.}};
+	{"ArgumentsPattern" -> {_, _., OptionsPattern[]}};
 
-CompilePatternToBytecode[pattExpr_, vm_?PatternMatcherVirtualMachineQ] :=
+Options[CompilePatternToBytecode] =
+	{
+		(* 0: none, 1: local passes, 2: every pass *)
+		"OptimizationLevel" -> 2
+	};
+
+CompilePatternToBytecode[pattExpr_, vm_?PatternMatcherVirtualMachineQ, OptionsPattern[]] :=
 	Module[{res},
-		res = vm["compilePattern", pattExpr];
+		res = vm["compilePattern", pattExpr, OptionValue["OptimizationLevel"]];
 		If[!PatternBytecodeQ[res],
 			ThrowFailure["CompilePatternToBytecode", "Failed to compile pattern expression `1` to bytecode: `2`.", {pattExpr, res}]
 		];
 		res
 	];
 
-CompilePatternToBytecode[pattExpr_] :=
-	CompilePatternToBytecode[pattExpr, CreatePatternMatcherVirtualMachine[]];
+CompilePatternToBytecode[pattExpr_, opts:OptionsPattern[]] :=
+	CompilePatternToBytecode[pattExpr, CreatePatternMatcherVirtualMachine[], opts];
 
 
 End[]
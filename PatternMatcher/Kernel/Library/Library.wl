@@ -83,14 +83,18 @@ InitializePatternMatcherLibraryInternal[OptionsPattern[InitializePatternMatcherL
 	];
 
 
-DanielS`PatternMatcher`PatternMatcherEnableTrace :=
+setTraceEnabled :=
 	Module[{},
 		InitializePatternMatcherLibrary[];
-		Clear[DanielS`PatternMatcher`PatternMatcherEnableTrace];
-		DanielS`PatternMatcher`PatternMatcherEnableTrace =
+		Clear[setTraceEnabled];
+		setTraceEnabled =
 			SafeLibraryFunctionLoad[$PatternMatcherLibrary, "PatternMatcherLibrary_SetTraceEnabled", {True|False}, True|False]
 	];
 
+(* The per-VM form PatternMatcherEnableTrace[vm, enabled] is defined in BackEnd/VirtualMachine.wl *)
+DanielS`PatternMatcher`PatternMatcherEnableTrace[enabled:(True|False)] :=
+	setTraceEnabled[enabled];
+
 
 DanielS`PatternMatcher`PatternMatcherTraceEnabledQ :=
 	Module[{},
@@ -22,11 +22,13 @@ PatternBytecodeInformation::usage =
 
 
 OptimizePatternBytecode::usage =
-	"OptimizePatternBytecode[bytecodeObj] performs optimization passes on the given pattern bytecode object.";
+	"OptimizePatternBytecode[bytecodeObj] performs optimization passes on the given pattern bytecode object.\n" <>
+	"OptimizePatternBytecode[vm] reorders the disjoint alternatives of the pattern run by vm, most often matched first.";
 
 
 CompilePatternToBytecode::usage =
-	"CompilePatternToBytecode[patt] converts a pattern expression into bytecode to be run in a virtual machine.";
+	"CompilePatternToBytecode[patt] converts a pattern expression into bytecode to be run in a virtual machine.\n" <>
+	"CompilePatternToBytecode[patt, \"OptimizationLevel\" -> n] runs the optimization passes of level n (0, 1 or 2; default 2).";
 
 
 PatternMatcherVirtualMachine::usage =
@@ -34,7 +36,8 @@ PatternMatcherVirtualMachine::usage =
 
 
 CreatePatternMatcherVirtualMachine::usage =
-	"CreatePatternMatcherVirtualMachine[pattObj] creates a virtual machine for the pattern matcher object pattObj$.";
+	"CreatePatternMatcherVirtualMachine[pattObj] creates a virtual machine for the pattern matcher object pattObj$.\n" <>
+	"CreatePatternMatcherVirtualMachine[pattObj, \"ReorderAlternativesAfter\" -> n] reorders the disjoint alternatives by branch profile every n matches.";
 
 
 PatternMatcherExecute::usage =
@@ -58,7 +61,8 @@ ResetPatternMatcherVirtualMachine::usage =
 
 
 PatternMatcherEnableTrace::usage =
-	"PatternMatcherEnableTrace[True|False] enables or disables trace output globally for all VMs.";
+	"PatternMatcherEnableTrace[True|False] enables or disables trace output globally for all VMs.\n" <>
+	"PatternMatcherEnableTrace[vm, True|False] switches the given VM to the trace or the uninstrumented execution engine.";
 
 
 PatternMatcherTraceEnabledQ::usage =
@@ -14,11 +14,11 @@ Begin["`Private`"]
 $CategoriesToOpcodes = <|
 	"DataMovement" -> {"MOVE", "LOAD_IMM"},
 	"Introspection" -> {"GET_LENGTH", "GET_PART"},
-	"Matching" -> {"MATCH_HEAD", "MATCH_LENGTH", "MATCH_MIN_LENGTH", "MATCH_LITERAL", "APPLY_TEST", "MATCH_SEQ_HEADS"},
+	"Matching" -> {"MATCH_HEAD", "MATCH_LENGTH", "MATCH_SHAPE", "MATCH_MIN_LENGTH", "MATCH_SHAPE_MIN", "MATCH_LITERAL", "MATCH_LITERAL_SET", "APPLY_TEST", "TEST_INTRINSIC", "EVAL_CONDITION", "EVAL_NATIVE_CONDITION", "MATCH_SEQ_HEADS"},
 	"Sequence" -> {"MAKE_SEQUENCE", "SPLIT_SEQ"},
-	"Comparison" -> {"SAMEQ"},
-	"Binding" -> {"BIND_VAR", "SAVE_BINDING"},
-	"ControlFlow" -> {"JUMP", "BRANCH_FALSE", "HALT"},
+	"Comparison" -> {"SAMEQ", "SAMEQ_BRANCH"},
+	"Binding" -> {"BIND_VAR", "SAVE_BINDING", "BIND_FROM", "BIND_OR_COMPARE"},
+	"ControlFlow" -> {"JUMP", "BRANCH_FALSE", "SWITCH_ON_HEAD", "SWITCH_ON_LITERAL", "HALT"},
 	"Scope" -> {"BEGIN_BLOCK", "END_BLOCK", "EXPORT_BINDINGS"},
 	"Backtracking" -> {"TRY", "RETRY", "TRUST", "CUT", "FAIL"},
 	"Debug" -> {"DEBUG_PRINT"}
@@ -12,6 +12,7 @@
 #include <cstring>
 #include <optional>
 #include <string>
+#include <string_view>
 
 namespace PatternMatcher
 {
@@ -33,6 +34,19 @@ std::optional<std::string> Expr::as<std::string>() const
 	return res;
 }
 
+// std::string_view specialization (no copy; valid while the expression is alive)
+template <>
+std::optional<std::string_view> Expr::as<std::string_view>() const
+{
+	const char* bytes;
+	mint len;
+	if (!StringExpressionToUTF8Bytes(instance, &bytes, &len))
+	{
+		return std::nullopt;
+	}
+	return std::string_view(bytes, static_cast<size_t>(len));
+}
+
 // mint specialization
 template <>
 std::optional<mint> Expr::as<mint>() const
@@ -50,9 +64,10 @@ template <>
 std::optional<bool> Expr::as<bool>() const
 {
 	// TODO: TestGet_Boolean or something
-	if (Expr::construct("BooleanQ", *this).eval().sameQ("True"))
+	const auto& constants = getExprConstants();
+	if (Expr::construct("BooleanQ", *this).eval().sameQ(constants.trueSymbol))
 	{
-		return sameQ("True");
+		return sameQ(constants.trueSymbol);
 	}
 	return std::nullopt;
 }
@@ -87,7 +102,7 @@ Expr::Expr(std::string txt)
 {
 }
 
-Expr Expr::eval()
+Expr Expr::eval() const
 {
 	return Expr(Evaluate_E_E(instance));
 }
@@ -112,7 +127,7 @@ Expr Expr::head() const
 	return Expr(Part_E_I_E(instance, 0));
 }
 
-void Expr::setPart(mint i, Expr val)
+void Expr::setPart(mint i, const Expr& val)
 {
 	SetElement_EIE_E(instance, i, val.instance);
 }
@@ -122,7 +137,7 @@ mint Expr::print()
 	return Print_E_I(instance);
 }
 
-bool Expr::sameQ(Expr other) const
+bool Expr::sameQ(const Expr& other) const
 {
 	return SameQ_E_E_Boolean(instance, other.instance);
 }
@@ -160,7 +175,7 @@ bool Expr::stringQ() const
 // Return true if an expr list.
 bool Expr::listQ() const
 {
-	return head().sameQ(Expr::ToExpression("List"));
+	return head().sameQ(getExprConstants().listHead);
 }
 
 // Return true if an expr rule.
@@ -265,7 +280,25 @@ Expr Expr::throwError(const char* txt, Expr arg1)
 	return eThrow;
 }
 
-static Expr ENULL = Expr(LoadENULL());
-static Expr EFAIL = Expr(LoadEFAIL());
+const ExprConstants& getExprConstants()
+{
+	// Built lazily so that parsing happens after the runtime is initialized
+	static const ExprConstants constants {
+		Expr::ToExpression("Null"),
+		Expr::ToExpression("$$Failure"),
+		Expr::ToExpression("True"),
+		Expr::ToExpression("False"),
+		Expr::ToExpression("System`Sequence"),
+		Expr::ToExpression("System`List"),
+		Expr::ToExpression("System`Set"),
+		Expr::ToExpression("System`Block"),
+		Expr::ToExpression("System`Integer"),
+		Expr::ToExpression("System`String"),
+		Expr::ToExpression("System`Symbol"),
+		Expr::ToExpression("System`Real"),
+		Expr::ToExpression("System`Complex"),
+	};
+	return constants;
+}
 
 }; // namespace PatternMatcher
@@ -4,6 +4,7 @@
 
 #include <optional>
 #include <string>
+#include <string_view>
 #include <map>
 #include <type_traits>
 #include <typeinfo>
@@ -69,6 +70,32 @@ extern "C" ExprStruct CompilerSymbolName(ExprStruct sym);
 extern "C" ExprStruct CompilerContext(ExprStruct sym);
 extern "C" bool CompilerProtectedQ(ExprStruct sym);
 
+/*
+ *  Refcount audit (build with PM_REFCOUNT_AUDIT).
+ *
+ *  Counts every Expression_Acquire_Export / Expression_Release_Export issued
+ *  through Expr, so callers can measure refcount traffic by taking the
+ *  difference of two snapshots (see VirtualMachine::getRefcountAudit).
+ *  Without the flag counting compiles away and the counters stay at zero.
+ */
+struct ExprRefcountAudit
+{
+	static constexpr bool enabled =
+#ifdef PM_REFCOUNT_AUDIT
+		true;
+#else
+		false;
+#endif
+	static inline size_t acquireCount = 0;
+	static inline size_t releaseCount = 0;
+};
+
+#ifdef PM_REFCOUNT_AUDIT
+#define PM_REFCOUNT_AUDIT_COUNT(counter) (++ExprRefcountAudit::counter)
+#else
+#define PM_REFCOUNT_AUDIT_COUNT(counter) ((void) 0)
+#endif
+
 class Expr
 {
 
@@ -100,18 +127,40 @@ public:
 		acquire();
 	}
 
+	// Take over the reference held by other (no refcount traffic)
+	Expr(Expr&& other) noexcept
+	{
+		instance = other.instance;
+		other.instance = nullptr;
+	}
+
 	//  this = other
 	Expr& operator=(const Expr& rhs)
 	{
-		release();
-		instance = rhs.instance;
-		acquire();
+		if (instance != rhs.instance)
+		{
+			release();
+			instance = rhs.instance;
+			acquire();
+		}
+		return *this;
+	}
+
+	//  this = std::move(other)
+	Expr& operator=(Expr&& rhs) noexcept
+	{
+		if (this != &rhs)
+		{
+			release();
+			instance = rhs.instance;
+			rhs.instance = nullptr;
+		}
 		return *this;
 	}
 
-	~Expr() { Expression_Release_Export(instance); }
+	~Expr() { release(); }
 
-	Expr eval();
+	Expr eval() const;
 
 	mint length() const;
 
@@ -123,7 +172,7 @@ public:
 
 	mint print();
 
-	void setPart(mint i, Expr val);
+	void setPart(mint i, const Expr& val);
 
 	void setPart(Expr i, Expr val);
 
@@ -145,7 +194,7 @@ public:
 		return Cast_E_Boolean(instance);
 	}
 
-	bool sameQ(Expr other) const;
+	bool sameQ(const Expr& other) const;
 
 	bool sameQ(const char* other) const;
 
@@ -170,20 +219,20 @@ public:
 	/// @param head The head of the expression.
 	/// @param ...args The arguments to construct the expression.
 	template <typename... TArgs>
-	static Expr construct(Expr head, TArgs... args)
+	static Expr construct(const Expr& head, const TArgs&... args)
 	{
 		constexpr mint len = sizeof...(TArgs);
 		Expr res = Expr(CreateHeaded_IE_E(len, head.instance));
 		int partIndex = 1;
-		(res.setPart(partIndex++, std::forward<TArgs>(args)), ...);
+		(res.setPart(partIndex++, args), ...);
 		return res;
 	}
 
 	template <typename... TArgs>
-	static Expr construct(const char* headStr, TArgs... args)
+	static Expr construct(const char* headStr, const TArgs&... args)
 	{
 		Expr head = Expr::ToExpression(headStr);
-		return Expr::construct(head, std::forward<TArgs>(args)...);
+		return Expr::construct(head, args...);
 	}
 
 	/*
@@ -217,11 +266,49 @@ public:
 private:
 	ExprStruct instance;
 
-	mint acquire() { return Expression_Acquire_Export(instance); }
+	mint acquire()
+	{
+		if (!instance) // empty (e.g. an unbound frame slot)
+			return 0;
+		PM_REFCOUNT_AUDIT_COUNT(acquireCount);
+		return Expression_Acquire_Export(instance);
+	}
+
+	mint release()
+	{
+		if (!instance) // moved-from
+			return 0;
+		PM_REFCOUNT_AUDIT_COUNT(releaseCount);
+		return Expression_Release_Export(instance);
+	}
+};
+
+/* =======================================================================
+ * Interned constants
+ * ======================================================================= */
 
-	mint release() { return Expression_Release_Export(instance); }
+/// @brief Expressions the library uses on hot paths, built once per library load
+/// @note Use these instead of Expr::ToExpression, which parses on every call
+struct ExprConstants
+{
+	Expr nullSymbol; ///< Null
+	Expr failureSymbol; ///< $$Failure (value of an unbound variable)
+	Expr trueSymbol; ///< True
+	Expr falseSymbol; ///< False
+	Expr sequenceHead; ///< Sequence
+	Expr listHead; ///< List
+	Expr setHead; ///< Set
+	Expr blockHead; ///< Block
+	Expr integerHead; ///< Integer
+	Expr stringHead; ///< String
+	Expr symbolHead; ///< Symbol
+	Expr realHead; ///< Real
+	Expr complexHead; ///< Complex
 };
 
+/// @brief Get the interned constants (parsed on first use)
+const ExprConstants& getExprConstants();
+
 /* =======================================================================
  * T to Expr conversions
  * ======================================================================= */
@@ -235,10 +322,10 @@ inline Expr toExpr(mint arg)
 	return Expr(arg);
 }
 
-// TODO: Find a better way to do expr bools
 inline Expr toExpr(bool arg)
 {
-	return Expr::ToExpression(arg ? "True" : "False");
+	const auto& constants = getExprConstants();
+	return arg ? constants.trueSymbol : constants.falseSymbol;
 }
 
 // fallback: disabled unless someone defines it
@@ -143,6 +143,14 @@ public:
 		logOrTrace<logLevel>(traceHandlerName, line, file, function, std::forward<TArgs>(args)...);
 	}
 
+	/// Emit a trace message without consulting the runtime trace flag
+	/// (the VM's Trace engine has already been selected explicitly)
+	template <Level logLevel, typename... TArgs>
+	static void traceAlways(int line, const char* file, const char* function, TArgs&&... args)
+	{
+		logOrTrace<logLevel>(traceHandlerName, line, file, function, std::forward<TArgs>(args)...);
+	}
+
 	// Enable/disable tracing at runtime
 	static void setTraceEnabled(bool enabled) { traceEnabled = enabled; }
 	static bool isTraceEnabled() { return traceEnabled; }
@@ -0,0 +1,477 @@
+#include "VM/AnalyzePatternBytecode.h"
+#include "VM/Opcode.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <variant>
+
+namespace PatternMatcher::BytecodeAnalysis
+{
+
+RegisterAccess getRegisterAccess(const PatternBytecode::Instruction& instr)
+{
+	RegisterAccess access;
+	bool writesDest = writesFirstOperand(instr.opcode);
+
+	for (size_t i = 0; i < instr.ops.size(); ++i)
+	{
+		bool isWrite = writesDest && i == 0;
+		if (auto* r = std::get_if<ExprRegOp>(&instr.ops[i]))
+		{
+			(isWrite ? access.exprWrites : access.exprReads).push_back(r->v);
+		}
+		else if (auto* b = std::get_if<BoolRegOp>(&instr.ops[i]))
+		{
+			(isWrite ? access.boolWrites : access.boolReads).push_back(b->v);
+		}
+	}
+
+	// HALT returns %b0 to the caller
+	if (instr.opcode == Opcode::HALT)
+	{
+		access.boolReads.push_back(0);
+	}
+
+	// SPLIT_SEQ splits its second operand in place
+	if (instr.opcode == Opcode::SPLIT_SEQ && instr.ops.size() > 1)
+	{
+		if (auto* r = std::get_if<ExprRegOp>(&instr.ops[1]))
+			access.exprWrites.push_back(r->v);
+	}
+
+	// BIND_OR_COMPARE only overwrites its first operand when it holds $$Failure
+	if (instr.opcode == Opcode::BIND_OR_COMPARE && !instr.ops.empty())
+	{
+		if (auto* r = std::get_if<ExprRegOp>(&instr.ops[0]))
+			access.exprReads.push_back(r->v);
+	}
+
+	return access;
+}
+
+std::vector<size_t> getSuccessors(const PatternBytecode& bc, size_t pc)
+{
+	const auto& instrs = bc.getInstructions();
+	const auto& labelMap = bc.getLabelMap();
+	const auto& instr = instrs[pc];
+
+	std::vector<size_t> succs;
+	if (fallsThrough(instr.opcode) && pc + 1 < instrs.size())
+	{
+		succs.push_back(pc + 1);
+	}
+
+	// Scope labels are not control transfers
+	if (instr.opcode == Opcode::BEGIN_BLOCK || instr.opcode == Opcode::END_BLOCK)
+		return succs;
+
+	for (const auto& op : instr.ops)
+	{
+		if (auto* l = std::get_if<LabelOp>(&op))
+		{
+			auto it = labelMap.find(l->v);
+			if (it != labelMap.end() && it->second < instrs.size())
+			{
+				succs.push_back(it->second);
+			}
+		}
+	}
+
+	// Switch cases are targets too
+	if (instr.opcode == Opcode::SWITCH_ON_HEAD || instr.opcode == Opcode::SWITCH_ON_LITERAL)
+	{
+		const auto& table = bc.getSwitchTables()[std::get<ImmMint>(instr.ops[1]).v];
+		for (const auto& [key, label] : table.cases)
+		{
+			auto it = labelMap.find(label);
+			if (it != labelMap.end() && it->second < instrs.size())
+				succs.push_back(it->second);
+		}
+	}
+	return succs;
+}
+
+std::vector<std::vector<size_t>> getPredecessors(const PatternBytecode& bc)
+{
+	std::vector<std::vector<size_t>> preds(bc.getInstructions().size());
+	for (size_t pc = 0; pc < preds.size(); ++pc)
+		for (auto s : getSuccessors(bc, pc))
+			preds[s].push_back(pc);
+	return preds;
+}
+
+bool Dominators::dominates(size_t a, size_t b) const
+{
+	if (b >= idom.size() || idom[b] == None)
+		return false;
+	while (b != a)
+	{
+		if (idom[b] == b)
+			return false; // Reached the entry
+		b = idom[b];
+	}
+	return true;
+}
+
+// Iterative algorithm of Cooper, Harvey and Kennedy over reverse postorder
+Dominators computeDominators(const PatternBytecode& bc)
+{
+	size_t n = bc.getInstructions().size();
+	Dominators dom;
+	dom.idom.assign(n, Dominators::None);
+	if (n == 0)
+		return dom;
+
+	std::vector<std::vector<size_t>> succs(n);
+	for (size_t pc = 0; pc < n; ++pc)
+		succs[pc] = getSuccessors(bc, pc);
+
+	// Reverse postorder of the instructions reachable from the entry
+	std::vector<size_t> order;
+	std::vector<size_t> rpoIndex(n, Dominators::None);
+	{
+		std::vector<bool> visited(n, false);
+		std::vector<std::pair<size_t, size_t>> stack { { 0, 0 } }; // pc, next successor
+		visited[0] = true;
+		while (!stack.empty())
+		{
+			auto& [pc, next] = stack.back();
+			if (next < succs[pc].size())
+			{
+				size_t s = succs[pc][next++];
+				if (!visited[s])
+				{
+					visited[s] = true;
+					stack.emplace_back(s, 0);
+				}
+				continue;
+			}
+			order.push_back(pc);
+			stack.pop_back();
+		}
+		std::reverse(order.begin(), order.end());
+		for (size_t i = 0; i < order.size(); ++i)
+			rpoIndex[order[i]] = i;
+	}
+
+	std::vector<std::vector<size_t>> preds(n);
+	for (auto pc : order)
+		for (auto s : succs[pc])
+			preds[s].push_back(pc);
+
+	auto intersect = [&](size_t a, size_t b) {
+		while (a != b)
+		{
+			while (rpoIndex[a] > rpoIndex[b])
+				a = dom.idom[a];
+			while (rpoIndex[b] > rpoIndex[a])
+				b = dom.idom[b];
+		}
+		return a;
+	};
+
+	dom.idom[0] = 0;
+	bool changed = true;
+	while (changed)
+	{
+		changed = false;
+		for (size_t i = 1; i < order.size(); ++i)
+		{
+			size_t pc = order[i];
+			size_t newIdom = Dominators::None;
+			for (auto p : preds[pc])
+			{
+				if (dom.idom[p] == Dominators::None)
+					continue;
+				newIdom = newIdom == Dominators::None ? p : intersect(p, newIdom);
+			}
+			if (newIdom != dom.idom[pc])
+			{
+				dom.idom[pc] = newIdom;
+				changed = true;
+			}
+		}
+	}
+	return dom;
+}
+
+std::vector<size_t> ControlFlowGraph::reversePostorder() const
+{
+	std::vector<size_t> order;
+	if (blocks.empty())
+		return order;
+
+	std::vector<bool> visited(blocks.size(), false);
+	std::vector<std::pair<size_t, size_t>> stack { { 0, 0 } }; // block, next successor
+	visited[0] = true;
+	while (!stack.empty())
+	{
+		auto& [b, next] = stack.back();
+		if (next < blocks[b].successors.size())
+		{
+			size_t s = blocks[b].successors[next++].block;
+			if (!visited[s])
+			{
+				visited[s] = true;
+				stack.emplace_back(s, 0);
+			}
+			continue;
+		}
+		order.push_back(b);
+		stack.pop_back();
+	}
+	std::reverse(order.begin(), order.end());
+	return order;
+}
+
+ControlFlowGraph buildControlFlowGraph(const PatternBytecode& bc)
+{
+	const auto& instrs = bc.getInstructions();
+	size_t n = instrs.size();
+	ControlFlowGraph cfg;
+	if (n == 0)
+		return cfg;
+
+	// Leaders: the entry, labelled instructions, and whatever follows a transfer
+	std::vector<bool> leader(n, false);
+	leader[0] = true;
+	for (const auto& [label, target] : bc.getLabelMap())
+	{
+		if (target < n)
+			leader[target] = true;
+	}
+	for (size_t pc = 0; pc + 1 < n; ++pc)
+	{
+		auto succs = getSuccessors(bc, pc);
+		if (!fallsThrough(instrs[pc].opcode) || succs.size() != 1 || succs[0] != pc + 1)
+			leader[pc + 1] = true;
+	}
+
+	cfg.blockOf.assign(n, 0);
+	for (size_t pc = 0; pc < n; ++pc)
+	{
+		if (leader[pc])
+			cfg.blocks.push_back(ControlFlowGraph::BasicBlock { pc, pc + 1, {}, {} });
+		else
+			cfg.blocks.back().end = pc + 1;
+		cfg.blockOf[pc] = cfg.blocks.size() - 1;
+	}
+
+	for (size_t b = 0; b < cfg.blocks.size(); ++b)
+	{
+		size_t last = cfg.blocks[b].end - 1;
+		const auto& instr = instrs[last];
+		bool choicePoint = instr.opcode == Opcode::TRY || instr.opcode == Opcode::RETRY;
+		for (auto s : getSuccessors(bc, last))
+		{
+			EdgeKind kind = s == last + 1 && fallsThrough(instr.opcode) ? EdgeKind::FallThrough
+							: choicePoint								   ? EdgeKind::ChoicePoint
+																		   : EdgeKind::Jump;
+			size_t to = cfg.blockOf[s];
+			auto& succs = cfg.blocks[b].successors;
+			if (std::any_of(succs.begin(), succs.end(), [&](const auto& e) { return e.block == to; }))
+				continue;
+			succs.push_back({ to, kind });
+			cfg.blocks[to].predecessors.push_back({ b, kind });
+		}
+	}
+	return cfg;
+}
+
+Liveness computeLiveness(const PatternBytecode& bc)
+{
+	const auto& instrs = bc.getInstructions();
+	size_t n = instrs.size();
+	size_t exprCount = static_cast<size_t>(bc.getExprRegisterCount());
+	size_t boolCount = static_cast<size_t>(bc.getBoolRegisterCount());
+
+	Liveness live;
+	live.exprIn.assign(n, std::vector<bool>(exprCount, false));
+	live.boolIn.assign(n, std::vector<bool>(boolCount, false));
+
+	std::vector<RegisterAccess> access;
+	std::vector<std::vector<size_t>> succs;
+	access.reserve(n);
+	succs.reserve(n);
+	for (size_t pc = 0; pc < n; ++pc)
+	{
+		access.push_back(getRegisterAccess(instrs[pc]));
+		succs.push_back(getSuccessors(bc, pc));
+	}
+
+	// in[pc] = reads[pc] ∪ (∪ in[succ] − writes[pc])
+	// Iterating in reverse order converges in a few passes for compiler-emitted code
+	auto transfer = [](std::vector<bool>& in, const std::vector<bool>& out, const std::vector<size_t>& writes,
+					   const std::vector<size_t>& reads) -> bool {
+		std::vector<bool> next = out;
+		for (auto r : writes)
+			if (r < next.size())
+				next[r] = false;
+		for (auto r : reads)
+			if (r < next.size())
+				next[r] = true;
+		if (next == in)
+			return false;
+		in = std::move(next);
+		return true;
+	};
+
+	bool changed = true;
+	while (changed)
+	{
+		changed = false;
+		for (size_t pc = n; pc-- > 0;)
+		{
+			std::vector<bool> exprOut(exprCount, false);
+			std::vector<bool> boolOut(boolCount, false);
+			for (auto s : succs[pc])
+			{
+				for (size_t r = 0; r < exprCount; ++r)
+					exprOut[r] = exprOut[r] || live.exprIn[s][r];
+				for (size_t r = 0; r < boolCount; ++r)
+					boolOut[r] = boolOut[r] || live.boolIn[s][r];
+			}
+
+			changed |= transfer(live.exprIn[pc], exprOut, access[pc].exprWrites, access[pc].exprReads);
+			changed |= transfer(live.boolIn[pc], boolOut, access[pc].boolWrites, access[pc].boolReads);
+		}
+	}
+
+	return live;
+}
+
+// Greedy coloring of one register class
+// live[pc] holds the registers live on entry to pc, writes[pc] those pc writes
+static std::vector<size_t> colorRegisters(size_t count, const std::vector<std::vector<bool>>& live,
+										  const std::vector<std::vector<size_t>>& succs,
+										  const std::vector<std::vector<size_t>>& writes)
+{
+	std::vector<size_t> color(count, 0);
+	if (count <= 1)
+		return color;
+
+	// A register written at pc interferes with everything live after pc
+	std::vector<std::vector<size_t>> neighbors(count);
+	std::vector<bool> liveOut(count);
+	for (size_t pc = 0; pc < live.size(); ++pc)
+	{
+		std::fill(liveOut.begin(), liveOut.end(), false);
+		for (auto s : succs[pc])
+			for (size_t r = 0; r < count; ++r)
+				liveOut[r] = liveOut[r] || live[s][r];
+
+		for (auto d : writes[pc])
+		{
+			for (size_t r = 0; r < count; ++r)
+			{
+				if (r != d && liveOut[r])
+				{
+					neighbors[d].push_back(r);
+					neighbors[r].push_back(d);
+				}
+			}
+			for (auto other : writes[pc])
+				if (other != d)
+					neighbors[d].push_back(other);
+		}
+	}
+
+	// Register 0 and registers read before any write (live on entry) get colors of their own
+	std::vector<bool> fixed(count, false);
+	size_t fixedColors = 0;
+	for (size_t r = 0; r < count; ++r)
+	{
+		fixed[r] = r == 0 || (!live.empty() && live[0][r]);
+		if (fixed[r])
+			color[r] = fixedColors++;
+	}
+
+	// Every other register takes the lowest color no earlier neighbor has
+	std::vector<size_t> takenBy(count, 0); // color -> last register that found it taken
+	for (size_t r = 1; r < count; ++r)
+	{
+		if (fixed[r])
+			continue;
+		for (auto nb : neighbors[r])
+			if (nb < r && !fixed[nb])
+				takenBy[color[nb]] = r;
+
+		size_t c = fixedColors;
+		while (takenBy[c] == r)
+			++c;
+		color[r] = c;
+	}
+	return color;
+}
+
+void allocateRegisters(PatternBytecode& bc)
+{
+	const auto& instrs = bc.getInstructions();
+	size_t n = instrs.size();
+	Liveness live = computeLiveness(bc);
+
+	std::vector<std::vector<size_t>> succs(n);
+	std::vector<std::vector<size_t>> exprWrites(n);
+	std::vector<std::vector<size_t>> boolWrites(n);
+	for (size_t pc = 0; pc < n; ++pc)
+	{
+		succs[pc] = getSuccessors(bc, pc);
+		auto access = getRegisterAccess(instrs[pc]);
+		exprWrites[pc].assign(access.exprWrites.begin(), access.exprWrites.end());
+		boolWrites[pc].assign(access.boolWrites.begin(), access.boolWrites.end());
+	}
+
+	auto exprMap = colorRegisters(static_cast<size_t>(bc.getExprRegisterCount()), live.exprIn, succs, exprWrites);
+	auto boolMap = colorRegisters(static_cast<size_t>(bc.getBoolRegisterCount()), live.boolIn, succs, boolWrites);
+	bc.renameRegisters(exprMap, boolMap);
+}
+
+void computeChoicePointSaveSets(PatternBytecode& bc)
+{
+	const auto& instrs = bc.getInstructions();
+	const auto& labelMap = bc.getLabelMap();
+	Liveness live = computeLiveness(bc);
+
+	std::unordered_map<size_t, PatternBytecode::ChoicePointSaveSet> saveSets;
+	for (size_t pc = 0; pc < instrs.size(); ++pc)
+	{
+		const auto& instr = instrs[pc];
+		size_t resume = instrs.size();
+		std::vector<bool> exprLive;
+		if (instr.opcode == Opcode::TRY && !instr.ops.empty())
+		{
+			auto* l = std::get_if<LabelOp>(&instr.ops[0]);
+			auto it = l ? labelMap.find(l->v) : labelMap.end();
+			if (it != labelMap.end())
+				resume = it->second;
+			if (resume < instrs.size())
+				exprLive = live.exprIn[resume];
+		}
+		else if (instr.opcode == Opcode::SPLIT_SEQ && pc + 1 < instrs.size())
+		{
+			// Retrying a split resumes after the SPLIT_SEQ, which rewrites both of its registers
+			resume = pc + 1;
+			exprLive = live.exprIn[resume];
+			for (auto r : getRegisterAccess(instr).exprWrites)
+				if (r < exprLive.size())
+					exprLive[r] = false;
+		}
+		if (resume >= instrs.size())
+			continue; // No save set: the VM falls back to saving every register
+
+		PatternBytecode::ChoicePointSaveSet saveSet;
+		const auto& boolLive = live.boolIn[resume];
+		for (size_t r = 0; r < exprLive.size(); ++r)
+			if (exprLive[r])
+				saveSet.exprRegs.push_back(r);
+		for (size_t r = 0; r < boolLive.size(); ++r)
+			if (boolLive[r])
+				saveSet.boolRegs.push_back(r);
+
+		saveSets.emplace(pc, std::move(saveSet));
+	}
+
+	bc.setChoicePointSaveSets(std::move(saveSets));
+}
+
+}; // namespace PatternMatcher::BytecodeAnalysis
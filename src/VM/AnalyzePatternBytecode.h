@@ -0,0 +1,125 @@
+#pragma once
+
+#include "VM/Opcode.h"
+#include "VM/PatternBytecode.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace PatternMatcher
+{
+
+/// @brief Dataflow analyses over pattern matching bytecode
+namespace BytecodeAnalysis
+{
+	/// @brief Registers read and written by one instruction
+	struct RegisterAccess
+	{
+		std::vector<ExprRegIndex> exprReads;
+		std::vector<ExprRegIndex> exprWrites;
+		std::vector<BoolRegIndex> boolReads;
+		std::vector<BoolRegIndex> boolWrites;
+	};
+
+	/// @brief Get the registers an instruction reads and writes
+	/// @note HALT reads %b0 (the match result returned to the caller)
+	/// @note SPLIT_SEQ both reads and writes its second operand (the remainder)
+	RegisterAccess getRegisterAccess(const PatternBytecode::Instruction& instr);
+
+	/// @brief Get the PCs control can reach directly after the instruction at pc
+	/// @note TRY and RETRY list their alternative as a successor: it is entered by
+	///       backtracking, but with the registers saved when the choice point was made
+	/// @note BEGIN_BLOCK/END_BLOCK labels name scopes and are not successors
+	std::vector<size_t> getSuccessors(const PatternBytecode& bc, size_t pc);
+
+	/// @brief Get the predecessors of every instruction (the inverse of getSuccessors)
+	std::vector<std::vector<size_t>> getPredecessors(const PatternBytecode& bc);
+
+	/// @brief Dominator tree: a dominates b when every path from the entry to b passes through a
+	struct Dominators
+	{
+		static constexpr size_t None = static_cast<size_t>(-1);
+
+		std::vector<size_t> idom; ///< pc -> immediate dominator (the entry is its own, None if unreachable)
+
+		/// @brief Check if a dominates b (every instruction dominates itself)
+		bool dominates(size_t a, size_t b) const;
+	};
+
+	/// @brief Compute the dominator tree of the instructions, with pc 0 as the entry
+	/// @note Alternatives are reached through the TRY/RETRY edges (see getSuccessors), so
+	///       code before a TRY dominates its alternatives, and no alternative dominates another
+	Dominators computeDominators(const PatternBytecode& bc);
+
+	/// @brief How control moves along a control flow graph edge
+	enum class EdgeKind
+	{
+		FallThrough, ///< To the next instruction
+		Jump, ///< To a label: JUMP, a branch, a switch case, or a failure target
+		ChoicePoint ///< From TRY/RETRY to its alternative, entered by backtracking
+	};
+
+	/// @brief Basic block control flow graph
+	/// @note A block starts at pc 0, at every labelled instruction, and after every
+	///       instruction that jumps or does not fall through, so control enters a block
+	///       only at its first instruction and leaves only from its last
+	/// @note Labelled instructions always start a block, so a pass that edits whole
+	///       blocks never moves a label into the middle of one
+	struct ControlFlowGraph
+	{
+		struct Edge
+		{
+			size_t block;
+			EdgeKind kind;
+		};
+
+		struct BasicBlock
+		{
+			size_t begin; ///< First pc
+			size_t end; ///< One past the last pc
+			std::vector<Edge> successors;
+			std::vector<Edge> predecessors;
+		};
+
+		std::vector<BasicBlock> blocks; ///< In pc order; block 0 is the entry
+		std::vector<size_t> blockOf; ///< pc -> block
+
+		/// @brief Get the blocks reachable from the entry, in reverse postorder
+		/// @note Choice-point edges are followed: alternatives are reachable through their TRY
+		std::vector<size_t> reversePostorder() const;
+	};
+
+	/// @brief Build the basic block control flow graph of the instructions
+	ControlFlowGraph buildControlFlowGraph(const PatternBytecode& bc);
+
+	/// @brief Registers live on entry to each instruction
+	struct Liveness
+	{
+		std::vector<std::vector<bool>> exprIn; ///< pc -> expr register -> live
+		std::vector<std::vector<bool>> boolIn; ///< pc -> bool register -> live
+	};
+
+	/// @brief Compute register liveness (backward dataflow to a fixpoint)
+	Liveness computeLiveness(const PatternBytecode& bc);
+
+	/// @brief Map the compiler's registers onto as few registers as their live ranges allow
+	/// @note The compiler hands out a fresh register for every temporary. Two registers
+	///       interfere when one is written while the other is live; the rest share
+	///       registers, colored greedily in allocation order. %e0 and %b0 keep their
+	///       numbers, and a register read before any write is never shared.
+	/// @note Rewrites the instructions and the lexical bindings, and sets the register
+	///       counts to the peak; the counts before allocation stay available as the
+	///       virtual register counts. Run it before computeChoicePointSaveSets.
+	void allocateRegisters(PatternBytecode& bc);
+
+	/// @brief Record, for every TRY and SPLIT_SEQ, the registers its choice point must save
+	/// @note The save set is the set of registers live at the TRY's alternative.
+	///       Because RETRY has an edge to its own alternative, this covers every
+	///       alternative the choice point is later retargeted to.
+	/// @note A SPLIT_SEQ choice point resumes at the next instruction and rewrites
+	///       its own two registers, so those are left out of its save set.
+	void computeChoicePointSaveSets(PatternBytecode& bc);
+
+} // namespace BytecodeAnalysis
+
+} // namespace PatternMatcher
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace PatternMatcher
+{
+/*===========================================================================
+BoolRegisterFile: Bitset Boolean Registers
+
+Boolean registers (%b0, %b1, ...) packed one bit per register. Registers
+%b0..%b63 live in a single inline word; only patterns that need more than 64
+boolean registers spill into heap words. Compiled patterns rarely use more
+than a handful, so reads and writes are a shift and a mask on one word, and
+a full snapshot (taken by every choice point) is a single word copy.
+===========================================================================*/
+
+class BoolRegisterFile
+{
+public:
+	static constexpr size_t InlineRegisters = 64;
+
+	/// @brief Saved contents of the whole file
+	/// @note Only registers beyond the first 64 use the overflow vector
+	struct Snapshot
+	{
+		uint64_t word = 0;
+		std::vector<uint64_t> overflow;
+	};
+
+	/// @brief Size the file to count registers, all false
+	void assign(size_t count_)
+	{
+		count = count_;
+		word = 0;
+		overflow.assign(count > InlineRegisters ? (count - 1) / InlineRegisters : 0, 0);
+	}
+
+	/// @brief Remove all registers
+	void clear() { assign(0); }
+
+	/// @brief Get the number of registers
+	size_t size() const { return count; }
+
+	/// @brief Check if the file has no registers
+	bool empty() const { return count == 0; }
+
+	/// @brief Read register r
+	bool get(size_t r) const
+	{
+		if (r < InlineRegisters)
+			return (word >> r) & 1;
+		return (overflow[r / InlineRegisters - 1] >> (r % InlineRegisters)) & 1;
+	}
+
+	/// @brief Write register r
+	void set(size_t r, bool value)
+	{
+		uint64_t& w = r < InlineRegisters ? word : overflow[r / InlineRegisters - 1];
+		uint64_t bit = uint64_t(1) << (r % InlineRegisters);
+		w = value ? (w | bit) : (w & ~bit);
+	}
+
+	/// @brief Save the whole file (a single word unless there are more than 64 registers)
+	void save(Snapshot& snapshot) const
+	{
+		snapshot.word = word;
+		if (!overflow.empty())
+			snapshot.overflow = overflow;
+	}
+
+	/// @brief Restore the whole file from a snapshot taken with the same size
+	void restore(const Snapshot& snapshot)
+	{
+		word = snapshot.word;
+		if (!overflow.empty())
+			overflow = snapshot.overflow;
+	}
+
+private:
+	size_t count = 0; ///< Number of registers
+	uint64_t word = 0; ///< %b0..%b63
+	std::vector<uint64_t> overflow; ///< %b64 and up, 64 per word
+};
+}; // namespace PatternMatcher
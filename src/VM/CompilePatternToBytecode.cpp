@@ -1,7 +1,11 @@
 #include "VM/CompilePatternToBytecode.h"
+#include "VM/AnalyzePatternBytecode.h"
+#include "VM/NativeCondition.h"
+#include "VM/OptimizePatternBytecode.h"
 
 #include "VM/PatternBytecode.h"
 #include "VM/Opcode.h"
+#include "VM/TestIntrinsics.h"
 
 #include "AST/MExpr.h"
 #include "AST/MExprPatternTools.h"
@@ -9,7 +13,12 @@
 #include "Expr.h"
 #include "Logger.h"
 
+#include <algorithm>
+#include <iterator>
 #include <memory>
+#include <numeric>
+#include <optional>
+#include <set>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -31,11 +40,20 @@ Key Concepts:
 - Alternatives use backtracking (choice points) like Prolog
 
 Register Model:
-- %e0: Always holds the current expression being matched
+- %e0: Holds the input expression on entry
 - %e1, %e2, ...: Temporary registers for subexpressions and bindings
 - %b0: Final match result (true/false)
 - %b1, %b2, ...: Temporary boolean registers
 
+Each subpattern is compiled against a subject register: the input (%e0) at
+the top level, or the register a part was extracted into. Children are
+tested where they already are, so nothing is shuffled through %e0.
+
+Every temporary gets a fresh (virtual) register while compiling. Once the
+pattern is compiled, BytecodeAnalysis::allocateRegisters renames them so
+that temporaries with disjoint live ranges share a register: a wide f[...]
+needs as many registers as are live at once, not one per GET_PART.
+
 Label Model:
 - successLabel: Jump here when pattern matches
 - failLabel: Jump here when pattern fails
@@ -164,7 +182,7 @@ struct CompilerState
 {
 	std::shared_ptr<PatternBytecode> out = std::make_shared<PatternBytecode>();
 
-	// Register allocation counters
+	// Register allocation counters (virtual registers, see Register Model above)
 	// Note: %e0 and %b0 are reserved (see comment above)
 	ExprRegIndex nextExprReg = 1; // Next available expr register
 	BoolRegIndex nextBoolReg = 1; // Next available bool register
@@ -174,6 +192,15 @@ struct CompilerState
 	// This allows detecting repeated variables: f[x_, x_] requires both x's to match
 	LexicalEnvironment lexical;
 
+	// Dense variable slot table (slot -> name, first-occurrence order)
+	// Stored in the bytecode metadata; the VM keeps bindings in per-frame slot arrays
+	std::vector<std::string> variableSlots;
+	std::unordered_map<std::string, size_t> variableSlotMap;
+
+	// Order to try the branches of interchangeable alternatives in (see compileAlternativeChain)
+	// Empty unless PatternBytecode::reorderAlternatives is compiling the pattern again
+	PatternBytecode::AlternativeOrder alternativeOrder;
+
 	// Stack of currently open blocks (for proper nesting)
 	// Used by beginBlock/endBlock to ensure balanced BEGIN_BLOCK/END_BLOCK
 	std::vector<Label> blockStack;
@@ -182,6 +209,14 @@ struct CompilerState
 	// Used to distinguish: __Integer matching 5 (check head) vs {__Integer} (check parts)
 	bool matchingExtractedSequence = false;
 
+	// Number of SPLIT_SEQ instructions emitted so far
+	// A split leaves a choice point behind, so checks compiled after one must backtrack into it
+	size_t splitCount = 0;
+
+	// Number of choice point instructions (TRY, SPLIT_SEQ) emitted so far
+	// Code emitted after one may run while its choice point is live (see needsFrame)
+	size_t choicePointCount = 0;
+
 	//=========================//
 	//  Register allocators
 	//=========================//
@@ -192,6 +227,15 @@ struct CompilerState
 	/// Allocate a new boolean register (%b1, %b2, ...)
 	BoolRegIndex allocBoolReg() { return nextBoolReg++; }
 
+	/// Get the slot of a pattern variable, assigning the next slot on first use
+	size_t internVariable(const std::string& varName)
+	{
+		auto [it, inserted] = variableSlotMap.try_emplace(varName, variableSlots.size());
+		if (inserted)
+			variableSlots.push_back(varName);
+		return it->second;
+	}
+
 	//=========================//
 	//  Label management
 	//=========================//
@@ -282,11 +326,46 @@ struct CompilerState
 			emit(Opcode::JUMP, { OpLabel(successLabel) });
 		}
 	}
+
+	//=========================//
+	//  Split backtracking
+	//=========================//
+
+	/// Get the failure label for a check that follows sub-patterns compiled since splitMark
+	///
+	/// If those sub-patterns emitted a SPLIT_SEQ, its choice point may still be live,
+	/// so failing must backtrack into it (to try the next split) instead of jumping
+	/// out of the pattern. backtrackLabel is then created on demand and must be
+	/// bound to a FAIL with emitBacktrackHandler.
+	///
+	/// Example: {a__, b__} /; Length[{a}] == 2 matching {1,2,3}
+	///   The condition fails for a=Sequence[1] and must retry a=Sequence[1,2]
+	Label failLabelAfter(size_t splitMark, Label failLabel, std::optional<Label>& backtrackLabel)
+	{
+		if (splitCount == splitMark)
+			return failLabel;
+		if (!backtrackLabel)
+			backtrackLabel = newLabel();
+		return *backtrackLabel;
+	}
+
+	/// Bind the label requested by failLabelAfter (if any) to a FAIL
+	/// Must be emitted where control does not fall through
+	void emitBacktrackHandler(const std::optional<Label>& backtrackLabel)
+	{
+		if (backtrackLabel)
+		{
+			bindLabel(*backtrackLabel);
+			emit(Opcode::FAIL, {});
+		}
+	}
 };
 
 // Forward declaration for mutual recursion
-static void compilePatternRec(CompilerState& st, std::shared_ptr<MExpr> mexpr, Label successLabel, Label failLabel,
-							  bool isTopLevel);
+static void compilePatternRec(CompilerState& st, std::shared_ptr<MExpr> mexpr, ExprRegIndex subject,
+							  Label successLabel, Label failLabel, bool isTopLevel);
+static bool containsSequencePattern(std::shared_ptr<MExpr> mexpr);
+static bool isNullableSequencePattern(std::shared_ptr<MExpr> mexpr);
 
 /*---------------------------------------------------------------------------
 compileLiteralMatch: Match against constant values
@@ -296,19 +375,19 @@ Compiles patterns like:
 - "hello" (string literal)
 - Pi (symbol literal)
 
-Generated code:
+Generated code (subject in %e0):
   MATCH_LITERAL %e0, <literal>, failLabel
   [JUMP successLabel]  ; if isTopLevel=true
 
 If the input doesn't match the literal, jumps to failLabel.
 Otherwise continues (or jumps to success if top-level).
 ---------------------------------------------------------------------------*/
-static void compileLiteralMatch(CompilerState& st, std::shared_ptr<MExpr> mexpr, Label successLabel, Label failLabel,
-								bool isTopLevel)
+static void compileLiteralMatch(CompilerState& st, std::shared_ptr<MExpr> mexpr, ExprRegIndex subject,
+								Label successLabel, Label failLabel, bool isTopLevel)
 {
-	// Compare input expression (%e0) with literal
+	// Compare the subject with the literal
 	// On mismatch, MATCH_LITERAL jumps to failLabel
-	st.emit(Opcode::MATCH_LITERAL, { OpExprReg(0), OpImm(mexpr->getExpr()), OpLabel(failLabel) });
+	st.emit(Opcode::MATCH_LITERAL, { OpExprReg(subject), OpImm(mexpr->getExpr()), OpLabel(failLabel) });
 
 	// If top-level, explicitly jump to success
 	// If nested, fall through to next pattern check
@@ -329,15 +408,15 @@ Generated code for _Integer:
 
 The blank itself (_) always matches, so it just jumps to success.
 ---------------------------------------------------------------------------*/
-static void compileBlank(CompilerState& st, std::shared_ptr<MExprNormal> mexpr, Label successLabel, Label failLabel,
-						 bool isTopLevel)
+static void compileBlank(CompilerState& st, std::shared_ptr<MExprNormal> mexpr, ExprRegIndex subject,
+						 Label successLabel, Label failLabel, bool isTopLevel)
 {
 	if (mexpr->length() == 1)
 	{
 		// Blank[f] → check if Head[input] == f
 		// Example: _Integer checks if Head[5] == Integer
 		Expr headExpr = mexpr->part(1)->getExpr();
-		st.emit(Opcode::MATCH_HEAD, { OpExprReg(0), OpImm(headExpr), OpLabel(failLabel) });
+		st.emit(Opcode::MATCH_HEAD, { OpExprReg(subject), OpImm(headExpr), OpLabel(failLabel) });
 	}
 	// Otherwise, Blank[] (plain _) matches any single expression - no check needed
 
@@ -364,21 +443,20 @@ Two cases:
    - If not equal, fail
    - Then compile the subpattern
 
-Example bytecode for x_Integer (first occurrence):
-  MATCH_HEAD %e0, Integer, innerFail    ; Check if integer
-  MOVE %e3, %e0                         ; Copy value to register
-  BIND_VAR "Global`x", %e3              ; Runtime binding
+Example bytecode for x_Integer (first occurrence, subject in %e2):
+  MATCH_HEAD %e2, Integer, innerFail    ; Check if integer
+  BIND_VAR "Global`x", %e2              ; Runtime binding (x is tracked in %e2)
   JUMP successLabel                     ; Success
 innerFail:
   JUMP outerFail                        ; Subpattern failed
 
-Example bytecode for second x in f[x_, x_]:
-  SAMEQ %b1, %e3, %e0                   ; Compare with first x
+Example bytecode for second x in f[x_, x_] (subject in %e3):
+  SAMEQ %b1, %e2, %e3                   ; Compare with first x
   BRANCH_FALSE %b1, outerFail           ; Must match!
   [continue with subpattern]
 ---------------------------------------------------------------------------*/
-static void compilePattern(CompilerState& st, std::shared_ptr<MExprNormal> mexpr, Label successLabel, Label outerFail,
-						   bool isTopLevel)
+static void compilePattern(CompilerState& st, std::shared_ptr<MExprNormal> mexpr, ExprRegIndex subject,
+						   Label successLabel, Label outerFail, bool isTopLevel)
 {
 	// Pattern structure: Pattern[symbol, subpattern]
 	// Example: Pattern[x, Blank[Integer]] represents x_Integer
@@ -413,18 +491,18 @@ static void compilePattern(CompilerState& st, std::shared_ptr<MExprNormal> mexpr
 
 		// Unbound case: bind the variable and continue
 		st.bindLabel(bindLabel);
-		st.emit(Opcode::MOVE, { OpExprReg(storedReg), OpExprReg(0) }); // Store current value
-		st.emit(Opcode::BIND_VAR, { OpIdent(lexName), OpExprReg(0) }); // Bind in frame
+		st.emit(Opcode::MOVE, { OpExprReg(storedReg), OpExprReg(subject) }); // Store current value
+		st.emit(Opcode::BIND_VAR, { OpIdent(lexName), OpExprReg(subject) }); // Bind in frame
 		st.emit(Opcode::JUMP, { OpLabel(continueLabel) });
 
 		// Bound case: compare values
 		st.bindLabel(compareLabel);
-		st.emit(Opcode::SAMEQ, { OpBoolReg(b), OpExprReg(storedReg), OpExprReg(0) });
+		st.emit(Opcode::SAMEQ, { OpBoolReg(b), OpExprReg(storedReg), OpExprReg(subject) });
 		st.emit(Opcode::BRANCH_FALSE, { OpBoolReg(b), OpLabel(outerFail) });
 
 		// Continue with subpattern matching
 		st.bindLabel(continueLabel);
-		compilePatternRec(st, subp, successLabel, outerFail, false);
+		compilePatternRec(st, subp, subject, successLabel, outerFail, false);
 		st.emitSuccessJumpIfTopLevel(successLabel, isTopLevel);
 	}
 	else
@@ -439,15 +517,15 @@ static void compilePattern(CompilerState& st, std::shared_ptr<MExprNormal> mexpr
 
 		// Compile the subpattern (e.g., _Integer)
 		// If it fails, jump to innerFail (not outerFail directly)
-		compilePatternRec(st, subp, successLabel, innerFail, false);
+		compilePatternRec(st, subp, subject, successLabel, innerFail, false);
 
 		// Subpattern succeeded. Now bind the variable
-		ExprRegIndex bindReg = st.allocExprReg();
-		st.emit(Opcode::MOVE, { OpExprReg(bindReg), OpExprReg(0) }); // Copy value
-		st.lexical.bind(lexName, bindReg); // Track for repeated variable detection
+		// The subject register keeps the value for repeated variable checks
+		st.lexical.bind(lexName, subject); // Track for repeated variable detection
+		st.internVariable(lexName); // Assign the variable its runtime slot
 
 		// Runtime binding: Store in frame for later retrieval
-		st.emit(Opcode::BIND_VAR, { OpIdent(lexName), OpExprReg(bindReg) });
+		st.emit(Opcode::BIND_VAR, { OpIdent(lexName), OpExprReg(subject) });
 
 		// Success path: jump to success or past failure handler
 		Label afterFailHandler = st.newLabel();
@@ -464,6 +542,373 @@ static void compilePattern(CompilerState& st, std::shared_ptr<MExprNormal> mexpr
 	}
 }
 
+/*---------------------------------------------------------------------------
+Dispatch key of an alternative: the head, and for literals the value, of
+every expression it can match. Blanks, sequences and nested alternatives
+are unkeyed: they can match anything.
+---------------------------------------------------------------------------*/
+struct AlternativeKey
+{
+	enum class Kind
+	{
+		None, // Can match any expression
+		Head, // Matches only expressions with this head
+		Literal // Matches only this value (whose head is head)
+	};
+
+	Kind kind = Kind::None;
+	std::optional<Expr> head;
+	std::optional<Expr> literal;
+};
+
+static AlternativeKey getAlternativeKey(std::shared_ptr<MExpr> mexpr)
+{
+	using Kind = AlternativeKey::Kind;
+
+	if (mexpr->literalQ() || mexpr->symbolQ())
+	{
+		// Compiled to MATCH_LITERAL
+		Expr value = mexpr->getExpr();
+		return { Kind::Literal, value.head(), value };
+	}
+	if (!mexpr->normalQ())
+		return {};
+
+	auto norm = std::static_pointer_cast<MExprNormal>(mexpr);
+	if (MExprIsPattern(mexpr))
+		return getAlternativeKey(norm->part(2)); // x_h
+	if (MExprIsPatternTest(mexpr) || MExprIsCondition(mexpr))
+		return getAlternativeKey(norm->part(1)); // p?test, p /; cond
+	if (MExprIsBlank(mexpr))
+	{
+		if (norm->length() == 1)
+			return { Kind::Head, norm->part(1)->getExpr(), std::nullopt }; // _h
+		return {};
+	}
+	if (MExprIsAlternatives(mexpr) || MExprIsBlankSequence(mexpr) || MExprIsBlankNullSequence(mexpr))
+		return {};
+	if (norm->getHead()->symbolQ())
+		return { Kind::Head, norm->getHead()->getExpr(), std::nullopt }; // Checked by MATCH_SHAPE(_MIN)
+	return {};
+}
+
+/// Strip what only narrows a pattern: x_h → _h, p?test → p, p /; cond → p
+static std::shared_ptr<MExpr> stripRestrictions(std::shared_ptr<MExpr> mexpr)
+{
+	while (MExprIsPattern(mexpr) || MExprIsPatternTest(mexpr) || MExprIsCondition(mexpr))
+	{
+		auto norm = std::static_pointer_cast<MExprNormal>(mexpr);
+		mexpr = MExprIsPattern(mexpr) ? norm->part(2) : norm->part(1);
+	}
+	return mexpr;
+}
+
+/// Check if an argument pattern always matches exactly one argument (conservative: false unless certain)
+static bool matchesOneArgument(std::shared_ptr<MExpr> mexpr)
+{
+	mexpr = stripRestrictions(mexpr);
+	if (MExprIsAlternatives(mexpr))
+	{
+		const auto& children = std::static_pointer_cast<MExprNormal>(mexpr)->getChildren();
+		return std::all_of(children.begin(), children.end(), matchesOneArgument);
+	}
+	if (MExprIsBlank(mexpr))
+		return true;
+	for (const char* sequenceHead : { "BlankSequence", "BlankNullSequence", "PatternSequence", "Repeated",
+									  "RepeatedNull", "Optional", "OrderlessPatternSequence", "Longest", "Shortest",
+									  "Except" })
+	{
+		if (mexpr->hasHead(sequenceHead))
+			return false;
+	}
+	return getAlternativeKey(mexpr).kind != AlternativeKey::Kind::None;
+}
+
+/// Fewest and most arguments an argument list matches (no most if an argument may match a sequence)
+static std::pair<size_t, std::optional<size_t>> argumentCountRange(std::shared_ptr<MExprNormal> mexpr)
+{
+	size_t fewest = 0;
+	bool bounded = true;
+	for (const auto& child : mexpr->getChildren())
+	{
+		if (matchesOneArgument(child))
+		{
+			fewest++;
+			continue;
+		}
+		bounded = false;
+		if (containsSequencePattern(child) && !isNullableSequencePattern(child))
+			fewest++; // x__ matches at least one
+	}
+	return { fewest, bounded ? std::optional<size_t>(fewest) : std::nullopt };
+}
+
+/*---------------------------------------------------------------------------
+Detect if no expression can match both patterns: their keys differ in head
+or literal, or they are f[...] patterns whose argument counts cannot meet
+(f[_] and f[_, __]) or whose arguments at some position are disjoint
+(f[1, x_] and f[2, x_]). Conservative: false unless certain.
+---------------------------------------------------------------------------*/
+static bool disjointPatterns(std::shared_ptr<MExpr> a, std::shared_ptr<MExpr> b)
+{
+	using Kind = AlternativeKey::Kind;
+
+	a = stripRestrictions(a);
+	b = stripRestrictions(b);
+	if (MExprIsAlternatives(a) || MExprIsAlternatives(b))
+	{
+		auto alternatives = std::static_pointer_cast<MExprNormal>(MExprIsAlternatives(a) ? a : b);
+		auto other = MExprIsAlternatives(a) ? b : a;
+		const auto& children = alternatives->getChildren();
+		return std::all_of(children.begin(), children.end(),
+						   [&](const auto& alternative) { return disjointPatterns(alternative, other); });
+	}
+
+	auto keyA = getAlternativeKey(a);
+	auto keyB = getAlternativeKey(b);
+	if (keyA.kind == Kind::None || keyB.kind == Kind::None)
+		return false;
+	if (!keyA.head->sameQ(*keyB.head))
+		return true;
+	if (keyA.kind == Kind::Literal || keyB.kind == Kind::Literal)
+		return keyA.kind == keyB.kind && !keyA.literal->sameQ(*keyB.literal);
+
+	// Same head: f[...] patterns (not _f) can still differ in arity or in an argument
+	if (MExprIsBlank(a) || MExprIsBlank(b))
+		return false;
+	auto normA = std::static_pointer_cast<MExprNormal>(a);
+	auto normB = std::static_pointer_cast<MExprNormal>(b);
+	auto [fewestA, mostA] = argumentCountRange(normA);
+	auto [fewestB, mostB] = argumentCountRange(normB);
+	if ((mostA && fewestB > *mostA) || (mostB && fewestA > *mostB))
+		return true;
+	if (!mostA || !mostB)
+		return false; // Argument positions do not line up around a sequence
+	for (size_t i = 1; i <= normA->length(); ++i)
+	{
+		if (disjointPatterns(normA->part(static_cast<mint>(i)), normB->part(static_cast<mint>(i))))
+			return true;
+	}
+	return false;
+}
+
+/// Collect the lexical names of the variables a pattern binds
+static void collectPatternVariables(std::shared_ptr<MExpr> mexpr, std::set<std::string>& names)
+{
+	if (!mexpr->normalQ())
+		return;
+
+	auto norm = std::static_pointer_cast<MExprNormal>(mexpr);
+	if (MExprIsPattern(mexpr))
+		names.insert(std::static_pointer_cast<MExprSymbol>(norm->part(1))->getLexicalName());
+	collectPatternVariables(norm->getHead(), names);
+	for (const auto& child : norm->getChildren())
+		collectPatternVariables(child, names);
+}
+
+/// State shared by the code emitted for one Alternatives pattern
+struct AlternativesContext
+{
+	std::shared_ptr<MExprNormal> mexpr;
+	ExprRegIndex subject;
+	Label successLabel; // Every alternative jumps here on success
+	Label failLabel; // Where matching goes once no alternative is left
+	LexicalEnvironment savedLexical; // Lexical environment before the alternatives
+	std::unordered_set<std::string> varNames; // Variables of every compiled alternative
+};
+
+/*---------------------------------------------------------------------------
+Detect if candidate alternatives can be tried in any order: no two of them
+can match the same expression, so at most one matches whatever the order,
+and they bind the same variables.
+---------------------------------------------------------------------------*/
+static bool interchangeableAlternatives(const AlternativesContext& alts, const std::vector<mint>& candidates)
+{
+	std::set<std::string> firstVariables;
+	collectPatternVariables(alts.mexpr->part(candidates[0]), firstVariables);
+	for (size_t i = 0; i < candidates.size(); ++i)
+	{
+		auto alternative = alts.mexpr->part(candidates[i]);
+		std::set<std::string> variables;
+		collectPatternVariables(alternative, variables);
+		if (variables != firstVariables)
+			return false;
+		for (size_t j = 0; j < i; ++j)
+		{
+			if (!disjointPatterns(alternative, alts.mexpr->part(candidates[j])))
+				return false;
+		}
+	}
+	return true;
+}
+
+/*---------------------------------------------------------------------------
+Try candidate alternatives (1-based parts, in order) with a TRY/RETRY/TRUST
+chain. A single candidate needs no choice point; none fails right away.
+
+Interchangeable candidates are tried in the order st.alternativeOrder gives
+(pattern order by default) and the chain is recorded in the bytecode, so the
+VM can count which branch matches and PatternBytecode::reorderAlternatives
+can put the most frequent one first.
+---------------------------------------------------------------------------*/
+static void compileAlternativeChain(CompilerState& st, AlternativesContext& alts, std::vector<mint> candidates)
+{
+	if (candidates.empty())
+	{
+		st.emit(Opcode::JUMP, { OpLabel(alts.failLabel) });
+		return;
+	}
+
+	bool interchangeable = candidates.size() > 1 && !st.matchingExtractedSequence
+		&& interchangeableAlternatives(alts, candidates);
+	auto orderIt = st.alternativeOrder.find(alts.mexpr.get());
+	if (interchangeable && orderIt != st.alternativeOrder.end())
+	{
+		const auto& order = orderIt->second;
+		auto rank = [&](mint part) { return std::find(order.begin(), order.end(), part) - order.begin(); };
+		std::stable_sort(candidates.begin(), candidates.end(), [&](mint a, mint b) { return rank(a) < rank(b); });
+	}
+
+	// Create labels for each alternative's entry point
+	std::vector<Label> altLabels;
+	for (size_t i = 0; i < candidates.size(); ++i)
+	{
+		altLabels.push_back(st.newLabel());
+	}
+
+	if (interchangeable)
+	{
+		st.out->addAlternativeChain({ alts.mexpr.get(), candidates, { altLabels.begin() + 1, altLabels.end() } });
+	}
+
+	if (candidates.size() > 1)
+	{
+		// TRY saves the current state (registers, frames, trail)
+		// and records where to jump on backtrack (altLabels[1])
+		st.emit(Opcode::TRY, { OpLabel(altLabels[1]) });
+		st.choicePointCount++;
+	}
+
+	for (size_t i = 0; i < candidates.size(); ++i)
+	{
+		bool isLast = i + 1 == candidates.size();
+
+		// Restore lexical environment for independent variable tracking
+		st.lexical.restore(alts.savedLexical);
+
+		st.bindLabel(altLabels[i]);
+		if (i > 0 && !isLast)
+		{
+			// RETRY updates the choice point's next alternative pointer
+			st.emit(Opcode::RETRY, { OpLabel(altLabels[i + 1]) });
+		}
+		else if (i > 0)
+		{
+			// TRUST commits to the last alternative - no more backtracking possible
+			st.emit(Opcode::TRUST, {});
+		}
+
+		// The last alternative fails the whole pattern; the others backtrack
+		Label altFail = isLast ? alts.failLabel : st.newLabel();
+		compilePatternRec(st, alts.mexpr->part(candidates[i]), alts.subject, alts.successLabel, altFail, true);
+
+		// Add variables from this alternative to the union
+		alts.varNames = LexicalEnvironment::unionSets(alts.varNames, st.lexical.getNewVariables(alts.savedLexical));
+
+		if (!isLast)
+		{
+			st.bindLabel(altFail);
+			st.emit(Opcode::FAIL, {}); // Backtrack to the next alternative
+		}
+	}
+}
+
+/// Merge two ascending lists of alternatives, keeping the pattern's order
+static std::vector<mint> mergeAlternatives(const std::vector<mint>& a, const std::vector<mint>& b)
+{
+	std::vector<mint> merged;
+	merged.reserve(a.size() + b.size());
+	std::merge(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(merged));
+	return merged;
+}
+
+/*---------------------------------------------------------------------------
+Match candidates that are all literals with one hashed MATCH_LITERAL_SET.
+Literals bind nothing, so which of them matches does not matter.
+---------------------------------------------------------------------------*/
+static void compileLiteralSet(CompilerState& st, AlternativesContext& alts, const std::vector<mint>& candidates)
+{
+	PatternBytecode::LiteralSet set;
+	for (auto alt : candidates)
+		set.values.push_back(alts.mexpr->part(alt)->getExpr());
+
+	mint setIndex = st.out->addLiteralSet(std::move(set));
+	st.emit(Opcode::MATCH_LITERAL_SET, { OpExprReg(alts.subject), OpImm(setIndex), OpLabel(alts.failLabel) });
+	st.emit(Opcode::JUMP, { OpLabel(alts.successLabel) });
+}
+
+/*---------------------------------------------------------------------------
+Dispatch the candidates sharing one head on their literal value, when at
+least two of them are literals (0 | 1 | 2 | _Integer?EvenQ). Each value's
+case tries its literals and the head's non-literal alternatives in order.
+Only literals (f[__] | 0 | 1 | 2) need a single MATCH_LITERAL_SET.
+---------------------------------------------------------------------------*/
+static void compileLiteralDispatch(CompilerState& st, AlternativesContext& alts,
+								   const std::vector<AlternativeKey>& keys, const std::vector<mint>& candidates)
+{
+	std::vector<Expr> values;
+	std::vector<std::vector<mint>> byValue;
+	std::vector<mint> others;
+	for (auto alt : candidates)
+	{
+		const auto& key = keys[alt - 1];
+		if (key.kind != AlternativeKey::Kind::Literal)
+		{
+			others.push_back(alt);
+			continue;
+		}
+		auto it = std::find_if(values.begin(), values.end(), [&](const Expr& v) { return v.sameQ(*key.literal); });
+		if (it == values.end())
+		{
+			values.push_back(*key.literal);
+			byValue.emplace_back();
+			it = values.end() - 1;
+		}
+		byValue[it - values.begin()].push_back(alt);
+	}
+
+	size_t literalCount = candidates.size() - others.size();
+	if (literalCount < 2)
+	{
+		compileAlternativeChain(st, alts, candidates);
+		return;
+	}
+	if (others.empty())
+	{
+		compileLiteralSet(st, alts, candidates);
+		return;
+	}
+
+	PatternBytecode::SwitchTable table;
+	std::vector<Label> caseLabels;
+	for (const auto& value : values)
+	{
+		caseLabels.push_back(st.newLabel());
+		table.cases.emplace_back(value, caseLabels.back());
+	}
+	Label defaultLabel = st.newLabel();
+	mint tableIndex = st.out->addSwitchTable(std::move(table));
+	st.emit(Opcode::SWITCH_ON_LITERAL, { OpExprReg(alts.subject), OpImm(tableIndex), OpLabel(defaultLabel) });
+
+	for (size_t i = 0; i < values.size(); ++i)
+	{
+		st.bindLabel(caseLabels[i]);
+		compileAlternativeChain(st, alts, mergeAlternatives(byValue[i], others));
+	}
+	st.bindLabel(defaultLabel);
+	compileAlternativeChain(st, alts, others);
+}
+
 /*---------------------------------------------------------------------------
 compileAlternatives: Match Any of Several Patterns (Backtracking)
 
@@ -499,12 +944,30 @@ L_p3:
   [compile p3]
   JUMP success OR fail     ; Either matches or whole pattern fails
 
+When alternatives are keyed by head (f[__] | g[_] | h[_, _] | 0 | 1), a
+SWITCH_ON_HEAD first jumps to the chain of the alternatives that can match
+the subject's head, so a mismatch costs one table scan instead of a choice
+point and a failed attempt per alternative:
+
+  SWITCH_ON_HEAD %e0, #0, L_default
+    f → L_f, g → L_g, h → L_h, Integer → L_int
+L_f:   [chain of f[__] and the unkeyed alternatives]
+  ...
+L_int: SWITCH_ON_LITERAL %e0, #1, L_default   ; 0 → [0], 1 → [1]
+L_default:
+  [chain of the unkeyed alternatives]   ; JUMP fail if there are none
+
+Unkeyed alternatives (_, x_ /; ..., sequences) join every chain in pattern
+order, so the first alternative to match is the same as without dispatch.
+Alternatives made only of literals ("GET" | "PUT" | "POST") compile to a
+single MATCH_LITERAL_SET, a hashed membership test.
+
 NOTE: Each alternative gets a fresh lexical environment.
 In x_Integer | x_Real, both alternatives have their own "x" binding.
 This prevents the second alternative from thinking x is already bound.
 ---------------------------------------------------------------------------*/
-static void compileAlternatives(CompilerState& st, std::shared_ptr<MExprNormal> mexpr, Label successLabel,
-								Label failLabel, bool isTopLevel)
+static void compileAlternatives(CompilerState& st, std::shared_ptr<MExprNormal> mexpr, ExprRegIndex subject,
+								Label successLabel, Label failLabel, bool isTopLevel)
 {
 	size_t numAlts = mexpr->length();
 
@@ -519,10 +982,14 @@ static void compileAlternatives(CompilerState& st, std::shared_ptr<MExprNormal>
 	if (numAlts == 1)
 	{
 		auto alt = mexpr->part(1);
-		compilePatternRec(st, alt, successLabel, failLabel, isTopLevel);
+		compilePatternRec(st, alt, subject, successLabel, failLabel, isTopLevel);
 		return;
 	}
 
+	// Create a local success label for alternatives
+	// Each alternative jumps here on success, then we handle isTopLevel
+	Label localSuccess = st.newLabel();
+
 	// Save the lexical environment before processing alternatives
 	// Each alternative needs a fresh start - variables bound in one
 	// alternative shouldn't affect variable detection in others
@@ -531,9 +998,8 @@ static void compileAlternatives(CompilerState& st, std::shared_ptr<MExprNormal>
 	// - First alternative adds x → %e3 to st.lexical
 	// - Without restoration, second alternative sees x as "repeated variable"
 	// - With restoration, second alternative treats x as "first occurrence"
-	auto savedLexical = st.lexical.snapshot();
-
-	// Track ALL variables that appear in ANY alternative
+	//
+	// varNames tracks ALL variables that appear in ANY alternative
 	// These might be referenced by subsequent patterns, so we need LOAD_VAR for them.
 	//
 	// A variable referenced after alternatives can be:
@@ -549,98 +1015,79 @@ static void compileAlternatives(CompilerState& st, std::shared_ptr<MExprNormal>
 	// - Second alternative y_Real matches 2.5, binds y=2.5 (x remains unbound)
 	// - Second x_ matches 3 (no SAMEQ check since x is unbound)
 	// - Pattern succeeds
-	//
-	// We need LOAD_VAR for any variable that might be referenced later.
-	std::unordered_set<std::string> allVarNames;
+	AlternativesContext alts { mexpr, subject, localSuccess, failLabel, st.lexical.snapshot(), {} };
 
-	// Create labels for each alternative's entry point
-	std::vector<Label> altLabels;
-	for (size_t i = 0; i < numAlts; ++i)
+	std::vector<AlternativeKey> keys;
+	std::vector<mint> unkeyed;
+	for (size_t i = 1; i <= numAlts; ++i)
 	{
-		altLabels.push_back(st.newLabel());
+		keys.push_back(getAlternativeKey(mexpr->part(static_cast<mint>(i))));
+		if (keys.back().kind == AlternativeKey::Kind::None)
+			unkeyed.push_back(static_cast<mint>(i));
 	}
 
-	// Create a local success label for alternatives
-	// Each alternative jumps here on success, then we handle isTopLevel
-	Label localSuccess = st.newLabel();
+	bool allLiterals = std::all_of(keys.begin(), keys.end(),
+								   [](const AlternativeKey& key) { return key.kind == AlternativeKey::Kind::Literal; });
 
-	// ============================================================
-	// FIRST ALTERNATIVE: Create choice point with TRY
-	// ============================================================
-	// TRY saves the current state (registers, frames, trail)
-	// and records where to jump on backtrack (altLabels[1])
-	st.emit(Opcode::TRY, { OpLabel(altLabels[1]) });
-	st.bindLabel(altLabels[0]);
-	{
-		auto firstAlt = mexpr->part(1);
-		Label firstFail = st.newLabel();
-
-		// Compile first alternative as top-level (must jump to success)
-		compilePatternRec(st, firstAlt, localSuccess, firstFail, true);
+	std::vector<mint> all(numAlts);
+	std::iota(all.begin(), all.end(), 1);
 
-		// Initialize with variables from first alternative
-		allVarNames = st.lexical.getNewVariables(savedLexical);
-
-		// If first alternative fails, trigger backtracking
-		st.bindLabel(firstFail);
-		st.emit(Opcode::FAIL, {}); // VM will restore state and jump to altLabels[1]
+	// An extracted Sequence[...] has no head of its own to dispatch on
+	if (st.matchingExtractedSequence || unkeyed.size() == numAlts)
+	{
+		compileAlternativeChain(st, alts, all);
 	}
-
-	// ============================================================
-	// MIDDLE ALTERNATIVES: Update choice point with RETRY
-	// ============================================================
-	// For numAlts=2, this loop doesn't run (goes straight to TRUST)
-	// For numAlts=3+, this handles alternatives 2, 3, ..., numAlts-1
-	for (size_t i = 1; i < numAlts - 1; ++i)
+	else if (allLiterals)
 	{
-		// Restore lexical environment for independent variable tracking
-		st.lexical.restore(savedLexical);
-
-		st.bindLabel(altLabels[i]);
-		// RETRY updates the choice point's next alternative pointer
-		// If this alternative fails, backtrack to altLabels[i+1]
-		st.emit(Opcode::RETRY, { OpLabel(altLabels[i + 1]) });
-
-		auto alt = mexpr->part(static_cast<mint>(i + 1));
-		Label altFail = st.newLabel();
-
-		compilePatternRec(st, alt, localSuccess, altFail, true);
-
-		// Add variables from this alternative to the union
-		auto altVars = st.lexical.getNewVariables(savedLexical);
-		allVarNames = LexicalEnvironment::unionSets(allVarNames, altVars);
-
-		st.bindLabel(altFail);
-		st.emit(Opcode::FAIL, {}); // Backtrack to next alternative
+		// "GET" | "PUT" | "POST", 1 | 2 | ... | 500: one hashed lookup
+		compileLiteralSet(st, alts, all);
 	}
+	else
+	{
+		// Group the keyed alternatives by head, in order of first appearance
+		std::vector<Expr> heads;
+		std::vector<std::vector<mint>> byHead;
+		for (size_t i = 0; i < numAlts; ++i)
+		{
+			if (keys[i].kind == AlternativeKey::Kind::None)
+				continue;
+			auto it = std::find_if(heads.begin(), heads.end(), [&](const Expr& h) { return h.sameQ(*keys[i].head); });
+			if (it == heads.end())
+			{
+				heads.push_back(*keys[i].head);
+				byHead.emplace_back();
+				it = heads.end() - 1;
+			}
+			byHead[it - heads.begin()].push_back(static_cast<mint>(i + 1));
+		}
 
-	// ============================================================
-	// LAST ALTERNATIVE: Remove choice point with TRUST
-	// ============================================================
-	// TRUST commits to this alternative - no more backtracking possible
-	// If this fails, the entire pattern fails (no more alternatives to try)
-	st.lexical.restore(savedLexical); // Restore environment one last time
+		PatternBytecode::SwitchTable table;
+		std::vector<Label> caseLabels;
+		for (const auto& head : heads)
+		{
+			caseLabels.push_back(st.newLabel());
+			table.cases.emplace_back(head, caseLabels.back());
+		}
+		Label defaultLabel = st.newLabel();
+		mint tableIndex = st.out->addSwitchTable(std::move(table));
+		st.emit(Opcode::SWITCH_ON_HEAD, { OpExprReg(subject), OpImm(tableIndex), OpLabel(defaultLabel) });
 
-	st.bindLabel(altLabels[numAlts - 1]);
-	st.emit(Opcode::TRUST, {}); // Remove choice point from stack
-	{
-		auto lastAlt = mexpr->part(static_cast<mint>(numAlts));
-		// Last alternative: on success → jump to successLabel
-		//                   on failure → jump to failLabel (no backtracking)
-		compilePatternRec(st, lastAlt, localSuccess, failLabel, true);
+		for (size_t i = 0; i < heads.size(); ++i)
+		{
+			st.bindLabel(caseLabels[i]);
+			compileLiteralDispatch(st, alts, keys, mergeAlternatives(byHead[i], unkeyed));
+		}
+		st.bindLabel(defaultLabel);
+		compileAlternativeChain(st, alts, unkeyed);
 	}
 
-	// Add variables from last alternative to the union
-	auto lastAltVars = st.lexical.getNewVariables(savedLexical);
-	allVarNames = LexicalEnvironment::unionSets(allVarNames, lastAltVars);
-
 	// ============================================================
 	// LOCAL SUCCESS HANDLER
 	// ============================================================
 	st.bindLabel(localSuccess);
 
 	// Restore lexical environment
-	st.lexical.restore(savedLexical);
+	st.lexical.restore(alts.savedLexical);
 
 	// Emit LOAD_VAR for variables that might be referenced by subsequent patterns
 	// This handles cases like f[x_Integer | y_Real, x_] where x might or might not be bound
@@ -649,10 +1096,10 @@ static void compileAlternatives(CompilerState& st, std::shared_ptr<MExprNormal>
 	// - "x_Integer | x_Real" with isTopLevel=true: No LOAD_VAR (no subsequent patterns)
 	// - "f[x_Integer | x_Real, x_]": Emit LOAD_VAR for x (appears in alternatives + referenced later)
 	// - "f[x_Integer | y_Real, x_]": Emit LOAD_VAR for x and y (both might be referenced later)
-	if (!isTopLevel && !allVarNames.empty())
+	if (!isTopLevel && !alts.varNames.empty())
 	{
 		// Emit LOAD_VAR for each variable that appeared in any alternative
-		for (const auto& varName : allVarNames)
+		for (const auto& varName : alts.varNames)
 		{
 			// Allocate a fresh register for tracking this binding in subsequent patterns
 			ExprRegIndex trackingReg = st.allocExprReg();
@@ -671,6 +1118,34 @@ static void compileAlternatives(CompilerState& st, std::shared_ptr<MExprNormal>
 	st.emitSuccessJumpIfTopLevel(successLabel, isTopLevel);
 }
 
+/*---------------------------------------------------------------------------
+emitSuccessAndBacktrackHandler: Finish a Pattern That Checks After Its Child
+
+Emits the success jump (top-level) and, when the check after the child
+routes to a backtrack label (see CompilerState::failLabelAfter), the FAIL
+it names. Nested patterns jump over the handler:
+
+  JUMP successLabel | JUMP L_continue
+L_backtrack:
+  FAIL                     ; Retry the child's last sequence split
+L_continue:
+---------------------------------------------------------------------------*/
+static void emitSuccessAndBacktrackHandler(CompilerState& st, Label successLabel, bool isTopLevel,
+										   const std::optional<Label>& backtrackFail)
+{
+	if (!backtrackFail)
+	{
+		st.emitSuccessJumpIfTopLevel(successLabel, isTopLevel);
+		return;
+	}
+
+	Label continueLabel = st.newLabel();
+	st.emit(Opcode::JUMP, { OpLabel(isTopLevel ? successLabel : continueLabel) });
+	st.emitBacktrackHandler(backtrackFail);
+	if (!isTopLevel)
+		st.bindLabel(continueLabel);
+}
+
 /*---------------------------------------------------------------------------
 compilePatternTest: Match Pattern with Test Function
 
@@ -684,30 +1159,46 @@ Strategy:
 2. Apply the test function to the matched value
 3. If test returns True, continue; otherwise jump to failLabel
 
-Generated code for x_Integer?EvenQ:
+Generated code for x_Integer?EvenQ against subject %e0:
   ; First match _Integer and bind x
-  MATCH_HEAD %e0, Integer, innerFail
-  MOVE %e3, %e0
-  BIND_VAR "Global`x", %e3
+  MATCH_HEAD %e0, Integer, failLabel
+  BIND_VAR "Global`x", %e0
 
-  ; Then apply test
-  APPLY_TEST %e0, EvenQ, failLabel
+  ; Then apply test to the same subject (natively: EvenQ is an intrinsic)
+  TEST_INTRINSIC %e0, 3, EvenQ, failLabel
 
   ; Success
   JUMP successLabel (if top-level)
 
 Note: Test is applied AFTER pattern matching, not before.
+Tests without an intrinsic (see TestIntrinsics.h) compile to APPLY_TEST.
 ---------------------------------------------------------------------------*/
-static void compilePatternTest(CompilerState& st, std::shared_ptr<MExprNormal> mexprNormal, Label successLabel,
-							   Label failLabel, bool isTopLevel)
+static void compilePatternTest(CompilerState& st, std::shared_ptr<MExprNormal> mexprNormal, ExprRegIndex subject,
+							   Label successLabel, Label failLabel, bool isTopLevel)
 {
 	auto pvalMExpr = mexprNormal->part(1);
-	compilePatternRec(st, pvalMExpr, successLabel, failLabel, false);
-
-	auto testMExpr = mexprNormal->part(2);
-	st.emit(Opcode::APPLY_TEST, { OpExprReg(0), OpImm(testMExpr->getExpr()), OpLabel(failLabel) });
+	size_t splitMark = st.splitCount;
+	compilePatternRec(st, pvalMExpr, subject, successLabel, failLabel, false);
+
+	// A failed test retries the pattern's sequence splits, if it has any
+	std::optional<Label> backtrackFail;
+	Label testFail = st.failLabelAfter(splitMark, failLabel, backtrackFail);
+
+	// Common predicates run natively; an extracted Sequence[...] is tested by the kernel,
+	// which splices it into the test's arguments
+	Expr test = mexprNormal->part(2)->getExpr();
+	auto intrinsic = st.matchingExtractedSequence ? std::nullopt : getTestIntrinsic(test);
+	if (intrinsic)
+	{
+		st.emit(Opcode::TEST_INTRINSIC, { OpExprReg(subject), OpImm(static_cast<mint>(*intrinsic)), OpImm(test),
+										  OpLabel(testFail) });
+	}
+	else
+	{
+		st.emit(Opcode::APPLY_TEST, { OpExprReg(subject), OpImm(test), OpLabel(testFail) });
+	}
 
-	st.emitSuccessJumpIfTopLevel(successLabel, isTopLevel);
+	emitSuccessAndBacktrackHandler(st, successLabel, isTopLevel, backtrackFail);
 }
 
 /*---------------------------------------------------------------------------
@@ -721,16 +1212,20 @@ Compiles patterns like:
 Strategy:
 1. Compile the base pattern (e.g., x_Integer)
 2. Evaluate the condition expression in the current binding context
+   (EVAL_NATIVE_CONDITION when NativeCondition can compile it, else EVAL_CONDITION)
 3. If condition evaluates to True, continue; otherwise jump to failLabel
 
-Generated code for x_Integer /; x > 0:
+Generated code for x_Integer /; x > 0 against subject %e0:
   ; First match _Integer and bind x
-  MATCH_HEAD %e0, Integer, innerFail
-  MOVE %e3, %e0
-  BIND_VAR "Global`x", %e3
+  MATCH_HEAD %e0, Integer, failLabel
+  BIND_VAR "Global`x", %e0
+
+  ; Then evaluate condition (natively: x > 0 is plain arithmetic)
+  EVAL_NATIVE_CONDITION x > 0, 0, failLabel
 
-  ; Then evaluate condition
-  EVAL_CONDITION x > 0, failLabel
+A condition the kernel evaluates (EVAL_CONDITION x_ /; PrimeQ[x], 0, failLabel)
+runs in Block[{x = value}, PrimeQ[x]]. The block only assigns the variables
+the condition references; the VM prebuilds it and fills in their values.
 
   ; Success
   JUMP successLabel (if top-level)
@@ -738,21 +1233,76 @@ Generated code for x_Integer /; x > 0:
 Note: Condition is evaluated AFTER pattern matching and binding.
 The condition expression can reference variables bound by the pattern.
 ---------------------------------------------------------------------------*/
-static void compileCondition(CompilerState& st, std::shared_ptr<MExprNormal> mexprNormal, Label successLabel,
-							 Label failLabel, bool isTopLevel)
+// Record the pattern variables a condition references (anywhere in it, heads included)
+// Their symbols come from the condition itself, so nothing is parsed at runtime
+static void collectConditionVariables(const CompilerState& st, const std::shared_ptr<MExpr>& mexpr,
+									  PatternBytecode::Condition& condition)
+{
+	if (mexpr->symbolQ())
+	{
+		auto it = st.variableSlotMap.find(std::static_pointer_cast<MExprSymbol>(mexpr)->getLexicalName());
+		if (it != st.variableSlotMap.end()
+			&& std::find(condition.slots.begin(), condition.slots.end(), it->second) == condition.slots.end())
+		{
+			condition.slots.push_back(it->second);
+			condition.symbols.push_back(mexpr->getExpr());
+		}
+		return;
+	}
+	if (!mexpr->normalQ())
+		return;
+	auto mexprNormal = std::static_pointer_cast<MExprNormal>(mexpr);
+	collectConditionVariables(st, mexprNormal->getHead(), condition);
+	for (const auto& child : mexprNormal->getChildren())
+		collectConditionVariables(st, child, condition);
+}
+
+static void compileCondition(CompilerState& st, std::shared_ptr<MExprNormal> mexprNormal, ExprRegIndex subject,
+							 Label successLabel, Label failLabel, bool isTopLevel)
 {
 	// Condition[pattern, test]
 	auto pvalMExpr = mexprNormal->part(1); // The pattern
 	auto condMExpr = mexprNormal->part(2); // The condition expression
 
 	// First compile the pattern
-	compilePatternRec(st, pvalMExpr, successLabel, failLabel, false);
+	size_t splitMark = st.splitCount;
+	compilePatternRec(st, pvalMExpr, subject, successLabel, failLabel, false);
+
+	// A false condition retries the pattern's sequence splits, if it has any
+	// Example: {a__, b__} /; Length[{a}] == 2 backtracks until a has two elements
+	std::optional<Label> backtrackFail;
+	Label conditionFail = st.failLabelAfter(splitMark, failLabel, backtrackFail);
 
 	// Then evaluate the condition
 	// The condition can reference pattern variables that were just bound
-	st.emit(Opcode::EVAL_CONDITION, { OpImm(condMExpr->getExpr()), OpLabel(failLabel) });
+	PatternBytecode::Condition condition { condMExpr->getExpr(), {}, {}, std::nullopt };
+	collectConditionVariables(st, condMExpr, condition);
+
+	// Arithmetic and comparisons over them run natively (see NativeCondition.h)
+	condition.native = NativeCondition::compile(condMExpr, [&](const std::string& name) -> std::optional<size_t> {
+		auto it = st.variableSlotMap.find(name);
+		if (it == st.variableSlotMap.end())
+			return std::nullopt;
+		return it->second;
+	});
+	if (condition.native)
+	{
+		// The native program reads every variable the condition references, in its own order
+		std::vector<Expr> symbols;
+		for (auto slot : condition.native->getSlots())
+		{
+			auto it = std::find(condition.slots.begin(), condition.slots.end(), slot);
+			symbols.push_back(condition.symbols[it - condition.slots.begin()]);
+		}
+		condition.slots = condition.native->getSlots();
+		condition.symbols = std::move(symbols);
+	}
 
-	st.emitSuccessJumpIfTopLevel(successLabel, isTopLevel);
+	Opcode opcode = condition.native ? Opcode::EVAL_NATIVE_CONDITION : Opcode::EVAL_CONDITION;
+	mint index = st.out->addCondition(std::move(condition));
+	st.emit(opcode, { OpImm(condMExpr->getExpr()), OpImm(index), OpLabel(conditionFail) });
+
+	emitSuccessAndBacktrackHandler(st, successLabel, isTopLevel, backtrackFail);
 }
 
 /*---------------------------------------------------------------------------
@@ -778,8 +1328,8 @@ Generated bytecode for __Integer:
   MATCH_SEQ_HEADS %e0, 1, %e1, Integer, Lfail  ; All must be Integer
   JUMP Lsuccess
 ---------------------------------------------------------------------------*/
-static void compileBlankSequence(CompilerState& st, std::shared_ptr<MExprNormal> mexpr, Label successLabel,
-								 Label failLabel, bool isTopLevel, bool isNullable)
+static void compileBlankSequence(CompilerState& st, std::shared_ptr<MExprNormal> mexpr, ExprRegIndex subject,
+								 Label successLabel, Label failLabel, bool isTopLevel, bool isNullable)
 {
 	// BlankSequence has two contexts:
 	// 1. Standalone: __Integer matches expr if Head[expr] == Integer
@@ -796,15 +1346,15 @@ static void compileBlankSequence(CompilerState& st, std::shared_ptr<MExprNormal>
 			// Context: matching against extracted Sequence[...] from compound pattern
 			// Example: {__Integer} → check all parts are Integer
 			ExprRegIndex lenReg = st.allocExprReg();
-			st.emit(Opcode::GET_LENGTH, { OpExprReg(lenReg), OpExprReg(0) });
+			st.emit(Opcode::GET_LENGTH, { OpExprReg(lenReg), OpExprReg(subject) });
 			st.emit(Opcode::MATCH_SEQ_HEADS,
-					{ OpExprReg(0), OpImm(1), OpExprReg(lenReg), OpImm(headExpr), OpLabel(failLabel) });
+					{ OpExprReg(subject), OpImm(1), OpExprReg(lenReg), OpImm(headExpr), OpLabel(failLabel) });
 		}
 		else
 		{
 			// Context: standalone pattern
 			// Example: __Integer matching 5 → check Head[5] == Integer
-			st.emit(Opcode::MATCH_HEAD, { OpExprReg(0), OpImm(headExpr), OpLabel(failLabel) });
+			st.emit(Opcode::MATCH_HEAD, { OpExprReg(subject), OpImm(headExpr), OpLabel(failLabel) });
 		}
 	}
 	// For untyped __ or ___, just succeed - they match any expression
@@ -849,6 +1399,243 @@ static std::vector<size_t> findSequencePositions(std::shared_ptr<MExprNormal> me
 	return positions;
 }
 
+/*---------------------------------------------------------------------------
+Detect if a sequence pattern can match zero elements (___ or x___)
+---------------------------------------------------------------------------*/
+static bool isNullableSequencePattern(std::shared_ptr<MExpr> mexpr)
+{
+	return MExprIsBlankNullSequence(mexpr)
+		|| (MExprIsPattern(mexpr) && MExprIsBlankNullSequence(std::static_pointer_cast<MExprNormal>(mexpr)->part(2)));
+}
+
+/*---------------------------------------------------------------------------
+Detect if a pattern binds any variable (contains a Pattern[...])
+---------------------------------------------------------------------------*/
+static bool bindsVariables(std::shared_ptr<MExpr> mexpr)
+{
+	if (mexpr->getKind() != MExpr::Kind::Normal)
+		return false;
+	if (MExprIsPattern(mexpr))
+		return true;
+
+	auto norm = std::static_pointer_cast<MExprNormal>(mexpr);
+	if (bindsVariables(norm->getHead()))
+		return true;
+	for (const auto& child : norm->getChildren())
+	{
+		if (bindsVariables(child))
+			return true;
+	}
+	return false;
+}
+
+/*---------------------------------------------------------------------------
+Detect if matching a pattern can create choice points
+(alternatives, or several sequences in one argument list)
+---------------------------------------------------------------------------*/
+static bool createsChoicePoints(std::shared_ptr<MExpr> mexpr)
+{
+	if (mexpr->getKind() != MExpr::Kind::Normal)
+		return false;
+
+	auto norm = std::static_pointer_cast<MExprNormal>(mexpr);
+	if (MExprIsAlternatives(mexpr) && norm->length() > 1)
+		return true;
+	if (findSequencePositions(norm).size() > 1)
+		return true;
+
+	if (createsChoicePoints(norm->getHead()))
+		return true;
+	for (const auto& child : norm->getChildren())
+	{
+		if (createsChoicePoints(child))
+			return true;
+	}
+	return false;
+}
+
+/*---------------------------------------------------------------------------
+needsFrame: Decide if a compound pattern gets its own block
+
+A block (BEGIN_BLOCK/END_BLOCK) gives the pattern a frame of its own, so
+bindings made after a choice point are dropped with the frame when the VM
+backtracks past it: the first binding of a variable in a frame is not
+trailed. That only matters if the pattern binds variables while a choice
+point is live, one left by code emitted before it or one it creates
+itself. Otherwise the pattern binds straight into the enclosing frame, and
+data patterns like {{_, _}, {_, _}} match without any frame traffic.
+---------------------------------------------------------------------------*/
+static bool needsFrame(const CompilerState& st, std::shared_ptr<MExprNormal> mexpr)
+{
+	return bindsVariables(mexpr) && (st.choicePointCount > 0 || createsChoicePoints(mexpr));
+}
+
+/*---------------------------------------------------------------------------
+Match one argument of a compound pattern
+
+Matches the argument in the register it was extracted into. Sequence
+arguments are matched as extracted Sequence[...]s.
+---------------------------------------------------------------------------*/
+static void compileArgument(CompilerState& st, std::shared_ptr<MExpr> argPattern, ExprRegIndex argReg,
+							Label successLabel, Label failLabel, bool isSequence)
+{
+	bool savedFlag = st.matchingExtractedSequence;
+	st.matchingExtractedSequence = isSequence;
+	compilePatternRec(st, argPattern, argReg, successLabel, failLabel, false);
+	st.matchingExtractedSequence = savedFlag;
+}
+
+/*---------------------------------------------------------------------------
+compileNormalWithSplits: Match Patterns with Several Sequence Variables
+
+Handles patterns like:
+- {a__, b__}        → a={1}, b={2,3} (first split that matches)
+- {a__, 3, b__}     → a={1,2}, b={4}
+- {___, x_, ___, x_, ___}
+- {a__Integer, b__Real}
+
+Which parts each sequence takes is not determined by the lengths alone, so
+the parts after the fixed prefix are kept as a remainder Sequence[...] and
+each sequence but the last splits it with SPLIT_SEQ. A split tries the
+shortest length first and leaves a choice point for the longer ones; any
+later failure executes FAIL and retries the most recent split. Fixed
+patterns between two sequences are matched at the start of the remainder,
+and the last sequence takes everything but the fixed patterns at the end.
+
+Lengths are pruned at both ends: a sequence takes at least its own minimum
+(1 for __, 0 for ___) and leaves at least the minimum of everything after it.
+
+Generated code for {a__, b__}:
+
+L_block:
+  BEGIN_BLOCK L_block
+  MATCH_SHAPE_MIN %e0, List, 2, innerFail  ; Sum of the minimum lengths
+  MAKE_SEQUENCE %e1, %e0, 1, -1       ; Remainder: every part
+  SPLIT_SEQ %e2, %e1, 1, 1            ; a takes 1..Length-1 parts, shortest first
+  [match a__ against %e2, failing to backtrackFail]
+  MAKE_SEQUENCE %e3, %e1, 1, -1       ; b takes the rest
+  [match b__ against %e3, failing to backtrackFail]
+  END_BLOCK L_block
+  JUMP afterFailHandler
+innerFail:
+  JUMP outerFail                      ; No split made yet
+backtrackFail:
+  FAIL                                ; Retry the last split
+afterFailHandler:
+---------------------------------------------------------------------------*/
+static void compileNormalWithSplits(CompilerState& st, std::shared_ptr<MExprNormal> mexpr, ExprRegIndex subject,
+									Label successLabel, Label failLabel, bool isTopLevel,
+									const std::vector<size_t>& seqPositions)
+{
+	size_t argsLen = mexpr->length();
+	size_t firstSeq = seqPositions.front();
+	size_t lastSeq = seqPositions.back();
+
+	// minAfter[i]: fewest parts the arguments after the i-th can match (minAfter[0] is the total)
+	std::vector<mint> minAfter(argsLen + 1, 0);
+	for (size_t i = argsLen; i >= 1; --i)
+	{
+		auto arg = mexpr->part(static_cast<mint>(i));
+		bool isSequence = std::find(seqPositions.begin(), seqPositions.end(), i) != seqPositions.end();
+		minAfter[i - 1] = minAfter[i] + (isSequence && isNullableSequencePattern(arg) ? 0 : 1);
+	}
+
+	// Bindings get a frame of their own only if backtracking can observe them (see needsFrame)
+	bool hasFrame = needsFrame(st, mexpr);
+	Label blockLabel = st.newLabel();
+	if (hasFrame)
+		st.beginBlock(blockLabel);
+	Label innerFail = st.newLabel();
+	size_t splitMark = st.splitCount;
+	std::optional<Label> backtrackFail;
+
+	auto headExpr = mexpr->getHead()->getExpr();
+	st.emit(Opcode::MATCH_SHAPE_MIN, { OpExprReg(subject), OpImm(headExpr), OpImm(minAfter[0]), OpLabel(innerFail) });
+
+	// ========================================
+	// FIXED PREFIX: Match patterns before the first sequence
+	// ========================================
+	for (size_t i = 1; i < firstSeq; ++i)
+	{
+		ExprRegIndex argReg = st.allocExprReg();
+		st.emit(Opcode::GET_PART, { OpExprReg(argReg), OpExprReg(subject), OpImm(static_cast<mint>(i)) });
+		compileArgument(st, mexpr->part(static_cast<mint>(i)), argReg, successLabel,
+						st.failLabelAfter(splitMark, innerFail, backtrackFail), false);
+	}
+
+	// Remainder: Sequence of the parts not matched yet
+	ExprRegIndex restReg = st.allocExprReg();
+	st.emit(Opcode::MAKE_SEQUENCE,
+			{ OpExprReg(restReg), OpExprReg(subject), OpImm(static_cast<mint>(firstSeq)), OpImm(static_cast<mint>(-1)) });
+
+	// ========================================
+	// SPLITS: Every sequence but the last takes a prefix of the remainder
+	// ========================================
+	for (size_t j = 0; j + 1 < seqPositions.size(); ++j)
+	{
+		size_t seqPos = seqPositions[j];
+		size_t nextSeqPos = seqPositions[j + 1];
+		auto seqPattern = mexpr->part(static_cast<mint>(seqPos));
+
+		ExprRegIndex seqReg = st.allocExprReg();
+		mint minLen = isNullableSequencePattern(seqPattern) ? 0 : 1;
+		st.emit(Opcode::SPLIT_SEQ, { OpExprReg(seqReg), OpExprReg(restReg), OpImm(minLen), OpImm(minAfter[seqPos]) });
+		st.splitCount++;
+		st.choicePointCount++;
+
+		compileArgument(st, seqPattern, seqReg, successLabel,
+						st.failLabelAfter(splitMark, innerFail, backtrackFail), true);
+
+		// Fixed patterns up to the next sequence start the remainder
+		size_t gap = nextSeqPos - seqPos - 1;
+		for (size_t t = 1; t <= gap; ++t)
+		{
+			ExprRegIndex argReg = st.allocExprReg();
+			st.emit(Opcode::GET_PART, { OpExprReg(argReg), OpExprReg(restReg), OpImm(static_cast<mint>(t)) });
+			compileArgument(st, mexpr->part(static_cast<mint>(seqPos + t)), argReg, successLabel,
+							st.failLabelAfter(splitMark, innerFail, backtrackFail), false);
+		}
+		if (gap > 0)
+		{
+			ExprRegIndex nextRestReg = st.allocExprReg();
+			st.emit(Opcode::MAKE_SEQUENCE, { OpExprReg(nextRestReg), OpExprReg(restReg),
+											  OpImm(static_cast<mint>(gap + 1)), OpImm(static_cast<mint>(-1)) });
+			restReg = nextRestReg;
+		}
+	}
+
+	// ========================================
+	// LAST SEQUENCE: Everything but the fixed patterns after it
+	// ========================================
+	size_t afterSeq = argsLen - lastSeq;
+	ExprRegIndex seqReg = st.allocExprReg();
+	st.emit(Opcode::MAKE_SEQUENCE, { OpExprReg(seqReg), OpExprReg(restReg), OpImm(static_cast<mint>(1)),
+									  OpImm(-static_cast<mint>(afterSeq + 1)) });
+	compileArgument(st, mexpr->part(static_cast<mint>(lastSeq)), seqReg, successLabel,
+					st.failLabelAfter(splitMark, innerFail, backtrackFail), true);
+
+	for (size_t t = 1; t <= afterSeq; ++t)
+	{
+		ExprRegIndex argReg = st.allocExprReg();
+		st.emit(Opcode::GET_PART,
+				{ OpExprReg(argReg), OpExprReg(restReg), OpImm(-static_cast<mint>(afterSeq - t + 1)) });
+		compileArgument(st, mexpr->part(static_cast<mint>(lastSeq + t)), argReg, successLabel,
+						st.failLabelAfter(splitMark, innerFail, backtrackFail), false);
+	}
+
+	if (hasFrame)
+		st.endBlock(blockLabel);
+
+	Label afterFailHandler = st.newLabel();
+	st.emit(Opcode::JUMP, { OpLabel(isTopLevel ? successLabel : afterFailHandler) });
+
+	st.bindLabel(innerFail);
+	st.emit(Opcode::JUMP, { OpLabel(failLabel) });
+	st.emitBacktrackHandler(backtrackFail);
+
+	st.bindLabel(afterFailHandler);
+}
+
 /*---------------------------------------------------------------------------
 compileNormalWithSequences: Match Patterns with Sequence Variables
 
@@ -870,18 +1657,17 @@ Example for {a_, b__, c_} matching {1,2,3,4}:
   - seqLen = 4 - 1 - 1 = 2
   - Result: a=1, b={2,3}, c=4
 
-LIMITATION: Only handles SINGLE sequence. Multiple sequences ({a__, b__})
-require split enumeration with backtracking - deferred to future work.
+Several sequences ({a__, b__}) need split enumeration with backtracking,
+see compileNormalWithSplits.
 ---------------------------------------------------------------------------*/
-static void compileNormalWithSequences(CompilerState& st, std::shared_ptr<MExprNormal> mexpr, Label successLabel,
-									   Label failLabel, bool isTopLevel, const std::vector<size_t>& seqPositions)
+static void compileNormalWithSequences(CompilerState& st, std::shared_ptr<MExprNormal> mexpr, ExprRegIndex subject,
+									   Label successLabel, Label failLabel, bool isTopLevel,
+									   const std::vector<size_t>& seqPositions)
 {
-	// Only handle single sequence (most common case)
+	// Multiple sequences like {a__, b__} need split backtracking
 	if (seqPositions.size() != 1)
 	{
-		// Multiple sequences like {a__, b__} need split backtracking
-		PM_WARNING("Multiple sequence patterns not yet supported");
-		st.emit(Opcode::JUMP, { OpLabel(failLabel) });
+		compileNormalWithSplits(st, mexpr, subject, successLabel, failLabel, isTopLevel, seqPositions);
 		return;
 	}
 
@@ -889,31 +1675,30 @@ static void compileNormalWithSequences(CompilerState& st, std::shared_ptr<MExprN
 	size_t beforeSeq = seqPos - 1; // Fixed patterns before sequence
 	size_t afterSeq = mexpr->length() - seqPos; // Fixed patterns after sequence
 
+	// Bindings get a frame of their own only if backtracking can observe them (see needsFrame)
+	bool hasFrame = needsFrame(st, mexpr);
 	Label blockLabel = st.newLabel();
-	st.beginBlock(blockLabel);
+	if (hasFrame)
+		st.beginBlock(blockLabel);
 	Label innerFail = st.newLabel();
 
-	// Check head
-	auto headExpr = mexpr->getHead()->getExpr();
-	st.emit(Opcode::MATCH_HEAD, { OpExprReg(0), OpImm(headExpr), OpLabel(innerFail) });
+	// Arguments can split sequences of their own, e.g. {{a__, b__}, c__};
+	// once one has, later failures backtrack into the split
+	size_t splitMark = st.splitCount;
+	std::optional<Label> backtrackFail;
 
 	// Determine if sequence is nullable (___ vs __)
 	auto seqPattern = mexpr->part(static_cast<mint>(seqPos));
-	bool seqIsNullable = MExprIsBlankNullSequence(seqPattern)
-		|| (MExprIsPattern(seqPattern)
-			&& MExprIsBlankNullSequence(std::static_pointer_cast<MExprNormal>(seqPattern)->part(2)));
+	bool seqIsNullable = isNullableSequencePattern(seqPattern);
 
-	// Compute minimum total length
+	// Check head and minimum total length
+	auto headExpr = mexpr->getHead()->getExpr();
 	mint minTotalLen = static_cast<mint>(beforeSeq + afterSeq + (seqIsNullable ? 0 : 1));
-	st.emit(Opcode::MATCH_MIN_LENGTH, { OpExprReg(0), OpImm(minTotalLen), OpLabel(innerFail) });
-
-	// Save original expression for part extraction
-	ExprRegIndex origReg = st.allocExprReg();
-	st.emit(Opcode::MOVE, { OpExprReg(origReg), OpExprReg(0) });
+	st.emit(Opcode::MATCH_SHAPE_MIN, { OpExprReg(subject), OpImm(headExpr), OpImm(minTotalLen), OpLabel(innerFail) });
 
 	// Get total length for computing sequence range
 	ExprRegIndex lengthReg = st.allocExprReg();
-	st.emit(Opcode::GET_LENGTH, { OpExprReg(lengthReg), OpExprReg(origReg) });
+	st.emit(Opcode::GET_LENGTH, { OpExprReg(lengthReg), OpExprReg(subject) });
 
 	// ========================================
 	// FORWARD PASS: Match patterns before sequence
@@ -923,12 +1708,10 @@ static void compileNormalWithSequences(CompilerState& st, std::shared_ptr<MExprN
 		auto argPattern = mexpr->part(static_cast<mint>(i));
 		ExprRegIndex argReg = st.allocExprReg();
 
-		st.emit(Opcode::GET_PART, { OpExprReg(argReg), OpExprReg(origReg), OpImm(static_cast<mint>(i)) });
-		st.emit(Opcode::MOVE, { OpExprReg(0), OpExprReg(argReg) });
-
-		compilePatternRec(st, argPattern, successLabel, innerFail, false);
+		st.emit(Opcode::GET_PART, { OpExprReg(argReg), OpExprReg(subject), OpImm(static_cast<mint>(i)) });
 
-		st.emit(Opcode::MOVE, { OpExprReg(0), OpExprReg(origReg) });
+		compilePatternRec(st, argPattern, argReg, successLabel, st.failLabelAfter(splitMark, innerFail, backtrackFail),
+						  false);
 	}
 
 	// ========================================
@@ -949,7 +1732,7 @@ static void compileNormalWithSequences(CompilerState& st, std::shared_ptr<MExprN
 	if (afterSeq == 0)
 	{
 		// Trailing sequence: extract from seqStartIdx to length
-		st.emit(Opcode::MAKE_SEQUENCE, { OpExprReg(seqReg), OpExprReg(origReg), OpImm(seqStartIdx), OpExprReg(lengthReg) });
+		st.emit(Opcode::MAKE_SEQUENCE, { OpExprReg(seqReg), OpExprReg(subject), OpImm(seqStartIdx), OpExprReg(lengthReg) });
 	}
 	else
 	{
@@ -960,20 +1743,17 @@ static void compileNormalWithSequences(CompilerState& st, std::shared_ptr<MExprN
 		// Pattern: negative_index = -(afterSeq + 1)
 		mint seqEndNegative = -static_cast<mint>(afterSeq + 1);
 
-		st.emit(Opcode::MAKE_SEQUENCE, { OpExprReg(seqReg), OpExprReg(origReg), OpImm(seqStartIdx), OpImm(seqEndNegative) });
+		st.emit(Opcode::MAKE_SEQUENCE, { OpExprReg(seqReg), OpExprReg(subject), OpImm(seqStartIdx), OpImm(seqEndNegative) });
 	}
 
 	// Match the sequence pattern against extracted sequence
-	st.emit(Opcode::MOVE, { OpExprReg(0), OpExprReg(seqReg) });
-
 	// Set flag: we're matching against an extracted Sequence[...]
 	bool savedFlag = st.matchingExtractedSequence;
 	st.matchingExtractedSequence = true;
-	compilePatternRec(st, seqPattern, successLabel, innerFail, false);
+	compilePatternRec(st, seqPattern, seqReg, successLabel, st.failLabelAfter(splitMark, innerFail, backtrackFail),
+					  false);
 	st.matchingExtractedSequence = savedFlag;
 
-	st.emit(Opcode::MOVE, { OpExprReg(0), OpExprReg(origReg) });
-
 	// ========================================
 	// BACKWARD PASS: Match patterns after sequence
 	// ========================================
@@ -1008,15 +1788,14 @@ static void compileNormalWithSequences(CompilerState& st, std::shared_ptr<MExprN
 		// GET_PART with negative index: -1 = last, -2 = second-to-last, etc.
 		mint negativeIdx = -static_cast<mint>(offsetFromEnd);
 
-		st.emit(Opcode::GET_PART, { OpExprReg(argReg), OpExprReg(origReg), OpImm(negativeIdx) });
-		st.emit(Opcode::MOVE, { OpExprReg(0), OpExprReg(argReg) });
-
-		compilePatternRec(st, argPattern, successLabel, innerFail, false);
+		st.emit(Opcode::GET_PART, { OpExprReg(argReg), OpExprReg(subject), OpImm(negativeIdx) });
 
-		st.emit(Opcode::MOVE, { OpExprReg(0), OpExprReg(origReg) });
+		compilePatternRec(st, argPattern, argReg, successLabel, st.failLabelAfter(splitMark, innerFail, backtrackFail),
+						  false);
 	}
 
-	st.endBlock(blockLabel);
+	if (hasFrame)
+		st.endBlock(blockLabel);
 
 	Label afterFailHandler = st.newLabel();
 	if (!isTopLevel)
@@ -1030,6 +1809,7 @@ static void compileNormalWithSequences(CompilerState& st, std::shared_ptr<MExprN
 
 	st.bindLabel(innerFail);
 	st.emit(Opcode::JUMP, { OpLabel(failLabel) });
+	st.emitBacktrackHandler(backtrackFail);
 
 	st.bindLabel(afterFailHandler);
 }
@@ -1043,32 +1823,24 @@ Compiles patterns like:
 - Plus[x_, y_] (matches Plus with 2 arguments)
 
 Strategy:
-1. Check argument count (length)
-2. Check head (e.g., f, List, Plus)
-3. For each argument, recursively match its pattern
-4. Restore %e0 between argument matches (since recursive calls modify it)
+1. Check argument count and head (e.g., f, List, Plus) with one MATCH_SHAPE
+2. For each argument, extract it and match its pattern against that register
 
-Generated code for f[x_, y_]:
+Generated code for f[x_, y_] against subject %e0:
 
 L_block:
-  BEGIN_BLOCK L_block         ; Create scope for temps
-  MATCH_LENGTH %e0, 2, innerFail
-  MATCH_HEAD %e0, f, innerFail
-  MOVE %e1, %e0               ; Save original expression
+  BEGIN_BLOCK L_block         ; Only if needsFrame (not for f[x_, y_] alone)
+  MATCH_SHAPE %e0, f, 2, innerFail
 
   ; Match first argument (x_)
-  GET_PART %e2, %e0, 1        ; Extract f[...][1]
-  MOVE %e0, %e2               ; Put in %e0 for matching
-  [compile x_ with innerFail as fail label]
-  MOVE %e0, %e1               ; Restore original
+  GET_PART %e1, %e0, 1        ; Extract f[...][1]
+  [compile x_ against %e1 with innerFail as fail label]
 
   ; Match second argument (y_)
-  GET_PART %e3, %e0, 2        ; Extract f[...][2]
-  MOVE %e0, %e3
-  [compile y_ with innerFail as fail label]
-  MOVE %e0, %e1               ; Restore original
+  GET_PART %e2, %e0, 2        ; Extract f[...][2]
+  [compile y_ against %e2 with innerFail as fail label]
 
-  END_BLOCK L_block           ; All matched
+  END_BLOCK L_block           ; All matched (only if needsFrame)
   JUMP afterFailHandler
 
 innerFail:
@@ -1077,75 +1849,74 @@ innerFail:
 afterFailHandler:
   ; Continue...
 ---------------------------------------------------------------------------*/
-static void compileNormal(CompilerState& st, std::shared_ptr<MExprNormal> mexpr, Label successLabel, Label outerFail,
-						  bool isTopLevel)
+static void compileNormal(CompilerState& st, std::shared_ptr<MExprNormal> mexpr, ExprRegIndex subject,
+						  Label successLabel, Label outerFail, bool isTopLevel)
 {
 	// Check if pattern contains sequence patterns (__, ___)
 	auto seqPositions = findSequencePositions(mexpr);
 	if (!seqPositions.empty())
 	{
 		// Delegate to sequence handler
-		compileNormalWithSequences(st, mexpr, successLabel, outerFail, isTopLevel, seqPositions);
+		compileNormalWithSequences(st, mexpr, subject, successLabel, outerFail, isTopLevel, seqPositions);
 		return;
 	}
 
 	size_t argsLen = mexpr->length();
 
-	// Create a block for temporary registers
-	// This creates a runtime frame for variable bindings within this pattern
+	// Create a block (a runtime frame for variable bindings within this pattern)
+	// if backtracking can observe the bindings (see needsFrame)
+	bool hasFrame = needsFrame(st, mexpr);
 	Label blockLabel = st.newLabel();
-	st.beginBlock(blockLabel);
+	if (hasFrame)
+		st.beginBlock(blockLabel);
 
 	// Local failure label - unwinds this block before propagating failure
 	Label innerFail = st.newLabel();
 
-	// --- 1. Check argument count ---
-	// Example: f[x_, y_] requires exactly 2 arguments
-	st.emit(Opcode::MATCH_LENGTH, { OpExprReg(0), OpImm(argsLen), OpLabel(innerFail) });
-
 	mint partStart = 0; // Which part index to start matching from
 
-	// --- 2. Check head equality ---
+	// --- 1. Check argument count and head ---
+	// Example: f[x_, y_] requires exactly 2 arguments and head f
 	auto headMExpr = mexpr->getHead();
 	if (headMExpr->symbolQ())
 	{
 		// Head is a symbol (e.g., f, List, Plus)
-		// We can check it directly with MATCH_HEAD
+		// MATCH_SHAPE checks it together with the argument count
 		Expr headExpr = headMExpr->getExpr();
-		st.emit(Opcode::MATCH_HEAD, { OpExprReg(0), OpImm(headExpr), OpLabel(innerFail) });
+		st.emit(Opcode::MATCH_SHAPE,
+				{ OpExprReg(subject), OpImm(headExpr), OpImm(static_cast<mint>(argsLen)), OpLabel(innerFail) });
 
 		// Skip matching part(0) since we already checked the head
 		partStart = 1;
 	}
-	// If head is not a symbol (rare), we'd need to match it as part(0)
-
-	// --- 3. Save %e0 before recursive matching ---
-	// Each child pattern compilation uses %e0, so we need to preserve the original
-	ExprRegIndex rSaved = st.allocExprReg();
-	st.emit(Opcode::MOVE, { OpExprReg(rSaved), OpExprReg(0) });
+	else
+	{
+		// If head is not a symbol (rare), it is matched as part(0)
+		st.emit(Opcode::MATCH_LENGTH, { OpExprReg(subject), OpImm(argsLen), OpLabel(innerFail) });
+	}
 
-	// --- 4. Match each argument subpattern ---
+	// --- 3. Match each argument subpattern ---
+	// Once an argument has split a sequence, later failures backtrack into the split
+	size_t splitMark = st.splitCount;
+	std::optional<Label> backtrackFail;
 	for (mint i = partStart; i <= static_cast<mint>(argsLen); ++i)
 	{
+		Label argFail = st.failLabelAfter(splitMark, innerFail, backtrackFail);
+
 		// Extract the i-th part into a fresh register
 		ExprRegIndex rPart = st.allocExprReg();
-		st.emit(Opcode::GET_PART, { OpExprReg(rPart), OpExprReg(0), OpImm(i) });
-
-		// Move part into %e0 for matching (convention: %e0 = current value)
-		st.emit(Opcode::MOVE, { OpExprReg(0), OpExprReg(rPart) });
+		st.emit(Opcode::GET_PART, { OpExprReg(rPart), OpExprReg(subject), OpImm(i) });
 
 		auto child = mexpr->part(i);
-		// Compile child pattern with isTopLevel=false
+		// Compile child pattern against the extracted part with isTopLevel=false
 		// On success, it falls through to next iteration
-		// On failure, it jumps to innerFail
-		compilePatternRec(st, child, successLabel, innerFail, false);
-
-		// Restore %e0 to original value for next part extraction
-		st.emit(Opcode::MOVE, { OpExprReg(0), OpExprReg(rSaved) });
+		// On failure, it jumps to innerFail (or backtracks, see above)
+		compilePatternRec(st, child, rPart, successLabel, argFail, false);
 	}
 
 	// All arguments matched successfully
-	st.endBlock(blockLabel);
+	if (hasFrame)
+		st.endBlock(blockLabel);
 
 	// Create continuation point for non-top-level patterns
 	Label afterFailHandler = st.newLabel();
@@ -1166,6 +1937,7 @@ static void compileNormal(CompilerState& st, std::shared_ptr<MExprNormal> mexpr,
 	// ============================================================
 	st.bindLabel(innerFail);
 	st.emit(Opcode::JUMP, { OpLabel(outerFail) }); // Propagate failure
+	st.emitBacktrackHandler(backtrackFail);
 
 	st.bindLabel(afterFailHandler); // Continuation for nested patterns
 }
@@ -1187,6 +1959,7 @@ Pattern types:
 Parameters explained:
 @param st: Compiler state (registers, labels, bytecode)
 @param mexpr: Pattern to compile (in MExpr form)
+@param subject: Register holding the expression to match against
 @param successLabel: Where to jump on successful match
 @param failLabel: Where to jump on failed match
 @param isTopLevel:
@@ -1195,21 +1968,21 @@ Parameters explained:
   - false: Pattern falls through on match (for composition)
 	Used for: nested patterns, argument patterns in f[x_, y_]
 ---------------------------------------------------------------------------*/
-static void compilePatternRec(CompilerState& st, std::shared_ptr<MExpr> mexpr, Label successLabel, Label failLabel,
-							  bool isTopLevel)
+static void compilePatternRec(CompilerState& st, std::shared_ptr<MExpr> mexpr, ExprRegIndex subject,
+							  Label successLabel, Label failLabel, bool isTopLevel)
 {
 	switch (mexpr->getKind())
 	{
 		case MExpr::Kind::Literal:
 		{
-			compileLiteralMatch(st, mexpr, successLabel, failLabel, isTopLevel);
+			compileLiteralMatch(st, mexpr, subject, successLabel, failLabel, isTopLevel);
 			return;
 		}
 		case MExpr::Kind::Symbol:
 		{
 			// TODO: Distinguish between symbol patterns and symbol literals
 			// For now, treat symbols as literals (e.g., Pi matches only Pi)
-			compileLiteralMatch(st, mexpr, successLabel, failLabel, isTopLevel);
+			compileLiteralMatch(st, mexpr, subject, successLabel, failLabel, isTopLevel);
 			return;
 		}
 		case MExpr::Kind::Normal:
@@ -1218,36 +1991,36 @@ static void compilePatternRec(CompilerState& st, std::shared_ptr<MExpr> mexpr, L
 			// Dispatch based on specific pattern type
 			if (MExprIsBlank(mexpr))
 			{
-				compileBlank(st, mexprNormal, successLabel, failLabel, isTopLevel);
+				compileBlank(st, mexprNormal, subject, successLabel, failLabel, isTopLevel);
 			}
 			else if (MExprIsPattern(mexpr))
 			{
-				compilePattern(st, mexprNormal, successLabel, failLabel, isTopLevel);
+				compilePattern(st, mexprNormal, subject, successLabel, failLabel, isTopLevel);
 			}
 			else if (MExprIsAlternatives(mexpr))
 			{
-				compileAlternatives(st, mexprNormal, successLabel, failLabel, isTopLevel);
+				compileAlternatives(st, mexprNormal, subject, successLabel, failLabel, isTopLevel);
 			}
 			else if (MExprIsPatternTest(mexpr))
 			{
-				compilePatternTest(st, mexprNormal, successLabel, failLabel, isTopLevel);
+				compilePatternTest(st, mexprNormal, subject, successLabel, failLabel, isTopLevel);
 			}
 			else if (MExprIsCondition(mexpr))
 			{
-				compileCondition(st, mexprNormal, successLabel, failLabel, isTopLevel);
+				compileCondition(st, mexprNormal, subject, successLabel, failLabel, isTopLevel);
 			}
 			else if (MExprIsBlankSequence(mexpr))
 			{
-				compileBlankSequence(st, mexprNormal, successLabel, failLabel, isTopLevel, false);
+				compileBlankSequence(st, mexprNormal, subject, successLabel, failLabel, isTopLevel, false);
 			}
 			else if (MExprIsBlankNullSequence(mexpr))
 			{
-				compileBlankSequence(st, mexprNormal, successLabel, failLabel, isTopLevel, true);
+				compileBlankSequence(st, mexprNormal, subject, successLabel, failLabel, isTopLevel, true);
 			}
 			else
 			{
 				// Regular structured expression: f[args...]
-				compileNormal(st, mexprNormal, successLabel, failLabel, isTopLevel);
+				compileNormal(st, mexprNormal, subject, successLabel, failLabel, isTopLevel);
 			}
 			return;
 		}
@@ -1281,14 +2054,27 @@ Generated structure:
 The entry block creates a frame for all pattern bindings.
 EXPORT_BINDINGS at the end extracts bindings (e.g., x→5) for return.
 
+The optimization passes enabled at level then run on the compiler's
+registers, before register allocation.
+
 Returns: Shared pointer to PatternBytecode ready for execution
 ---------------------------------------------------------------------------*/
-std::shared_ptr<PatternBytecode> CompilePatternToBytecode(const Expr& patternExpr)
+std::shared_ptr<PatternBytecode> CompilePatternToBytecode(const Expr& patternExpr,
+														  BytecodeOptimizer::OptimizationLevel level)
 {
 	// Convert Expr to MExpr (internal AST representation)
-	auto pattern = MExpr::construct(patternExpr);
+	return CompilePatternToBytecode(MExpr::construct(patternExpr), level, {}, {});
+}
 
+std::shared_ptr<PatternBytecode> CompilePatternToBytecode(const std::shared_ptr<MExpr>& pattern,
+														  BytecodeOptimizer::OptimizationLevel level,
+														  const PatternBytecode::AlternativeOrder& order,
+														  const std::vector<std::string>& variableSlots)
+{
 	CompilerState st;
+	st.alternativeOrder = order;
+	for (const auto& name : variableSlots)
+		st.internVariable(name);
 
 	// Allocate standard labels
 	Label entryLabel = st.newLabel(); // L0: Entry point
@@ -1303,7 +2089,7 @@ std::shared_ptr<PatternBytecode> CompilePatternToBytecode(const Expr& patternExp
 	// Compile the pattern with isTopLevel=true
 	// On match: jumps to successLabel
 	// On fail: jumps to failLabel
-	compilePatternRec(st, pattern, successLabel, failLabel, true);
+	compilePatternRec(st, pattern, 0, successLabel, failLabel, true);
 
 	st.endBlock(entryLabel);
 
@@ -1327,7 +2113,17 @@ std::shared_ptr<PatternBytecode> CompilePatternToBytecode(const Expr& patternExp
 	st.emit(Opcode::HALT, {});
 
 	// Finalize bytecode with metadata
-	st.out->set_metadata(pattern, st.nextExprReg, st.nextBoolReg, st.lexical.getBindings());
+	st.out->set_metadata(pattern, st.nextExprReg, st.nextBoolReg, st.lexical.getBindings(), std::move(st.variableSlots));
+	st.out->setCompilation(level, std::move(st.alternativeOrder));
+
+	// Optimization passes (see BytecodeOptimizer::getPasses)
+	BytecodeOptimizer::runPasses(*st.out, level);
+
+	// Temporaries whose live ranges do not overlap share registers
+	BytecodeAnalysis::allocateRegisters(*st.out);
+
+	// Choice points save only the registers live at their alternatives
+	BytecodeAnalysis::computeChoicePointSaveSets(*st.out);
 
 	return st.out;
 }
@@ -1,12 +1,28 @@
 #pragma once
 
+#include "VM/OptimizePatternBytecode.h"
 #include "VM/PatternBytecode.h"
 
 #include "Expr.h"
 
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace PatternMatcher
 {
-std::shared_ptr<PatternBytecode> CompilePatternToBytecode(const Expr& pattern);
+std::shared_ptr<PatternBytecode>
+CompilePatternToBytecode(const Expr& pattern,
+						 BytecodeOptimizer::OptimizationLevel level = BytecodeOptimizer::DefaultOptimizationLevel);
+
+/// @brief Compile a constructed pattern, trying interchangeable alternatives in a given order
+/// @param pattern The pattern (the order is keyed by its Alternatives nodes)
+/// @param level Optimization level
+/// @param order Order of the branches of each Alternatives (see PatternBytecode::AlternativeChain)
+/// @param variableSlots Variables to give the first slots, in order (those of the bytecode being recompiled)
+/// @note Used by PatternBytecode::reorderAlternatives
+std::shared_ptr<PatternBytecode> CompilePatternToBytecode(const std::shared_ptr<MExpr>& pattern,
+														  BytecodeOptimizer::OptimizationLevel level,
+														  const PatternBytecode::AlternativeOrder& order,
+														  const std::vector<std::string>& variableSlots);
 }; // namespace PatternMatcher
\ No newline at end of file
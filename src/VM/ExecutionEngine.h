@@ -0,0 +1,93 @@
+#pragma once
+
+#include "VM/Opcode.h"
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <string_view>
+
+namespace PatternMatcher
+{
+/*===========================================================================
+ExecutionEngine: Instrumentation Policies for the VM Executor
+
+VirtualMachine::execute is templated on an instrumentation policy, so every
+engine is compiled into the same library and a VM picks one at runtime:
+
+- NoTrace: production engine, no instrumentation at all
+- Trace:   emits a structured trace record per instruction (traceOpcode)
+- Stats:   counts executed opcodes, failure jumps, choice points, backtracks
+
+Instrumentation sites are guarded with `if constexpr`, so the NoTrace engine
+never builds trace arguments (no toString() calls into the kernel), never
+branches on a trace flag and never touches the statistics counters.
+===========================================================================*/
+
+enum class ExecutionEngine
+{
+	NoTrace,
+	Trace,
+	Stats
+};
+
+/// Production engine: no instrumentation
+struct NoTracePolicy
+{
+	static constexpr bool trace = false;
+	static constexpr bool stats = false;
+};
+
+/// Trace engine: one trace record per instruction and VM event
+struct TracePolicy
+{
+	static constexpr bool trace = true;
+	static constexpr bool stats = false;
+};
+
+/// Statistics engine: execution counters, no trace output
+struct StatsPolicy
+{
+	static constexpr bool trace = false;
+	static constexpr bool stats = true;
+};
+
+/// @brief Counters collected by the Stats engine during one match
+struct ExecutionStats
+{
+	std::array<size_t, OpcodeCount> opcodeCounts {}; ///< Executions per opcode
+	size_t failureJumps = 0; ///< Jumps to a failure label
+	size_t choicePoints = 0; ///< Choice points created
+	size_t backtracks = 0; ///< Successful backtracks to a choice point
+
+	void reset() { *this = ExecutionStats {}; }
+};
+
+/// @brief Get the name of an engine ("NoTrace", "Trace" or "Stats")
+inline const char* engineName(ExecutionEngine engine)
+{
+	switch (engine)
+	{
+		case ExecutionEngine::NoTrace:
+			return "NoTrace";
+		case ExecutionEngine::Trace:
+			return "Trace";
+		case ExecutionEngine::Stats:
+			return "Stats";
+		default:
+			return "Unknown";
+	}
+}
+
+/// @brief Parse an engine name (nullopt if unknown)
+inline std::optional<ExecutionEngine> engineFromName(std::string_view name)
+{
+	if (name == "NoTrace")
+		return ExecutionEngine::NoTrace;
+	if (name == "Trace")
+		return ExecutionEngine::Trace;
+	if (name == "Stats")
+		return ExecutionEngine::Stats;
+	return std::nullopt;
+}
+}; // namespace PatternMatcher
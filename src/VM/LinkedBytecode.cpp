@@ -0,0 +1,282 @@
+/*===========================================================================
+LinkedBytecode.cpp - Lowering PatternBytecode to its Executable Form
+
+Linking walks the instruction list once and packs every std::variant operand
+into a fixed-width word. Expr immediates are moved into the constant pool,
+variable names are replaced by their compiler-assigned slots and labels are
+resolved to absolute PCs, so the VM's hot loop never touches std::variant,
+std::string, a label hash map or a per-instruction heap allocation.
+===========================================================================*/
+
+#include "VM/LinkedBytecode.h"
+#include "VM/Opcode.h"
+#include "VM/PatternBytecode.h"
+
+#include "Expr.h"
+#include "Logger.h"
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+namespace PatternMatcher
+{
+template <typename T>
+void LinkedBytecode::LiteralMap<T>::insert(const Expr& key, const T& value)
+{
+	const auto& constants = getExprConstants();
+	Expr head = key.head();
+	if (head.sameQ(constants.integerHead))
+	{
+		if (auto n = key.as<mint>())
+		{
+			integers.try_emplace(*n, value);
+			return;
+		}
+	}
+	else if (head.sameQ(constants.stringHead))
+	{
+		if (auto s = key.as<std::string>())
+		{
+			strings.try_emplace(*s, value);
+			return;
+		}
+	}
+	else if (head.sameQ(constants.symbolHead))
+	{
+		if (auto name = key.symbolName())
+		{
+			symbols[*name].emplace_back(key, value);
+			return;
+		}
+	}
+	others.emplace_back(key, value);
+}
+
+template <typename T>
+const T* LinkedBytecode::LiteralMap<T>::find(const Expr& value) const
+{
+	auto firstSameQ = [&](const std::vector<std::pair<Expr, T>>& keys) -> const T* {
+		for (const auto& [key, keyValue] : keys)
+			if (key.sameQ(value))
+				return &keyValue;
+		return nullptr;
+	};
+
+	// Only the types that have keys are told apart: a value of another type can only be in others
+	if (!integers.empty() || !strings.empty() || !symbols.empty())
+	{
+		const auto& constants = getExprConstants();
+		Expr head = value.head();
+		if (!integers.empty() && head.sameQ(constants.integerHead))
+		{
+			// Big integers fall through to the SameQ scan
+			if (auto n = value.as<mint>())
+			{
+				auto it = integers.find(*n);
+				return it != integers.end() ? &it->second : nullptr;
+			}
+		}
+		else if (!strings.empty() && head.sameQ(constants.stringHead))
+		{
+			auto s = value.as<std::string_view>();
+			auto it = s ? strings.find(*s) : strings.end();
+			return it != strings.end() ? &it->second : nullptr;
+		}
+		else if (!symbols.empty() && head.sameQ(constants.symbolHead))
+		{
+			auto name = value.symbolName();
+			auto it = name ? symbols.find(*name) : symbols.end();
+			return it != symbols.end() ? firstSameQ(it->second) : nullptr;
+		}
+	}
+
+	return firstSameQ(others);
+}
+
+template struct LinkedBytecode::LiteralMap<bool>;
+template struct LinkedBytecode::LiteralMap<LinkedBytecode::Word>;
+
+std::shared_ptr<LinkedBytecode> LinkPatternBytecode(const std::shared_ptr<PatternBytecode>& bytecode)
+{
+	using OperandKind = LinkedBytecode::OperandKind;
+
+	auto linked = std::make_shared<LinkedBytecode>();
+	linked->source = bytecode;
+
+	const auto& srcInstrs = bytecode->getInstructions();
+	const auto& labelMap = bytecode->getLabelMap();
+	linked->instrs.reserve(srcInstrs.size());
+
+	const auto& saveSets = bytecode->getChoicePointSaveSets();
+
+	// Variable slots are assigned by the compiler; only the reverse lookup is built here
+	const auto& variableNames = bytecode->getVariableNames();
+	std::unordered_map<std::string, LinkedBytecode::Word> slotMap;
+	for (size_t slot = 0; slot < variableNames.size(); ++slot)
+		slotMap.emplace(variableNames[slot], static_cast<LinkedBytecode::Word>(slot));
+
+	for (const auto& srcInstr : srcInstrs)
+	{
+		PM_ASSERT(srcInstr.ops.size() <= LinkedBytecode::MaxOperands, "LinkPatternBytecode: too many operands for ",
+				  opcodeName(srcInstr.opcode));
+
+		LinkedBytecode::Instruction instr {};
+		instr.opcode = srcInstr.opcode;
+		instr.kinds.fill(OperandKind::None);
+		instr.ops.fill(0);
+
+		for (size_t i = 0; i < srcInstr.ops.size() && i < LinkedBytecode::MaxOperands; ++i)
+		{
+			const auto& op = srcInstr.ops[i];
+			if (auto* r = std::get_if<ExprRegOp>(&op))
+			{
+				instr.kinds[i] = OperandKind::ExprReg;
+				instr.ops[i] = static_cast<LinkedBytecode::Word>(r->v);
+			}
+			else if (auto* b = std::get_if<BoolRegOp>(&op))
+			{
+				instr.kinds[i] = OperandKind::BoolReg;
+				instr.ops[i] = static_cast<LinkedBytecode::Word>(b->v);
+			}
+			else if (auto* l = std::get_if<LabelOp>(&op))
+			{
+				auto it = labelMap.find(l->v);
+				if (it == labelMap.end())
+				{
+					PM_ERROR("LinkPatternBytecode: unresolved label L", l->v, " in ", opcodeName(srcInstr.opcode));
+					continue;
+				}
+				instr.kinds[i] = OperandKind::Target;
+				instr.ops[i] = static_cast<LinkedBytecode::Word>(it->second);
+			}
+			else if (auto* id = std::get_if<Ident>(&op))
+			{
+				auto it = slotMap.find(*id);
+				if (it == slotMap.end())
+				{
+					PM_ERROR("LinkPatternBytecode: variable ", *id, " has no slot in ", opcodeName(srcInstr.opcode));
+					continue;
+				}
+				instr.kinds[i] = OperandKind::Slot;
+				instr.ops[i] = it->second;
+			}
+			else if (auto* e = std::get_if<ImmExpr>(&op))
+			{
+				instr.kinds[i] = OperandKind::Constant;
+				instr.ops[i] = static_cast<LinkedBytecode::Word>(linked->constants.size());
+				linked->constants.push_back(*e);
+			}
+			else if (auto* m = std::get_if<ImmMint>(&op))
+			{
+				instr.kinds[i] = OperandKind::Mint;
+				instr.ops[i] = m->v;
+			}
+		}
+
+		// TRY, SPLIT_SEQ: attach the choice point save set as an extra operand
+		if (srcInstr.opcode == Opcode::TRY || srcInstr.opcode == Opcode::SPLIT_SEQ)
+		{
+			LinkedBytecode::SaveSet saveSet;
+			auto it = saveSets.find(linked->instrs.size());
+			if (it != saveSets.end())
+			{
+				saveSet.exprRegs.assign(it->second.exprRegs.begin(), it->second.exprRegs.end());
+			}
+			else
+			{
+				for (int r = 0; r < bytecode->getExprRegisterCount(); ++r)
+					saveSet.exprRegs.push_back(r);
+			}
+			size_t saveSetOperand = srcInstr.ops.size(); // TRY: 1, SPLIT_SEQ: 4
+			PM_ASSERT(saveSetOperand < LinkedBytecode::MaxOperands, "LinkPatternBytecode: no room for the save set of ",
+					  opcodeName(srcInstr.opcode));
+			instr.kinds[saveSetOperand] = OperandKind::Mint;
+			instr.ops[saveSetOperand] = static_cast<LinkedBytecode::Word>(linked->saveSets.size());
+			linked->saveSets.push_back(std::move(saveSet));
+		}
+
+		linked->instrs.push_back(instr);
+	}
+
+	// TRY, RETRY, TRUST of an alternative chain: attach the branch point as an extra operand
+	const auto& chains = bytecode->getAlternativeChains();
+	for (size_t c = 0; c < chains.size(); ++c)
+	{
+		// Branch k + 1 starts at the RETRY (TRUST for the last one) its resume label is bound to,
+		// and branch 0 at the TRY resuming at the first of them
+		std::vector<size_t> starts;
+		for (auto label : chains[c].resumeLabels)
+		{
+			auto it = labelMap.find(label);
+			if (it == labelMap.end() || it->second >= srcInstrs.size())
+				break;
+			starts.push_back(it->second);
+		}
+		if (starts.empty() || starts.size() != chains[c].resumeLabels.size())
+			continue;
+
+		auto resumesAt = [&](size_t pc, size_t target) {
+			const auto& ops = linked->instrs[pc].ops;
+			return linked->instrs[pc].kinds[0] == OperandKind::Target && static_cast<size_t>(ops[0]) == target;
+		};
+		size_t tryPC = 0;
+		while (tryPC < linked->instrs.size()
+			   && !(linked->instrs[tryPC].opcode == Opcode::TRY && resumesAt(tryPC, starts[0])))
+			++tryPC;
+		if (tryPC == linked->instrs.size())
+			continue;
+		bool recorded = true;
+		for (size_t k = 0; k < starts.size() && recorded; ++k)
+		{
+			bool last = k + 1 == starts.size();
+			recorded = linked->instrs[starts[k]].opcode == (last ? Opcode::TRUST : Opcode::RETRY)
+				&& (last || resumesAt(starts[k], starts[k + 1]));
+		}
+		if (!recorded)
+			continue;
+
+		starts.insert(starts.begin(), tryPC);
+		for (size_t k = 0; k < starts.size(); ++k)
+		{
+			auto& instr = linked->instrs[starts[k]];
+			size_t operand = srcInstrs[starts[k]].ops.size() + (instr.opcode == Opcode::TRY ? 1 : 0);
+			instr.kinds[operand] = OperandKind::Mint;
+			instr.ops[operand] = static_cast<LinkedBytecode::Word>(linked->branchPoints.size() + 1);
+			linked->branchPoints.push_back(
+				{ static_cast<LinkedBytecode::Word>(c), static_cast<LinkedBytecode::Word>(k) });
+		}
+	}
+
+	// SWITCH_ON_HEAD, SWITCH_ON_LITERAL: resolve the case labels of every table and hash its keys
+	for (const auto& table : bytecode->getSwitchTables())
+	{
+		LinkedBytecode::JumpTable jumpTable;
+		for (const auto& [key, label] : table.cases)
+		{
+			auto it = labelMap.find(label);
+			if (it == labelMap.end())
+			{
+				PM_ERROR("LinkPatternBytecode: unresolved switch case label L", label);
+				continue;
+			}
+			jumpTable.targets.insert(key, static_cast<LinkedBytecode::Word>(it->second));
+		}
+		linked->jumpTables.push_back(std::move(jumpTable));
+	}
+
+	// MATCH_LITERAL_SET: hash the values of every set
+	for (const auto& set : bytecode->getLiteralSets())
+	{
+		LinkedBytecode::LiteralSet literalSet;
+		for (const auto& value : set.values)
+			literalSet.insert(value);
+		linked->literalSets.push_back(std::move(literalSet));
+	}
+
+	return linked;
+}
+}; // namespace PatternMatcher
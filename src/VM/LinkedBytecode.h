@@ -0,0 +1,221 @@
+#pragma once
+
+#include "VM/Opcode.h"
+#include "VM/PatternBytecode.h"
+
+#include "Expr.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace PatternMatcher
+{
+/*===========================================================================
+LinkedBytecode: Executable Form of PatternBytecode
+
+PatternBytecode is the form the compiler emits and the disassembler prints:
+every instruction owns a heap-allocated vector of std::variant operands
+(including std::string identifiers and Expr immediates). That is convenient
+to build, but decoding it on every cycle is a large share of the VM's work.
+
+Linking lowers a PatternBytecode once into a flat, variant-free stream:
+- Instructions are fixed-width records stored in one contiguous array
+- Every operand is a machine word packed inline in its instruction
+- ImmExpr immediates live in a constant pool (operand = pool index)
+- Ident operands become the variable slots the compiler assigned
+  (PatternBytecode::getVariableNames, operand = slot index)
+
+Operand word encoding by source operand type:
+  ExprRegOp → register index      BoolRegOp → register index
+  LabelOp   → absolute PC         ImmMint   → integer value
+  ImmExpr   → constant pool index Ident     → variable slot
+
+Each choice point instruction gets an extra operand indexing its save set:
+the expression registers live where it resumes (see BytecodeAnalysis). TRY
+gets it as operand 1, SPLIT_SEQ as operand 4. Without an analysis result,
+the save set is every expression register.
+
+The TRY, RETRY and TRUST of a recorded alternative chain (see
+PatternBytecode::AlternativeChain) get one more extra operand, a 1-based
+index of the BranchPoint they start, so the VM can count which branch
+matched: TRY as operand 2, RETRY as operand 1, TRUST as operand 0. It is 0
+for every other choice point, and for the whole chain if the optimizer left
+it in a shape other than the recorded one.
+
+SWITCH_ON_HEAD/SWITCH_ON_LITERAL keep their table index (operand 1); the
+table's keys are hashed by type into a JumpTable of PCs, so dispatch costs
+one lookup however many cases there are. MATCH_LITERAL_SET keeps its set
+index; the set's values are hashed the same way into a LiteralSet.
+EVAL_CONDITION and EVAL_NATIVE_CONDITION keep their condition index.
+
+Labels are resolved to absolute PCs at link time, so every control transfer
+(jumps, failure branches, choice point alternatives) is a plain integer
+assignment. The label map stays in PatternBytecode for disassembly only.
+
+Instruction indices are preserved 1:1, so a PC in the linked form is the same
+PC in the source PatternBytecode (step(), getPC() and tracing stay valid).
+===========================================================================*/
+
+class LinkedBytecode
+{
+public:
+	/// Maximum operand count of any opcode (MATCH_SEQ_HEADS, SPLIT_SEQ with its save set)
+	static constexpr size_t MaxOperands = 5;
+
+	/// Packed operand word
+	using Word = mint;
+
+	/// @brief Kind of a packed operand
+	/// @note Only consulted by opcodes whose operands are polymorphic
+	///       (LOAD_IMM: expr or bool destination, MAKE_SEQUENCE: immediate or register end)
+	enum class OperandKind : uint8_t
+	{
+		None,
+		ExprReg,
+		BoolReg,
+		Target,
+		Slot,
+		Constant,
+		Mint
+	};
+
+	struct Instruction
+	{
+		Opcode opcode;
+		std::array<OperandKind, MaxOperands> kinds;
+		std::array<Word, MaxOperands> ops;
+	};
+
+	/// Literal keys hashed by type, each mapped to a value: the first key SameQ to a value is found
+	/// without comparing against the others
+	/// @note Keys SameQ only to values of their own type, so each type is looked up on its own
+	template <typename T>
+	struct LiteralMap
+	{
+		/// Transparent string hash, so lookups take the string_view of the input
+		struct StringHash
+		{
+			using is_transparent = void;
+			size_t operator()(std::string_view s) const { return std::hash<std::string_view> {}(s); }
+		};
+
+		std::unordered_map<mint, T> integers; ///< Machine integers
+		std::unordered_map<std::string, T, StringHash, std::equal_to<>> strings;
+		std::unordered_map<std::string, std::vector<std::pair<Expr, T>>> symbols; ///< By name; SameQ tells contexts apart
+		std::vector<std::pair<Expr, T>> others; ///< Anything else (reals, big integers, ...), compared with SameQ
+
+		/// @brief Map a key to a value (a key already present keeps its first value)
+		void insert(const Expr& key, const T& value);
+
+		/// @brief Get the value of the key SameQ to value, nullptr if there is none
+		const T* find(const Expr& value) const;
+	};
+
+	/// Jump table of a SWITCH_ON_HEAD or SWITCH_ON_LITERAL (indexed by its operand 1)
+	/// @note SWITCH_ON_HEAD keys are mostly symbols: one name lookup, then SameQ against that key only
+	struct JumpTable
+	{
+		LiteralMap<Word> targets; ///< Key -> PC of its case
+
+		/// @brief Get the target of the key SameQ to value, or fallback if there is none
+		Word lookup(const Expr& value, Word fallback) const
+		{
+			const Word* target = targets.find(value);
+			return target ? *target : fallback;
+		}
+	};
+
+	/// Literal values of a MATCH_LITERAL_SET (indexed by its operand 1), hashed by type
+	struct LiteralSet
+	{
+		LiteralMap<bool> values;
+
+		/// @brief Add a value to the set
+		void insert(const Expr& value) { values.insert(value, true); }
+
+		/// @brief Check if the set has a value SameQ to value
+		bool contains(const Expr& value) const { return values.find(value) != nullptr; }
+	};
+
+	/// Expression registers a choice point saves and restores (indexed by TRY operand 1, SPLIT_SEQ operand 4)
+	/// @note Boolean registers are snapshotted whole: the file is usually a single word
+	struct SaveSet
+	{
+		std::vector<Word> exprRegs;
+	};
+
+	/// Branch of an alternative chain (indexed by the branch point operand of TRY, RETRY and TRUST, minus 1)
+	struct BranchPoint
+	{
+		Word chain; ///< Index into PatternBytecode::getAlternativeChains
+		Word branch; ///< Position of the branch in the chain (0: the TRY)
+	};
+
+	LinkedBytecode() = default;
+	~LinkedBytecode() = default;
+
+	/// @brief Get the linked instruction stream.
+	const std::vector<Instruction>& getInstructions() const { return instrs; }
+
+	/// @brief Get the number of instructions.
+	size_t length() const { return instrs.size(); }
+
+	/// @brief Get a constant from the constant pool.
+	const Expr& getConstant(Word index) const { return constants[index]; }
+
+	/// @brief Get the number of entries in the constant pool.
+	size_t getConstantCount() const { return constants.size(); }
+
+	/// @brief Get the variable name of a slot (e.g. "Global`x").
+	const std::string& getSlotName(Word slot) const { return source->getVariableName(slot); }
+
+	/// @brief Get the number of variable slots.
+	size_t getSlotCount() const { return source->getVariableNames().size(); }
+
+	/// @brief Get a choice point save set.
+	const SaveSet& getSaveSet(Word index) const { return saveSets[index]; }
+
+	/// @brief Get a branch point (index is the 1-based branch point operand).
+	const BranchPoint& getBranchPoint(Word index) const { return branchPoints[index - 1]; }
+
+	/// @brief Get the number of alternative chains.
+	size_t getAlternativeChainCount() const { return source->getAlternativeChains().size(); }
+
+	/// @brief Get the literal set of a MATCH_LITERAL_SET instruction.
+	const LiteralSet& getLiteralSet(Word index) const { return literalSets[index]; }
+
+	/// @brief Get the jump table of a switch instruction.
+	const JumpTable& getJumpTable(Word index) const { return jumpTables[index]; }
+
+	/// @brief Get the condition of an EVAL_CONDITION or EVAL_NATIVE_CONDITION instruction.
+	const PatternBytecode::Condition& getCondition(Word index) const { return source->getConditions()[index]; }
+
+	/// @brief Get the conditions.
+	const std::vector<PatternBytecode::Condition>& getConditions() const { return source->getConditions(); }
+
+	/// @brief Get the PatternBytecode this was linked from.
+	const std::shared_ptr<PatternBytecode>& getSource() const { return source; }
+
+private:
+	friend std::shared_ptr<LinkedBytecode> LinkPatternBytecode(const std::shared_ptr<PatternBytecode>& bytecode);
+
+	std::shared_ptr<PatternBytecode> source; // bytecode this was linked from
+	std::vector<Instruction> instrs;
+	std::vector<Expr> constants; // constant pool (ImmExpr operands)
+	std::vector<SaveSet> saveSets; // choice point save sets (TRY operand 1, SPLIT_SEQ operand 4)
+	std::vector<JumpTable> jumpTables; // switch tables with resolved targets (SWITCH_* operand 1)
+	std::vector<LiteralSet> literalSets; // hashed literal sets (MATCH_LITERAL_SET operand 1)
+	std::vector<BranchPoint> branchPoints; // alternative chain branches (TRY operand 2, RETRY 1, TRUST 0)
+};
+
+/// @brief Lower a PatternBytecode into its executable linked form.
+/// @param bytecode The bytecode to link.
+/// @return The linked bytecode.
+std::shared_ptr<LinkedBytecode> LinkPatternBytecode(const std::shared_ptr<PatternBytecode>& bytecode);
+}; // namespace PatternMatcher
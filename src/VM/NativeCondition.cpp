@@ -0,0 +1,552 @@
+#include "VM/NativeCondition.h"
+#include "VM/TestIntrinsics.h"
+
+#include "AST/MExpr.h"
+#include "Expr.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace PatternMatcher
+{
+/*===========================================================================
+ Compilation
+===========================================================================*/
+
+class NativeConditionCompiler
+{
+public:
+	using Op = NativeCondition::Op;
+
+	NativeConditionCompiler(const std::function<std::optional<size_t>(const std::string&)>& slotOf_)
+		: slotOf(slotOf_)
+	{
+	}
+
+	/// Compile a boolean-valued expression (the condition itself, or an operand of And/Or/Not)
+	bool compileBoolean(const std::shared_ptr<MExpr>& mexpr)
+	{
+		if (mexpr->symbolQ())
+		{
+			auto name = std::static_pointer_cast<MExprSymbol>(mexpr)->getLexicalName();
+			if (name == "System`True" || name == "System`False")
+				return emit({ Op::PushBool, name == "System`True" });
+			return false;
+		}
+		if (!mexpr->normalQ())
+			return false;
+
+		auto norm = std::static_pointer_cast<MExprNormal>(mexpr);
+		std::string head = headName(norm);
+		const auto& args = norm->getChildren();
+
+		if (head == "System`And" || head == "System`Or")
+		{
+			if (args.empty())
+				return false;
+			for (const auto& arg : args)
+				if (!compileBoolean(arg))
+					return false;
+			return emitReduce(head == "System`And" ? Op::And : Op::Or, args.size());
+		}
+		if (head == "System`Not" && args.size() == 1)
+			return compileBoolean(args[0]) && emitReduce(Op::Not, 1);
+
+		// Chained comparisons: a < b <= c is Inequality[a, Less, b, LessEqual, c]
+		if (head == "System`Inequality")
+		{
+			if (args.size() < 3 || args.size() % 2 == 0)
+				return false;
+			size_t count = 0;
+			for (size_t i = 1; i < args.size(); i += 2, ++count)
+			{
+				auto op = args[i]->symbolQ()
+							  ? comparisonOp(std::static_pointer_cast<MExprSymbol>(args[i])->getLexicalName())
+							  : std::nullopt;
+				if (!op || !compareAdjacent(*op, args[i - 1], args[i + 1]))
+					return false;
+			}
+			return count == 1 || emitReduce(Op::And, count);
+		}
+
+		// Less[a, b, c], Equal[a, b], ...; Unequal[a, b, c] means all distinct, so only two operands
+		if (auto op = comparisonOp(head))
+		{
+			if (args.size() < 2 || (*op == Op::Unequal && args.size() != 2))
+				return false;
+			for (size_t i = 0; i + 1 < args.size(); ++i)
+				if (!compareAdjacent(*op, args[i], args[i + 1]))
+					return false;
+			return args.size() == 2 || emitReduce(Op::And, args.size() - 1);
+		}
+
+		// EvenQ[x], Positive[x], ...
+		if (args.size() == 1)
+		{
+			auto intrinsic = getTestIntrinsic(norm->getHead()->getExpr());
+			auto arg = variableArgument(args[0]);
+			if (intrinsic && arg)
+			{
+				NativeCondition::Instruction instr { Op::Test, static_cast<uint32_t>(*arg) };
+				instr.intrinsic = *intrinsic;
+				return emit(instr);
+			}
+		}
+		return false;
+	}
+
+	/// Compile a numeric expression
+	bool compileNumber(const std::shared_ptr<MExpr>& mexpr)
+	{
+		if (mexpr->literalQ())
+		{
+			Expr value = mexpr->getExpr();
+			if (auto n = value.as<mint>())
+			{
+				NativeCondition::Instruction instr { Op::PushInteger };
+				instr.integer = *n;
+				return emit(instr);
+			}
+			if (auto r = machineReal(value))
+			{
+				NativeCondition::Instruction instr { Op::PushReal };
+				instr.real = *r;
+				return emit(instr);
+			}
+			return false;
+		}
+		if (mexpr->symbolQ())
+		{
+			auto arg = variableArgument(mexpr);
+			return arg && emit({ Op::PushArg, static_cast<uint32_t>(*arg) });
+		}
+		if (!mexpr->normalQ())
+			return false;
+
+		auto norm = std::static_pointer_cast<MExprNormal>(mexpr);
+		std::string head = headName(norm);
+		const auto& args = norm->getChildren();
+
+		if ((head == "System`Plus" || head == "System`Times") && !args.empty())
+		{
+			for (const auto& arg : args)
+				if (!compileNumber(arg))
+					return false;
+			return emitReduce(head == "System`Plus" ? Op::Plus : Op::Times, args.size());
+		}
+		if ((head == "System`Power" || head == "System`Mod") && args.size() == 2)
+			return compileNumber(args[0]) && compileNumber(args[1])
+				&& emitReduce(head == "System`Power" ? Op::Power : Op::Mod, 2);
+		if (head == "System`Abs" && args.size() == 1)
+			return compileNumber(args[0]) && emitReduce(Op::Abs, 1);
+
+		// Length[x] and Length[{x}] (the idiom for a sequence variable)
+		if (head == "System`Length" && args.size() == 1)
+		{
+			if (auto arg = variableArgument(args[0]))
+				return emit({ Op::Length, static_cast<uint32_t>(*arg) });
+			if (args[0]->normalQ() && args[0]->length() == 1
+				&& headName(std::static_pointer_cast<MExprNormal>(args[0])) == "System`List")
+			{
+				auto list = std::static_pointer_cast<MExprNormal>(args[0]);
+				if (auto arg = variableArgument(list->part(1)))
+					return emit({ Op::LengthOfList, static_cast<uint32_t>(*arg) });
+			}
+		}
+		return false;
+	}
+
+	NativeCondition finish()
+	{
+		NativeCondition condition;
+		condition.code = std::move(code);
+		condition.slots = std::move(slots);
+		return condition;
+	}
+
+private:
+	const std::function<std::optional<size_t>(const std::string&)>& slotOf;
+	std::vector<NativeCondition::Instruction> code;
+	std::vector<size_t> slots;
+	size_t depth = 0;
+
+	static std::string headName(const std::shared_ptr<MExprNormal>& norm)
+	{
+		auto head = norm->getHead();
+		return head->symbolQ() ? std::static_pointer_cast<MExprSymbol>(head)->getLexicalName() : std::string();
+	}
+
+	static std::optional<Op> comparisonOp(const std::string& name)
+	{
+		if (name == "System`Less")
+			return Op::Less;
+		if (name == "System`LessEqual")
+			return Op::LessEqual;
+		if (name == "System`Greater")
+			return Op::Greater;
+		if (name == "System`GreaterEqual")
+			return Op::GreaterEqual;
+		if (name == "System`Equal")
+			return Op::Equal;
+		if (name == "System`Unequal")
+			return Op::Unequal;
+		return std::nullopt;
+	}
+
+	/// Value of a machine real literal (its InputForm, e.g. 2.5 or 1.*^-10)
+	static std::optional<double> machineReal(const Expr& value)
+	{
+		if (!value.head().sameQ(getExprConstants().realHead))
+			return std::nullopt;
+		std::string text = value.toInputFormString();
+		if (auto mark = text.find("*^"); mark != std::string::npos)
+			text.replace(mark, 2, "e");
+		if (text.find('`') != std::string::npos) // Arbitrary precision
+			return std::nullopt;
+		char* end = nullptr;
+		double r = std::strtod(text.c_str(), &end);
+		if (end != text.c_str() + text.size() || !std::isfinite(r))
+			return std::nullopt;
+		return r;
+	}
+
+	/// Argument index of a pattern variable, added on first use
+	std::optional<size_t> variableArgument(const std::shared_ptr<MExpr>& mexpr)
+	{
+		if (!mexpr->symbolQ())
+			return std::nullopt;
+		auto slot = slotOf(std::static_pointer_cast<MExprSymbol>(mexpr)->getLexicalName());
+		if (!slot)
+			return std::nullopt;
+		auto it = std::find(slots.begin(), slots.end(), *slot);
+		if (it == slots.end())
+		{
+			slots.push_back(*slot);
+			return slots.size() - 1;
+		}
+		return static_cast<size_t>(it - slots.begin());
+	}
+
+	bool compareAdjacent(Op op, const std::shared_ptr<MExpr>& lhs, const std::shared_ptr<MExpr>& rhs)
+	{
+		return compileNumber(lhs) && compileNumber(rhs) && emitReduce(op, 2);
+	}
+
+	/// Emit an instruction that pushes a value
+	bool emit(const NativeCondition::Instruction& instr)
+	{
+		code.push_back(instr);
+		return ++depth <= NativeCondition::MaxStack;
+	}
+
+	/// Emit an instruction that replaces its count operands with its result
+	bool emitReduce(Op op, size_t count)
+	{
+		code.push_back({ op, static_cast<uint32_t>(count) });
+		depth -= count - 1;
+		return true;
+	}
+};
+
+std::optional<NativeCondition>
+NativeCondition::compile(const std::shared_ptr<MExpr>& cond,
+						 const std::function<std::optional<size_t>(const std::string&)>& slotOf)
+{
+	NativeConditionCompiler compiler(slotOf);
+	if (!compiler.compileBoolean(cond))
+		return std::nullopt;
+	return compiler.finish();
+}
+
+/*===========================================================================
+ Evaluation
+===========================================================================*/
+
+namespace
+{
+	/// A value on the evaluation stack
+	struct Value
+	{
+		enum class Kind : uint8_t
+		{
+			Unknown, // Only the kernel can tell
+			Integer,
+			Real,
+			Boolean
+		};
+
+		Kind kind = Kind::Unknown;
+		mint integer = 0;
+		double real = 0;
+		bool boolean = false;
+
+		static Value ofInteger(mint n) { return { Kind::Integer, n }; }
+		static Value ofReal(double r) { return std::isfinite(r) ? Value { Kind::Real, 0, r } : Value {}; }
+		static Value ofBoolean(bool b) { return { Kind::Boolean, 0, 0, b }; }
+
+		bool isNumber() const { return kind == Kind::Integer || kind == Kind::Real; }
+
+		/// The value as a double, if it converts exactly
+		std::optional<double> toReal() const
+		{
+			if (kind == Kind::Real)
+				return real;
+			constexpr mint exact = mint(1) << 53;
+			if (kind == Kind::Integer && integer > -exact && integer < exact)
+				return static_cast<double>(integer);
+			return std::nullopt;
+		}
+	};
+
+	constexpr mint MintMax = std::numeric_limits<mint>::max();
+	constexpr mint MintMin = std::numeric_limits<mint>::min();
+
+	bool addOverflows(mint a, mint b)
+	{
+		return (b > 0 && a > MintMax - b) || (b < 0 && a < MintMin - b);
+	}
+
+	bool multiplyOverflows(mint a, mint b)
+	{
+		if (a == 0 || b == 0)
+			return false;
+		if (a > 0)
+			return b > 0 ? a > MintMax / b : b < MintMin / a;
+		return b > 0 ? a < MintMin / b : a < MintMax / b;
+	}
+
+	Value add(const Value& a, const Value& b)
+	{
+		if (a.kind == Value::Kind::Integer && b.kind == Value::Kind::Integer)
+			return addOverflows(a.integer, b.integer) ? Value {} : Value::ofInteger(a.integer + b.integer);
+		auto x = a.toReal(), y = b.toReal();
+		return x && y ? Value::ofReal(*x + *y) : Value {};
+	}
+
+	Value multiply(const Value& a, const Value& b)
+	{
+		if (a.kind == Value::Kind::Integer && b.kind == Value::Kind::Integer)
+			return multiplyOverflows(a.integer, b.integer) ? Value {} : Value::ofInteger(a.integer * b.integer);
+		auto x = a.toReal(), y = b.toReal();
+		return x && y ? Value::ofReal(*x * *y) : Value {};
+	}
+
+	/// Integer powers only: a real power may round differently from the kernel's
+	Value power(const Value& base, const Value& exponent)
+	{
+		if (base.kind != Value::Kind::Integer || exponent.kind != Value::Kind::Integer || exponent.integer < 0)
+			return {};
+		if (base.integer == 0 && exponent.integer == 0)
+			return {}; // Indeterminate
+		// 0, 1 and -1 never overflow, however large the exponent
+		if (base.integer == 0 || base.integer == 1)
+			return Value::ofInteger(exponent.integer == 0 ? 1 : base.integer);
+		if (base.integer == -1)
+			return Value::ofInteger(exponent.integer % 2 == 0 ? 1 : -1);
+		mint result = 1;
+		for (mint i = 0; i < exponent.integer; ++i)
+		{
+			if (multiplyOverflows(result, base.integer))
+				return {};
+			result *= base.integer;
+		}
+		return Value::ofInteger(result);
+	}
+
+	/// Integer Mod; the result takes the sign of the divisor
+	Value mod(const Value& a, const Value& b)
+	{
+		if (a.kind != Value::Kind::Integer || b.kind != Value::Kind::Integer || b.integer == 0)
+			return {};
+		if (b.integer == -1)
+			return Value::ofInteger(0);
+		mint r = a.integer % b.integer;
+		if (r != 0 && ((r < 0) != (b.integer < 0)))
+			r += b.integer;
+		return Value::ofInteger(r);
+	}
+
+	Value absolute(const Value& a)
+	{
+		if (a.kind == Value::Kind::Integer)
+			return a.integer == MintMin ? Value {} : Value::ofInteger(std::abs(a.integer));
+		if (a.kind == Value::Kind::Real)
+			return Value::ofReal(std::fabs(a.real));
+		return {};
+	}
+
+	/// Order of two numbers: -1, 0 or 1
+	/// @note Reals compare with a tolerance in the kernel, so distinct but close reals are Unknown
+	std::optional<int> order(const Value& a, const Value& b)
+	{
+		if (a.kind == Value::Kind::Integer && b.kind == Value::Kind::Integer)
+			return (a.integer > b.integer) - (a.integer < b.integer);
+		auto x = a.toReal(), y = b.toReal();
+		if (!x || !y)
+			return std::nullopt;
+		if (*x == *y)
+			return 0;
+		double scale = std::max(std::fabs(*x), std::fabs(*y));
+		if (std::fabs(*x - *y) <= scale * 0x1p-40)
+			return std::nullopt;
+		return *x > *y ? 1 : -1;
+	}
+
+	/// Machine integer bound to a variable
+	Value argumentValue(const Expr* value)
+	{
+		if (!value)
+			return {};
+		if (auto n = value->as<mint>())
+			return Value::ofInteger(*n);
+		return {};
+	}
+
+	/// Length of a bound value, or of {value} if lengthOfList
+	/// @note The kernel splices a Sequence into its arguments: Length[{a}] counts its
+	///       elements, and Length[a] gets several arguments (Unknown here)
+	Value lengthValue(const Expr* value, bool lengthOfList)
+	{
+		if (!value)
+			return {};
+		bool isSequence = value->head().sameQ(getExprConstants().sequenceHead);
+		if (lengthOfList)
+			return Value::ofInteger(isSequence ? value->length() : 1);
+		return isSequence ? Value {} : Value::ofInteger(value->length());
+	}
+}; // namespace
+
+std::optional<bool> NativeCondition::evaluate(const Expr* const* args) const
+{
+	std::array<Value, MaxStack> stack;
+	size_t top = 0; // stack[0, top) are live
+
+	for (const auto& instr : code)
+	{
+		switch (instr.op)
+		{
+			case Op::PushInteger:
+				stack[top++] = Value::ofInteger(instr.integer);
+				break;
+			case Op::PushReal:
+				stack[top++] = Value::ofReal(instr.real);
+				break;
+			case Op::PushBool:
+				stack[top++] = Value::ofBoolean(instr.arg != 0);
+				break;
+			case Op::PushArg:
+				stack[top++] = argumentValue(args[instr.arg]);
+				break;
+			case Op::Length:
+			case Op::LengthOfList:
+				stack[top++] = lengthValue(args[instr.arg], instr.op == Op::LengthOfList);
+				break;
+			case Op::Test:
+			{
+				const Expr* value = args[instr.arg];
+				std::optional<bool> result;
+				if (value && !value->head().sameQ(getExprConstants().sequenceHead))
+					result = evalTestIntrinsic(instr.intrinsic, *value);
+				stack[top++] = result ? Value::ofBoolean(*result) : Value {};
+				break;
+			}
+			case Op::Plus:
+			case Op::Times:
+			{
+				size_t first = top - instr.arg;
+				Value acc = stack[first];
+				for (size_t i = first + 1; i < top; ++i)
+					acc = instr.op == Op::Plus ? add(acc, stack[i]) : multiply(acc, stack[i]);
+				top = first;
+				stack[top++] = acc;
+				break;
+			}
+			case Op::Power:
+				top--;
+				stack[top - 1] = power(stack[top - 1], stack[top]);
+				break;
+			case Op::Mod:
+				top--;
+				stack[top - 1] = mod(stack[top - 1], stack[top]);
+				break;
+			case Op::Abs:
+				stack[top - 1] = absolute(stack[top - 1]);
+				break;
+			case Op::Less:
+			case Op::LessEqual:
+			case Op::Greater:
+			case Op::GreaterEqual:
+			case Op::Equal:
+			case Op::Unequal:
+			{
+				top--;
+				auto cmp = order(stack[top - 1], stack[top]);
+				if (!cmp)
+				{
+					stack[top - 1] = {};
+					break;
+				}
+				bool result = false;
+				switch (instr.op)
+				{
+					case Op::Less:
+						result = *cmp < 0;
+						break;
+					case Op::LessEqual:
+						result = *cmp <= 0;
+						break;
+					case Op::Greater:
+						result = *cmp > 0;
+						break;
+					case Op::GreaterEqual:
+						result = *cmp >= 0;
+						break;
+					case Op::Equal:
+						result = *cmp == 0;
+						break;
+					default:
+						result = *cmp != 0;
+						break;
+				}
+				stack[top - 1] = Value::ofBoolean(result);
+				break;
+			}
+			case Op::And:
+			case Op::Or:
+			{
+				// Any False (And) or True (Or) decides, as the kernel short-circuits;
+				// otherwise any operand that is not a boolean leaves it to the kernel
+				bool decisive = instr.op == Op::Or;
+				bool unknown = false;
+				bool decided = false;
+				size_t first = top - instr.arg;
+				for (size_t i = first; i < top; ++i)
+				{
+					if (stack[i].kind != Value::Kind::Boolean)
+						unknown = true;
+					else if (stack[i].boolean == decisive)
+						decided = true;
+				}
+				top = first;
+				stack[top++] = decided ? Value::ofBoolean(decisive) : unknown ? Value {} : Value::ofBoolean(!decisive);
+				break;
+			}
+			case Op::Not:
+				if (stack[top - 1].kind == Value::Kind::Boolean)
+					stack[top - 1].boolean = !stack[top - 1].boolean;
+				else
+					stack[top - 1] = {};
+				break;
+		}
+	}
+
+	if (top != 1 || stack[0].kind != Value::Kind::Boolean)
+		return std::nullopt;
+	return stack[0].boolean;
+}
+}; // namespace PatternMatcher
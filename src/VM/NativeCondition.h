@@ -0,0 +1,102 @@
+#pragma once
+
+#include "VM/TestIntrinsics.h"
+
+#include "AST/MExpr.h"
+#include "Expr.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace PatternMatcher
+{
+/*===========================================================================
+NativeCondition: Conditions Evaluated Without the Kernel
+
+Conditions made of comparisons, arithmetic and boolean connectives over
+pattern variables and numbers (x > 0, a < b <= c, Length[x] == 3,
+x != y && EvenQ[x]) are compiled to a small postfix program that
+EVAL_NATIVE_CONDITION runs against the bound values, instead of building
+Block[{x = v, ...}, cond] and evaluating it in the kernel.
+
+Values are machine integers, machine reals and booleans, plus Unknown for
+anything the program cannot decide exactly the way the kernel would: an
+unbound variable, a value that is not a machine integer, an overflow, or
+reals too close to compare without the kernel's tolerance. A condition
+that evaluates to Unknown is handed to the kernel, so results always agree
+with EVAL_CONDITION.
+
+Supported:
+  numbers, True, False, pattern variables
+  Plus, Times, Power (integer exponent >= 0), Mod, Abs
+  Less, LessEqual, Greater, GreaterEqual, Equal (chained), Unequal, Inequality
+  And, Or, Not
+  Length[x], Length[{x}], and the TestIntrinsics predicates applied to x
+===========================================================================*/
+
+class NativeCondition
+{
+public:
+	/// @brief Compile a condition, if it is inside the supported subset
+	/// @param cond The condition expression
+	/// @param slotOf Variable slot of a pattern variable (lexical name), nullopt for other symbols
+	static std::optional<NativeCondition> compile(const std::shared_ptr<MExpr>& cond,
+												  const std::function<std::optional<size_t>(const std::string&)>& slotOf);
+
+	/// @brief Get the variable slots the condition reads, by argument index
+	const std::vector<size_t>& getSlots() const { return slots; }
+
+	/// @brief Evaluate the condition
+	/// @param args args[i] is the value bound to getSlots()[i], nullptr if unbound
+	/// @return The condition's truth, or std::nullopt if only the kernel can tell
+	std::optional<bool> evaluate(const Expr* const* args) const;
+
+	/// Deepest value stack a program may use (deeper conditions go to the kernel)
+	static constexpr size_t MaxStack = 16;
+
+private:
+	enum class Op : uint8_t
+	{
+		PushInteger, // integer
+		PushReal, // real
+		PushBool, // arg: 0 or 1
+		PushArg, // arg: machine integer value of args[arg]
+		Length, // arg: Length[args[arg]]
+		LengthOfList, // arg: Length[{args[arg]}] (a sequence contributes its elements)
+		Test, // arg: argument, intrinsic: predicate
+		Plus, // arg: operand count
+		Times, // arg: operand count
+		Power,
+		Mod,
+		Abs,
+		Less,
+		LessEqual,
+		Greater,
+		GreaterEqual,
+		Equal,
+		Unequal,
+		And, // arg: operand count
+		Or, // arg: operand count
+		Not
+	};
+
+	struct Instruction
+	{
+		Op op;
+		uint32_t arg = 0;
+		TestIntrinsic intrinsic = TestIntrinsic::IntegerQ;
+		mint integer = 0;
+		double real = 0;
+	};
+
+	std::vector<Instruction> code;
+	std::vector<size_t> slots;
+
+	friend class NativeConditionCompiler;
+};
+}; // namespace PatternMatcher
@@ -11,10 +11,16 @@ const char* opcodeName(Opcode op)
 	{
 		case Opcode::APPLY_TEST:
 			return "APPLY_TEST";
+		case Opcode::TEST_INTRINSIC:
+			return "TEST_INTRINSIC";
 		case Opcode::BEGIN_BLOCK:
 			return "BEGIN_BLOCK";
 		case Opcode::BIND_VAR:
 			return "BIND_VAR";
+		case Opcode::BIND_FROM:
+			return "BIND_FROM";
+		case Opcode::BIND_OR_COMPARE:
+			return "BIND_OR_COMPARE";
 		case Opcode::BRANCH_FALSE:
 			return "BRANCH_FALSE";
 		case Opcode::CUT:
@@ -25,6 +31,8 @@ const char* opcodeName(Opcode op)
 			return "END_BLOCK";
 		case Opcode::EVAL_CONDITION:
 			return "EVAL_CONDITION";
+		case Opcode::EVAL_NATIVE_CONDITION:
+			return "EVAL_NATIVE_CONDITION";
 		case Opcode::EXPORT_BINDINGS:
 			return "EXPORT_BINDINGS";
 		case Opcode::FAIL:
@@ -47,6 +55,12 @@ const char* opcodeName(Opcode op)
 			return "MATCH_LENGTH";
 		case Opcode::MATCH_LITERAL:
 			return "MATCH_LITERAL";
+		case Opcode::MATCH_LITERAL_SET:
+			return "MATCH_LITERAL_SET";
+		case Opcode::MATCH_SHAPE:
+			return "MATCH_SHAPE";
+		case Opcode::MATCH_SHAPE_MIN:
+			return "MATCH_SHAPE_MIN";
 		case Opcode::MATCH_MIN_LENGTH:
 			return "MATCH_MIN_LENGTH";
 		case Opcode::MATCH_SEQ_HEADS:
@@ -55,12 +69,18 @@ const char* opcodeName(Opcode op)
 			return "MAKE_SEQUENCE";
 		case Opcode::SPLIT_SEQ:
 			return "SPLIT_SEQ";
+		case Opcode::SWITCH_ON_HEAD:
+			return "SWITCH_ON_HEAD";
+		case Opcode::SWITCH_ON_LITERAL:
+			return "SWITCH_ON_LITERAL";
 		case Opcode::MOVE:
 			return "MOVE";
 		case Opcode::RETRY:
 			return "RETRY";
 		case Opcode::SAMEQ:
 			return "SAMEQ";
+		case Opcode::SAMEQ_BRANCH:
+			return "SAMEQ_BRANCH";
 		case Opcode::TRUST:
 			return "TRUST";
 		case Opcode::TRY:
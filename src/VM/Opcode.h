@@ -76,7 +76,7 @@ All backtracking instructions manipulate the choice point stack.
                            For index=0, returns the head. */
 
     //=========================================================================
-    // PATTERN MATCHING (3 opcodes)
+    // PATTERN MATCHING (9 opcodes)
     // Test expression properties and branch on failure
     // These are "fused" operations: test + conditional jump
     //=========================================================================
@@ -92,6 +92,14 @@ All backtracking instructions manipulate the choice point stack.
                            Example: MATCH_LENGTH %e0, 2, L_fail
                              jumps to L_fail if the expression doesn't have 2 args
                            Used for: f[x_, y_] (requires exactly 2 arguments) */
+
+    MATCH_SHAPE,     /*  4: reg head len fail  → jump fail if length(reg) != len or head(reg) != head
+                           Test arity and head in one step (MATCH_LENGTH + MATCH_HEAD).
+                           The length is checked first, so most mismatches never
+                           extract the head.
+                           Example: MATCH_SHAPE %e0, f, 2, L_fail
+                             jumps to L_fail unless %e0 is f[_, _]
+                           Used for: f[x_, y_] (the first check of every structured pattern) */
     
     MATCH_LITERAL,   /*  3: reg val fail       → jump fail if reg != val
                            Test if reg matches a literal value exactly.
@@ -100,21 +108,48 @@ All backtracking instructions manipulate the choice point stack.
                              jumps if %e0 is not exactly 5
                            Used for: literal patterns like 5, "hello", Pi */
 
+    MATCH_LITERAL_SET, /*  3: reg set fail     → jump fail if reg is not in set
+                           Test if reg is one of a set of literal values (SameQ semantics)
+                           in O(1): machine integers, strings and symbols are hashed.
+                           The set is PatternBytecode::getLiteralSets()[set].
+                           Example: MATCH_LITERAL_SET %e0, 0, L_fail
+                             with set 0 = {"GET", "PUT", "POST"}
+                           Used for: alternatives of literals like "GET" | "PUT" | "POST" */
+
     APPLY_TEST,      /*  3: reg test fail      → jump fail if !test(reg)
                            Apply a pattern test to reg and jump to fail if it doesn't return true.
                            Example: APPLY_TEST %e0, IntegerQ, L_fail
                              jumps if %e0 does not return true for the IntegerQ test
                            Used for: type patterns like IntegerQ, RealQ, StringQ */
 
-    EVAL_CONDITION,  /*  2: cond fail          → jump fail if eval(cond) != True
+    TEST_INTRINSIC,  /*  4: reg id test fail   → jump fail if !intrinsic[id](reg)
+                           APPLY_TEST for a predicate evaluated natively (see TestIntrinsics.h).
+                           test is the original predicate: the kernel evaluates test[reg]
+                           when the native check cannot decide (e.g. Positive[Pi]).
+                           Example: TEST_INTRINSIC %e0, 3, EvenQ, L_fail
+                             jumps if %e0 is not an even integer
+                           Used for: _?IntegerQ, _Integer?Positive, x_?ListQ */
+
+    EVAL_CONDITION,  /*  3: cond idx fail      → jump fail if eval(cond) != True
                            Evaluate arbitrary WL expression and test if result is True.
-                           Condition may reference pattern variables bound in current frame.
-                           Example: EVAL_CONDITION x > 0, L_fail
-                             evaluates x > 0 and jumps if result is not True
-                           Used for: Condition patterns like x_Integer /; x > 0 */
+                           Condition may reference pattern variables bound in current frame;
+                           it is evaluated in Block[{x = value, ...}, cond] over the ones it
+                           references, PatternBytecode::getConditions()[idx].
+                           Example: EVAL_CONDITION PrimeQ[x], 0, L_fail
+                             evaluates PrimeQ[x] and jumps if result is not True
+                           Used for: Condition patterns like x_Integer /; PrimeQ[x] */
+
+    EVAL_NATIVE_CONDITION, /*  3: cond idx fail → jump fail if cond is not True
+                           EVAL_CONDITION for a condition compiled to native code
+                           (see NativeCondition.h), PatternBytecode::getConditions()[idx].
+                           cond is the original condition: the kernel evaluates it
+                           when the native code cannot decide (e.g. x > 0 with x = Pi).
+                           Example: EVAL_NATIVE_CONDITION x > 0, 0, L_fail
+                             jumps if x is not a positive number
+                           Used for: x_ /; x > 0, {a_, b_} /; a < b, x_ /; Length[x] == 3 */
 
     //=========================================================================
-    // SEQUENCE MATCHING (4 opcodes)
+    // SEQUENCE MATCHING (5 opcodes)
     // Match variable-length sequences of expressions
     //=========================================================================
     
@@ -123,6 +158,12 @@ All backtracking instructions manipulate the choice point stack.
                            Example: MATCH_MIN_LENGTH %e0, 1, L_fail
                              jumps if %e0 has 0 parts (for __)
                            Used for: __ (min=1), ___ (min=0) */
+
+    MATCH_SHAPE_MIN, /*  4: reg head minLen fail → jump fail if length(reg) < minLen or head(reg) != head
+                           Test minimum arity and head in one step (MATCH_MIN_LENGTH + MATCH_HEAD).
+                           Example: MATCH_SHAPE_MIN %e0, List, 2, L_fail
+                             jumps to L_fail unless %e0 is a List with at least 2 parts
+                           Used for: {a_, b__} and other structured patterns with sequences */
     
     MATCH_SEQ_HEADS, /*  5: reg start endreg head fail → jump fail if any part has wrong head
                            Test if all parts in range [start, end] have given head.
@@ -137,24 +178,26 @@ All backtracking instructions manipulate the choice point stack.
                              %e2 = List[%e0[[1]], %e0[[2]], %e0[[3]]]
                            Used for: Binding sequence variables like a__ */
     
-    SPLIT_SEQ,       /*  5: src splitPos minRest nextLabel fail → create split choice point
-                           Create choice point for sequence splitting.
-                           - src: expression being split
-                           - splitPos: where to split (how many go to first seq)
-                           - minRest: minimum elements for remaining patterns
-                           - nextLabel: where to try next split on backtrack
-                           - fail: where to jump if no valid splits exist
-                           
-                           On backtrack: decrements splitPos and retries
-                           
-                           Example: {a__, b_} matching {1,2,3} (length=3)
-                             Try splitPos=2: a={1,2}, b=3
-                             Backtrack: splitPos=1: a={1}, b=2 (then 3 fails)
-                           
-                           Used for: Patterns with sequences like {a__, b_, c__} */
+    SPLIT_SEQ,       /*  4: dest rest minLen minRest → split rest between two segments [saves state]
+                           dest := Sequence of the first n parts of rest,
+                           rest := Sequence of the remaining parts (in place).
+                           - minLen: fewest parts the segment in dest takes
+                           - minRest: fewest parts the segments after it need
+                           n runs from minLen up to Length[rest] - minRest,
+                           shortest first. While longer splits remain, a
+                           choice point retries the next n on backtracking
+                           (and is removed at the last one). With no valid
+                           n the instruction fails like FAIL.
+
+                           Example: {a__, b__} matching {1,2,3}
+                             SPLIT_SEQ %e2, %e1, 1, 1
+                             first  %e2 = Sequence[1],    %e1 = Sequence[2, 3]
+                             retry  %e2 = Sequence[1, 2], %e1 = Sequence[3]
+
+                           Used for: Patterns with several sequences like {a__, b_, c__} */
 
     //=========================================================================
-    // COMPARISON (1 opcode)
+    // COMPARISON (2 opcodes)
     // Compute equality between expressions
     //=========================================================================
     
@@ -164,8 +207,16 @@ All backtracking instructions manipulate the choice point stack.
                            Used for: repeated variable checks (f[x_, x_])
                            Example: SAMEQ %b1, %e3, %e0  tests if %e3 equals %e0 */
 
+    SAMEQ_BRANCH,    /*  3: lhs rhs fail       → jump fail if !(lhs === rhs)
+                           SAMEQ + BRANCH_FALSE in one step, without the boolean register
+                           (emitted by the optimizer when the register is not read again).
+                           Like BRANCH_FALSE, the jump is not a failure transfer.
+                           Example: SAMEQ_BRANCH %e3, %e0, L_fail
+                             jumps to L_fail unless %e3 equals %e0
+                           Used for: repeated variable checks (f[x_, x_]) */
+
     //=========================================================================
-    // VARIABLE BINDING (2 opcodes)
+    // VARIABLE BINDING (4 opcodes)
     // Bind and load pattern variables
     //=========================================================================
     
@@ -185,8 +236,23 @@ All backtracking instructions manipulate the choice point stack.
                              loads the value of x into %e3
                            Used for: Retrieving variables bound in alternatives */
 
+    BIND_FROM,       /*  3: dest src name      → dest := src; bind(name, src) [trails]
+                           MOVE + BIND_VAR in one step (emitted by the optimizer).
+                           Example: BIND_FROM %e2, %e3, "Global`x"
+                             copies %e3 to %e2 and binds x to it
+                           Used for: the first binding of a repeated variable */
+
+    BIND_OR_COMPARE, /*  4: var src name fail  → bind if var is unbound, else compare [trails]
+                           The whole bind-or-compare sequence of a repeated variable
+                           (emitted by the optimizer):
+                             var is $$Failure → var := src; bind(name, src)
+                             otherwise        → jump fail if !(var === src)
+                           Like BRANCH_FALSE, the jump is not a failure transfer.
+                           Example: BIND_OR_COMPARE %e1, %e2, "Global`x", L_fail
+                           Used for: f[x_, x_], {x_, _, x_} */
+
     //=========================================================================
-    // CONTROL FLOW (3 opcodes)
+    // CONTROL FLOW (5 opcodes)
     // Jump and halt instructions
     //=========================================================================
     
@@ -200,6 +266,21 @@ All backtracking instructions manipulate the choice point stack.
                            Example: BRANCH_FALSE %b1, L_fail
                              jumps to L_fail if %b1 contains false
                            Used for: repeated variable failure (f[x_, x_]) */
+
+    SWITCH_ON_HEAD,  /*  3: reg table default  → jump table[head(reg)], else default
+                           Multi-way branch on the head of reg through a jump table
+                           (PatternBytecode::getSwitchTables, indexed by the table operand).
+                           Keys are compared with SameQ; the first equal key wins.
+                           Example: SWITCH_ON_HEAD %e0, 0, L_default
+                             with table 0 = {f → L1, g → L2}
+                           Used for: f[__] | g[_] | h[_, _] (only alternatives with
+                           the input's head are tried) */
+
+    SWITCH_ON_LITERAL, /*  3: reg table default → jump table[reg], else default
+                           Multi-way branch on the value of reg (SameQ) through a jump table.
+                           Example: SWITCH_ON_LITERAL %e0, 1, L_fail
+                             with table 1 = {0 → L3, 1 → L4}
+                           Used for: 0 | 1 | 2 (literal alternatives with a common head) */
     
     HALT,            /*  0:                    → stop execution
                            Stops the VM and returns control to caller.
@@ -292,6 +373,9 @@ All backtracking instructions manipulate the choice point stack.
 };
 // clang-format on
 
+/// Number of opcodes (DEBUG_PRINT must stay the last enumerator)
+inline constexpr size_t OpcodeCount = static_cast<size_t>(Opcode::DEBUG_PRINT) + 1;
+
 //=============================================================================
 // Opcode Metadata and Categorization
 //=============================================================================
@@ -302,11 +386,11 @@ enum class OpcodeCategory
 {
 	DataMovement, // MOVE, LOAD_IMM
 	Introspection, // GET_PART, GET_LENGTH
-	ConditionalMatch, // MATCH_HEAD, MATCH_LENGTH, MATCH_LITERAL (test + branch)
-	SequenceMatching, // MATCH_MIN_LENGTH, MATCH_SEQ_HEADS, MAKE_SEQUENCE, SPLIT_SEQ
-	Comparison, // SAMEQ
-	Binding, // BIND_VAR, LOAD_VAR
-	ControlFlow, // JUMP, BRANCH_FALSE, HALT
+	ConditionalMatch, // MATCH_HEAD, MATCH_LENGTH, MATCH_SHAPE, MATCH_LITERAL, MATCH_LITERAL_SET (test + branch)
+	SequenceMatching, // MATCH_MIN_LENGTH, MATCH_SHAPE_MIN, MATCH_SEQ_HEADS, MAKE_SEQUENCE, SPLIT_SEQ
+	Comparison, // SAMEQ, SAMEQ_BRANCH
+	Binding, // BIND_VAR, LOAD_VAR, BIND_FROM, BIND_OR_COMPARE
+	ControlFlow, // JUMP, BRANCH_FALSE, SWITCH_ON_HEAD, SWITCH_ON_LITERAL, HALT
 	ScopeManagement, // BEGIN_BLOCK, END_BLOCK, EXPORT_BINDINGS
 	Backtracking, // TRY, RETRY, TRUST, CUT, FAIL
 	Debug // DEBUG_PRINT
@@ -331,14 +415,19 @@ inline OpcodeCategory getOpcodeCategory(Opcode op)
 
 		// Conditional matching (fused test + branch)
 		case Opcode::APPLY_TEST:
+		case Opcode::TEST_INTRINSIC:
 		case Opcode::EVAL_CONDITION:
+		case Opcode::EVAL_NATIVE_CONDITION:
 		case Opcode::MATCH_HEAD:
 		case Opcode::MATCH_LENGTH:
+		case Opcode::MATCH_SHAPE:
 		case Opcode::MATCH_LITERAL:
+		case Opcode::MATCH_LITERAL_SET:
 			return OpcodeCategory::ConditionalMatch;
 
 		// Sequence matching
 		case Opcode::MATCH_MIN_LENGTH:
+		case Opcode::MATCH_SHAPE_MIN:
 		case Opcode::MATCH_SEQ_HEADS:
 		case Opcode::MAKE_SEQUENCE:
 		case Opcode::SPLIT_SEQ:
@@ -346,16 +435,21 @@ inline OpcodeCategory getOpcodeCategory(Opcode op)
 
 		// Comparisons
 		case Opcode::SAMEQ:
+		case Opcode::SAMEQ_BRANCH:
 			return OpcodeCategory::Comparison;
 
 		// Variable binding
 		case Opcode::BIND_VAR:
 		case Opcode::LOAD_VAR:
+		case Opcode::BIND_FROM:
+		case Opcode::BIND_OR_COMPARE:
 			return OpcodeCategory::Binding;
 
 		// Control flow
 		case Opcode::JUMP:
 		case Opcode::BRANCH_FALSE:
+		case Opcode::SWITCH_ON_HEAD:
+		case Opcode::SWITCH_ON_LITERAL:
 		case Opcode::HALT:
 			return OpcodeCategory::ControlFlow;
 
@@ -395,11 +489,17 @@ inline bool isControlFlow(Opcode op)
 /// @return true if the opcode can jump to a different label
 ///
 /// Note: This includes both unconditional jumps (JUMP) and conditional
-/// branches (BRANCH_FALSE, MATCH_*, FAIL). Used for control flow analysis.
+/// branches (BRANCH_FALSE, SAMEQ_BRANCH, BIND_OR_COMPARE, SWITCH_*, MATCH_*, FAIL).
+/// Used for control flow analysis.
 inline bool isBranch(Opcode op)
 {
-	return op == Opcode::JUMP || op == Opcode::APPLY_TEST || op == Opcode::EVAL_CONDITION || op == Opcode::BRANCH_FALSE 
-		|| op == Opcode::MATCH_HEAD || op == Opcode::MATCH_LENGTH || op == Opcode::MATCH_LITERAL || op == Opcode::FAIL;
+	return op == Opcode::JUMP || op == Opcode::SWITCH_ON_HEAD || op == Opcode::SWITCH_ON_LITERAL
+		|| op == Opcode::APPLY_TEST || op == Opcode::TEST_INTRINSIC || op == Opcode::EVAL_CONDITION
+		|| op == Opcode::EVAL_NATIVE_CONDITION || op == Opcode::BRANCH_FALSE || op == Opcode::SAMEQ_BRANCH
+		|| op == Opcode::BIND_OR_COMPARE || op == Opcode::MATCH_HEAD || op == Opcode::MATCH_LENGTH
+		|| op == Opcode::MATCH_SHAPE || op == Opcode::MATCH_MIN_LENGTH || op == Opcode::MATCH_SHAPE_MIN
+		|| op == Opcode::MATCH_SEQ_HEADS || op == Opcode::MATCH_LITERAL || op == Opcode::MATCH_LITERAL_SET
+		|| op == Opcode::FAIL;
 }
 
 /// @brief Check if opcode has side effects beyond register writes
@@ -414,6 +514,8 @@ inline bool hasSideEffects(Opcode op)
 	{
 		// Binding creates trail entries
 		case Opcode::BIND_VAR:
+		case Opcode::BIND_FROM:
+		case Opcode::BIND_OR_COMPARE:
 
 		// Scope operations modify frame stack
 		case Opcode::BEGIN_BLOCK:
@@ -439,6 +541,41 @@ inline bool hasSideEffects(Opcode op)
 	}
 }
 
+/// @brief Check if an opcode writes a register through its first operand
+/// @param op The opcode to check
+/// @return true if operand 0 is a destination register (every other register operand is read)
+///
+/// Used by register liveness analysis (see AnalyzePatternBytecode.h).
+inline bool writesFirstOperand(Opcode op)
+{
+	switch (op)
+	{
+		case Opcode::MOVE:
+		case Opcode::LOAD_IMM:
+		case Opcode::GET_LENGTH:
+		case Opcode::GET_PART:
+		case Opcode::MAKE_SEQUENCE:
+		case Opcode::SPLIT_SEQ: // Also rewrites operand 1 (see getRegisterAccess)
+		case Opcode::SAMEQ:
+		case Opcode::LOAD_VAR:
+		case Opcode::BIND_FROM:
+		case Opcode::BIND_OR_COMPARE: // Only when binding; also reads operand 0 (see getRegisterAccess)
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+/// @brief Check if execution can continue with the next instruction
+/// @param op The opcode to check
+/// @return false for unconditional transfers (JUMP, SWITCH_*, FAIL) and HALT
+inline bool fallsThrough(Opcode op)
+{
+	return op != Opcode::JUMP && op != Opcode::SWITCH_ON_HEAD && op != Opcode::SWITCH_ON_LITERAL
+		&& op != Opcode::FAIL && op != Opcode::HALT;
+}
+
 /// @brief Get number of operands for an opcode
 /// @param op The opcode
 /// @return Number of operands expected
@@ -472,7 +609,6 @@ inline size_t getOperandCount(Opcode op)
 		case Opcode::BIND_VAR:
 		case Opcode::LOAD_VAR:
 		case Opcode::GET_LENGTH:
-		case Opcode::EVAL_CONDITION:
 			return 2;
 
 		// 3 operands
@@ -481,17 +617,28 @@ inline size_t getOperandCount(Opcode op)
 		case Opcode::MATCH_HEAD:
 		case Opcode::MATCH_LENGTH:
 		case Opcode::MATCH_LITERAL:
+		case Opcode::MATCH_LITERAL_SET:
+		case Opcode::EVAL_CONDITION:
+		case Opcode::EVAL_NATIVE_CONDITION:
 		case Opcode::MATCH_MIN_LENGTH:
 		case Opcode::SAMEQ:
+		case Opcode::SAMEQ_BRANCH:
+		case Opcode::BIND_FROM:
+		case Opcode::SWITCH_ON_HEAD:
+		case Opcode::SWITCH_ON_LITERAL:
 			return 3;
 
 		// 4 operands
+		case Opcode::TEST_INTRINSIC:
+		case Opcode::MATCH_SHAPE:
+		case Opcode::MATCH_SHAPE_MIN:
 		case Opcode::MAKE_SEQUENCE:
+		case Opcode::SPLIT_SEQ:
+		case Opcode::BIND_OR_COMPARE:
 			return 4;
 
 		// 5 operands
 		case Opcode::MATCH_SEQ_HEADS:
-		case Opcode::SPLIT_SEQ:
 			return 5;
 
 		default:
@@ -521,40 +668,60 @@ inline const char* getOpcodeDescription(Opcode op)
 		// Pattern matching
 		case Opcode::APPLY_TEST:
 			return "Apply pattern test and branch on failure";
+		case Opcode::TEST_INTRINSIC:
+			return "Apply a native pattern test and branch on failure";
 		case Opcode::EVAL_CONDITION:
 			return "Evaluate condition and branch on failure";
+		case Opcode::EVAL_NATIVE_CONDITION:
+			return "Evaluate a native condition and branch on failure";
 		case Opcode::MATCH_HEAD:
 			return "Match head and branch on failure";
 		case Opcode::MATCH_LENGTH:
 			return "Match argument count and branch on failure";
+		case Opcode::MATCH_SHAPE:
+			return "Match argument count and head and branch on failure";
 		case Opcode::MATCH_LITERAL:
 			return "Match literal value and branch on failure";
+		case Opcode::MATCH_LITERAL_SET:
+			return "Match one of a set of literal values and branch on failure";
 
 		// Sequence matching
 		case Opcode::MATCH_MIN_LENGTH:
 			return "Test minimum sequence length";
+		case Opcode::MATCH_SHAPE_MIN:
+			return "Test minimum length and head and branch on failure";
 		case Opcode::MATCH_SEQ_HEADS:
 			return "Match heads of sequence elements";
 		case Opcode::MAKE_SEQUENCE:
 			return "Extract and wrap subsequence";
 		case Opcode::SPLIT_SEQ:
-			return "Create split choice point for sequences";
+			return "Split a sequence between two segments (choice point over lengths)";
 
 		// Comparison
 		case Opcode::SAMEQ:
 			return "Test structural equality";
+		case Opcode::SAMEQ_BRANCH:
+			return "Test structural equality and branch on failure";
 
 		// Binding
 		case Opcode::BIND_VAR:
 			return "Bind pattern variable";
 		case Opcode::LOAD_VAR:
 			return "Load bound variable value";
+		case Opcode::BIND_FROM:
+			return "Copy a register and bind pattern variable to it";
+		case Opcode::BIND_OR_COMPARE:
+			return "Bind an unbound repeated variable, or compare and branch on failure";
 
 		// Control flow
 		case Opcode::JUMP:
 			return "Unconditional jump";
 		case Opcode::BRANCH_FALSE:
 			return "Jump if condition is false";
+		case Opcode::SWITCH_ON_HEAD:
+			return "Jump through a table keyed by head";
+		case Opcode::SWITCH_ON_LITERAL:
+			return "Jump through a table keyed by value";
 		case Opcode::HALT:
 			return "Stop execution";
 
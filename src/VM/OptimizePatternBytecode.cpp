@@ -1,6 +1,14 @@
 #include "VM/OptimizePatternBytecode.h"
+#include "VM/AnalyzePatternBytecode.h"
 #include "VM/Opcode.h"
 
+#include <algorithm>
+#include <numeric>
+#include <optional>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
 namespace PatternMatcher::BytecodeOptimizer
 {
 
@@ -9,45 +17,763 @@ namespace PatternMatcher::BytecodeOptimizer
  *
  * Detects pattern where a boolean is set to true (non-zero) and then
  * immediately used in BRANCH_FALSE. Since the branch condition is
- * always false, the branch never executes - remove both instructions.
+ * always false, the branch never executes and is removed.
  *
- * This is SAFE because:
- *   - LOAD_IMM only appears in epilogue blocks (success/fail handlers)
- *   - BRANCH_FALSE immediately follows compiler-generated SAMEQ
- *   - These sequences are atomic and never have labels between them
- *   - The compiler never generates labels pointing to these instructions
+ * The LOAD_IMM stays: the register may be read later, and an unread one
+ * is left to dead-register elimination. The BRANCH_FALSE must be in the
+ * LOAD_IMM's basic block, so no jump can reach it with another value.
  *
  * Pattern: LOAD_IMM %b, <non-zero>
  *          BRANCH_FALSE %b, L
  */
 bool eliminateDeadBranches(PatternBytecode& bc)
 {
+	const auto& instrs = bc.getInstructions();
+	auto cfg = BytecodeAnalysis::buildControlFlowGraph(bc);
+	std::vector<bool> remove(instrs.size(), false);
 	bool changed = false;
-	auto& instrs = bc.getInstructions();
 
-	for (size_t i = 0; i + 1 < instrs.size();)
+	for (size_t i = 0; i + 1 < instrs.size(); ++i)
 	{
 		// Look for: LOAD_IMM %b, <non-zero> followed by BRANCH_FALSE %b, L
-		if (instrs[i].opcode == Opcode::LOAD_IMM && instrs[i + 1].opcode == Opcode::BRANCH_FALSE)
+		if (instrs[i].opcode != Opcode::LOAD_IMM || instrs[i + 1].opcode != Opcode::BRANCH_FALSE
+			|| cfg.blockOf[i] != cfg.blockOf[i + 1])
+			continue;
+
+		auto dstBool = std::get_if<BoolRegOp>(&instrs[i].ops[0]);
+		auto immMint = std::get_if<ImmMint>(&instrs[i].ops[1]);
+		auto jumpBool = std::get_if<BoolRegOp>(&instrs[i + 1].ops[0]);
+
+		// Same register and the immediate is non-zero (true): the branch is never taken
+		if (dstBool && immMint && jumpBool && (dstBool->v == jumpBool->v) && (immMint->v != 0))
+		{
+			remove[i + 1] = true;
+			changed = true;
+		}
+	}
+
+	if (changed)
+		bc.eraseInstructions(remove);
+	return changed;
+}
+
+/*===========================================================================
+ Common Extractions
+===========================================================================*/
+
+namespace
+{
+	/// Operand equality, with expressions compared by SameQ
+	bool sameOperand(const Operand& a, const Operand& b)
+	{
+		if (a.index() != b.index())
+			return false;
+		if (auto* e = std::get_if<ImmExpr>(&a))
+			return e->sameQ(std::get<ImmExpr>(b));
+		if (auto* r = std::get_if<ExprRegOp>(&a))
+			return *r == std::get<ExprRegOp>(b);
+		if (auto* r = std::get_if<BoolRegOp>(&a))
+			return *r == std::get<BoolRegOp>(b);
+		if (auto* l = std::get_if<LabelOp>(&a))
+			return *l == std::get<LabelOp>(b);
+		if (auto* i = std::get_if<ImmMint>(&a))
+			return *i == std::get<ImmMint>(b);
+		if (auto* id = std::get_if<Ident>(&a))
+			return *id == std::get<Ident>(b);
+		return true; // std::monostate
+	}
+
+	bool isExtraction(Opcode op)
+	{
+		return op == Opcode::GET_PART || op == Opcode::GET_LENGTH;
+	}
+
+	/// Checks on a register that only read it and branch to their last operand on failure
+	bool isHoistableCheck(Opcode op)
+	{
+		switch (op)
 		{
-			// Extract operands safely
-			auto dstBool = std::get_if<BoolRegOp>(&instrs[i].ops[0]);
-			auto immMint = std::get_if<ImmMint>(&instrs[i].ops[1]);
-			auto jumpBool = std::get_if<BoolRegOp>(&instrs[i + 1].ops[0]);
+			case Opcode::MATCH_HEAD:
+			case Opcode::MATCH_LENGTH:
+			case Opcode::MATCH_SHAPE:
+			case Opcode::MATCH_MIN_LENGTH:
+			case Opcode::MATCH_SHAPE_MIN:
+			case Opcode::MATCH_LITERAL:
+				return true;
+			default:
+				return false;
+		}
+	}
+
+	/// Same extraction (GET_PART src, index / GET_LENGTH src), whatever the destination
+	bool sameExtraction(const PatternBytecode::Instruction& a, const PatternBytecode::Instruction& b)
+	{
+		if (a.opcode != b.opcode)
+			return false;
+		for (size_t i = 1; i < a.ops.size(); ++i)
+			if (!sameOperand(a.ops[i], b.ops[i]))
+				return false;
+		return true;
+	}
+
+	/// Same check, whatever the failure target
+	bool sameCheck(const PatternBytecode::Instruction& a, const PatternBytecode::Instruction& b)
+	{
+		if (a.opcode != b.opcode || a.ops.size() != b.ops.size())
+			return false;
+		for (size_t i = 0; i + 1 < a.ops.size(); ++i)
+			if (!sameOperand(a.ops[i], b.ops[i]))
+				return false;
+		return true;
+	}
+
+	ExprRegIndex exprReg(const PatternBytecode::Instruction& instr, size_t i)
+	{
+		return std::get<ExprRegOp>(instr.ops[i]).v;
+	}
+
+	/// Where each expression register is written: none (%e0, the subject), one PC, or several
+	struct Definitions
+	{
+		static constexpr size_t Several = static_cast<size_t>(-1);
+		std::vector<size_t> count;
+		std::vector<size_t> pc; ///< The writing PC of a register written once
 
-			// Check if same register and immediate is non-zero (true)
-			if (dstBool && immMint && jumpBool && (dstBool->v == jumpBool->v) && (immMint->v != 0))
+		explicit Definitions(const PatternBytecode& bc)
+		{
+			const auto& instrs = bc.getInstructions();
+			count.assign(static_cast<size_t>(bc.getExprRegisterCount()), 0);
+			pc.assign(count.size(), Several);
+			for (size_t i = 0; i < instrs.size(); ++i)
 			{
-				// Dead code: branch never taken
-				// Safe to remove - these are compiler-generated sequences that never have labels
-				instrs.erase(instrs.begin() + i, instrs.begin() + i + 2);
+				for (auto r : BytecodeAnalysis::getRegisterAccess(instrs[i]).exprWrites)
+				{
+					count[r]++;
+					pc[r] = count[r] == 1 ? i : Several;
+				}
+			}
+		}
+
+		bool writtenOnce(ExprRegIndex r) const { return count[r] == 1; }
+
+		/// The register holds the same value everywhere from atPC on
+		bool fixedAt(ExprRegIndex r, size_t atPC, const BytecodeAnalysis::Dominators& dom) const
+		{
+			return count[r] == 0 || (count[r] == 1 && pc[r] != atPC && dom.dominates(pc[r], atPC));
+		}
+	};
+
+	/// Rename expression register from to to everywhere
+	void renameExprRegister(PatternBytecode& bc, ExprRegIndex from, ExprRegIndex to)
+	{
+		std::vector<size_t> exprMap(static_cast<size_t>(bc.getExprRegisterCount()));
+		std::iota(exprMap.begin(), exprMap.end(), 0);
+		std::vector<size_t> boolMap(static_cast<size_t>(bc.getBoolRegisterCount()));
+		std::iota(boolMap.begin(), boolMap.end(), 0);
+		exprMap[from] = to;
+		bc.renameRegisters(exprMap, boolMap);
+	}
+
+	/// First instruction of each alternative of the TRY at tryPC, past its TRY/RETRY/TRUST and BEGIN_BLOCKs
+	/// @return Empty unless each of them is reached only from its alternative's start
+	std::vector<size_t> alternativeBodies(const PatternBytecode& bc, size_t tryPC,
+										  const std::vector<std::vector<size_t>>& preds)
+	{
+		const auto& instrs = bc.getInstructions();
+		const auto& labelMap = bc.getLabelMap();
+		std::vector<size_t> bodies;
+
+		size_t start = tryPC;
+		const PatternBytecode::Instruction* choice = &instrs[tryPC];
+		while (true)
+		{
+			size_t pc = start + 1;
+			while (pc < instrs.size() && instrs[pc].opcode == Opcode::BEGIN_BLOCK)
+				++pc;
+			if (pc >= instrs.size())
+				return {};
+			for (size_t p = start + 1; p <= pc; ++p)
+				if (preds[p].size() != 1 || preds[p][0] != p - 1)
+					return {};
+			bodies.push_back(pc);
+
+			if (choice->opcode == Opcode::TRUST)
+				return bodies;
+			auto it = labelMap.find(std::get<LabelOp>(choice->ops[0]).v);
+			if (it == labelMap.end() || it->second >= instrs.size())
+				return {};
+			start = it->second;
+			choice = &instrs[start];
+			if (choice->opcode != Opcode::RETRY && choice->opcode != Opcode::TRUST)
+				return {};
+		}
+	}
+
+	/// Hoist the first instruction of the alternatives of the TRY at tryPC, if they all agree
+	bool hoistAlternativeInstruction(PatternBytecode& bc, size_t tryPC)
+	{
+		auto preds = BytecodeAnalysis::getPredecessors(bc);
+		auto bodies = alternativeBodies(bc, tryPC, preds);
+		if (bodies.size() < 2)
+			return false;
+
+		const auto& instrs = bc.getInstructions();
+		const auto& first = instrs[bodies[0]];
+		bool extraction = isExtraction(first.opcode);
+		if (!extraction && !isHoistableCheck(first.opcode))
+			return false;
+		for (auto pc : bodies)
+			if (extraction ? !sameExtraction(first, instrs[pc]) : !sameCheck(first, instrs[pc]))
+				return false;
+
+		// What it reads must already be computed at the TRY
+		Definitions defs(bc);
+		auto dom = BytecodeAnalysis::computeDominators(bc);
+		if (!defs.fixedAt(exprReg(first, extraction ? 1 : 0), tryPC, dom))
+			return false;
+
+		auto hoisted = first;
+		if (extraction)
+		{
+			// Every alternative reads the hoisted register instead of its own
+			for (auto pc : bodies)
+				if (!defs.writtenOnce(exprReg(instrs[pc], 0)))
+					return false;
+			ExprRegIndex dst = exprReg(first, 0);
+			std::vector<ExprRegIndex> others;
+			for (size_t i = 1; i < bodies.size(); ++i)
+				others.push_back(exprReg(instrs[bodies[i]], 0));
+			for (auto r : others)
+				renameExprRegister(bc, r, dst);
+		}
+		else
+		{
+			hoisted.ops.back() = instrs[bodies.back()].ops.back();
+		}
+
+		std::vector<bool> remove(instrs.size(), false);
+		for (auto pc : bodies)
+			remove[pc] = true;
+		bc.eraseInstructions(remove);
+		bc.insertInstruction(tryPC, std::move(hoisted));
+		return true;
+	}
+}; // namespace
+
+bool hoistCommonAlternativePrefix(PatternBytecode& bc)
+{
+	bool changed = false;
+	const auto& instrs = bc.getInstructions();
+	for (size_t pc = 0; pc < instrs.size(); ++pc)
+	{
+		if (instrs[pc].opcode != Opcode::TRY)
+			continue;
+		// Each hoisted instruction lands before the TRY, which moves down by one
+		while (hoistAlternativeInstruction(bc, pc))
+		{
+			++pc;
+			changed = true;
+		}
+	}
+	return changed;
+}
+
+bool eliminateCommonExtractions(PatternBytecode& bc)
+{
+	const auto& instrs = bc.getInstructions();
+	auto dom = BytecodeAnalysis::computeDominators(bc);
+	Definitions defs(bc);
+
+	// Visit dominators before the instructions they dominate
+	std::vector<size_t> depth(instrs.size(), 0);
+	std::vector<size_t> order;
+	for (size_t pc = 0; pc < instrs.size(); ++pc)
+	{
+		if (dom.idom[pc] == BytecodeAnalysis::Dominators::None || !isExtraction(instrs[pc].opcode))
+			continue;
+		for (size_t p = pc; dom.idom[p] != p; p = dom.idom[p])
+			depth[pc]++;
+		order.push_back(pc);
+	}
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return depth[a] < depth[b]; });
+
+	std::vector<size_t> exprMap(static_cast<size_t>(bc.getExprRegisterCount()));
+	std::iota(exprMap.begin(), exprMap.end(), 0);
+	std::vector<bool> remove(instrs.size(), false);
+	std::vector<size_t> kept;
+	bool changed = false;
+
+	for (auto pc : order)
+	{
+		auto instr = instrs[pc];
+		ExprRegIndex dst = exprReg(instr, 0);
+		ExprRegIndex src = exprMap[exprReg(instr, 1)];
+		instr.ops[1] = OpExprReg(src);
+		if (!defs.writtenOnce(dst) || defs.count[src] > 1)
+			continue;
+
+		auto it = std::find_if(kept.begin(), kept.end(), [&](size_t q) {
+			auto earlier = instrs[q];
+			earlier.ops[1] = OpExprReg(exprMap[exprReg(earlier, 1)]);
+			return sameExtraction(earlier, instr) && dom.dominates(q, pc);
+		});
+		if (it == kept.end())
+		{
+			kept.push_back(pc);
+			continue;
+		}
+		exprMap[dst] = exprReg(instrs[*it], 0);
+		remove[pc] = true;
+		changed = true;
+	}
+
+	if (changed)
+	{
+		std::vector<size_t> boolMap(static_cast<size_t>(bc.getBoolRegisterCount()));
+		std::iota(boolMap.begin(), boolMap.end(), 0);
+		bc.renameRegisters(exprMap, boolMap);
+		bc.eraseInstructions(remove);
+	}
+	return changed;
+}
+
+/*===========================================================================
+ Jump Threading
+===========================================================================*/
+
+namespace
+{
+	/// Transfers that are not failures: END_BLOCK reached through them merges its frame
+	bool isPlainTransfer(Opcode op)
+	{
+		return op == Opcode::JUMP || op == Opcode::BRANCH_FALSE || op == Opcode::SAMEQ_BRANCH
+			|| op == Opcode::BIND_OR_COMPARE || op == Opcode::SWITCH_ON_HEAD || op == Opcode::SWITCH_ON_LITERAL;
+	}
+
+	/// Label operands that name where control goes (not a scope, not an alternative)
+	bool hasThreadableLabels(Opcode op)
+	{
+		return op != Opcode::BEGIN_BLOCK && op != Opcode::END_BLOCK && op != Opcode::TRY && op != Opcode::RETRY;
+	}
+
+	/// Follow the JUMPs starting at L to the label of the last one
+	/// @note A failure transfer stops at a JUMP to END_BLOCK: reached by failure,
+	///       END_BLOCK would discard the frame it merges when reached by the JUMP
+	Label threadLabel(const PatternBytecode& bc, Label L, bool failure)
+	{
+		const auto& instrs = bc.getInstructions();
+		const auto& labelMap = bc.getLabelMap();
+		for (size_t hops = 0; hops < instrs.size(); ++hops)
+		{
+			auto it = labelMap.find(L);
+			if (it == labelMap.end() || it->second >= instrs.size() || instrs[it->second].opcode != Opcode::JUMP)
+				break;
+			Label next = std::get<LabelOp>(instrs[it->second].ops[0]).v;
+			auto nextIt = labelMap.find(next);
+			if (nextIt == labelMap.end() || nextIt->second >= instrs.size())
+				break;
+			if (failure && instrs[nextIt->second].opcode == Opcode::END_BLOCK)
+				break;
+			L = next;
+		}
+		return L;
+	}
+}; // namespace
+
+bool threadJumps(PatternBytecode& bc)
+{
+	auto& instrs = bc.getInstructions();
+	const auto& labelMap = bc.getLabelMap();
+	auto targetOf = [&](Label L) {
+		auto it = labelMap.find(L);
+		return it == labelMap.end() ? instrs.size() : it->second;
+	};
+	bool changed = false;
+
+	// Retarget every transfer to the end of its JUMP chain
+	for (auto& instr : instrs)
+	{
+		if (!hasThreadableLabels(instr.opcode))
+			continue;
+		bool failure = !isPlainTransfer(instr.opcode);
+		for (auto& op : instr.ops)
+		{
+			if (auto* l = std::get_if<LabelOp>(&op))
+			{
+				Label threaded = threadLabel(bc, l->v, failure);
+				if (threaded != l->v)
+				{
+					op = OpLabel(threaded);
+					changed = true;
+				}
+			}
+		}
+		if (instr.opcode == Opcode::SWITCH_ON_HEAD || instr.opcode == Opcode::SWITCH_ON_LITERAL)
+		{
+			auto& table = bc.getSwitchTables()[std::get<ImmMint>(instr.ops[1]).v];
+			for (auto& [key, label] : table.cases)
+			{
+				Label threaded = threadLabel(bc, label, false);
+				changed = changed || threaded != label;
+				label = threaded;
+			}
+		}
+	}
+
+	// A JUMP to FAIL fails in place
+	for (auto& instr : instrs)
+	{
+		if (instr.opcode != Opcode::JUMP)
+			continue;
+		size_t target = targetOf(std::get<LabelOp>(instr.ops[0]).v);
+		if (target < instrs.size() && instrs[target].opcode == Opcode::FAIL)
+		{
+			instr = PatternBytecode::Instruction { Opcode::FAIL, {} };
+			changed = true;
+		}
+	}
+
+	// A JUMP to the next instruction does nothing, unless a failure lands on it
+	// on the way to END_BLOCK (without it, END_BLOCK would see the failure)
+	std::vector<bool> failureTarget(instrs.size(), false);
+	for (const auto& instr : instrs)
+	{
+		if (!hasThreadableLabels(instr.opcode) || isPlainTransfer(instr.opcode))
+			continue;
+		for (const auto& op : instr.ops)
+			if (auto* l = std::get_if<LabelOp>(&op); l && targetOf(l->v) < instrs.size())
+				failureTarget[targetOf(l->v)] = true;
+	}
+	std::vector<bool> remove(instrs.size(), false);
+	bool removed = false;
+	for (size_t pc = 0; pc + 1 < instrs.size(); ++pc)
+	{
+		if (instrs[pc].opcode != Opcode::JUMP || targetOf(std::get<LabelOp>(instrs[pc].ops[0]).v) != pc + 1)
+			continue;
+		if (failureTarget[pc] && instrs[pc + 1].opcode == Opcode::END_BLOCK)
+			continue;
+		remove[pc] = true;
+		removed = true;
+	}
+	if (removed)
+		bc.eraseInstructions(remove);
+
+	return changed || removed;
+}
+
+/*===========================================================================
+ Dead Code
+===========================================================================*/
+
+bool eliminateUnreachableCode(PatternBytecode& bc)
+{
+	const auto& instrs = bc.getInstructions();
+	auto cfg = BytecodeAnalysis::buildControlFlowGraph(bc);
+
+	std::vector<bool> remove(instrs.size(), true);
+	for (auto b : cfg.reversePostorder())
+		for (size_t pc = cfg.blocks[b].begin; pc < cfg.blocks[b].end; ++pc)
+			remove[pc] = false;
+
+	// A scope goes only when both its BEGIN_BLOCK and END_BLOCK do
+	std::unordered_map<Label, bool> scopeReachable;
+	for (size_t pc = 0; pc < instrs.size(); ++pc)
+	{
+		auto op = instrs[pc].opcode;
+		if (op == Opcode::BEGIN_BLOCK || op == Opcode::END_BLOCK)
+			scopeReachable[std::get<LabelOp>(instrs[pc].ops[0]).v] |= !remove[pc];
+	}
+	bool changed = false;
+	for (size_t pc = 0; pc < instrs.size(); ++pc)
+	{
+		auto op = instrs[pc].opcode;
+		if (remove[pc] && (op == Opcode::BEGIN_BLOCK || op == Opcode::END_BLOCK)
+			&& scopeReachable[std::get<LabelOp>(instrs[pc].ops[0]).v])
+			remove[pc] = false;
+		changed = changed || remove[pc];
+	}
+
+	if (changed)
+		bc.eraseInstructions(remove);
+	return changed;
+}
+
+bool eliminateDeadRegisterWrites(PatternBytecode& bc)
+{
+	const auto& instrs = bc.getInstructions();
+	bool changed = false;
+
+	// Removing a write can leave the writes feeding it dead: repeat until none is
+	while (true)
+	{
+		auto live = BytecodeAnalysis::computeLiveness(bc);
+		std::vector<bool> remove(instrs.size(), false);
+		bool removed = false;
+		for (size_t pc = 0; pc < instrs.size(); ++pc)
+		{
+			auto op = instrs[pc].opcode;
+			if (!writesFirstOperand(op) || hasSideEffects(op) || isBranch(op))
+				continue;
+
+			auto access = BytecodeAnalysis::getRegisterAccess(instrs[pc]);
+			auto succs = BytecodeAnalysis::getSuccessors(bc, pc);
+			auto liveOut = [&](const std::vector<std::vector<bool>>& in, size_t r) {
+				return std::any_of(succs.begin(), succs.end(), [&](size_t s) { return in[s][r]; });
+			};
+			bool dead = std::none_of(access.exprWrites.begin(), access.exprWrites.end(),
+									 [&](auto r) { return liveOut(live.exprIn, r); })
+				&& std::none_of(access.boolWrites.begin(), access.boolWrites.end(),
+								[&](auto r) { return liveOut(live.boolIn, r); });
+			if (dead)
+			{
+				remove[pc] = true;
+				removed = true;
+			}
+		}
+		if (!removed)
+			break;
+		bc.eraseInstructions(remove);
+		changed = true;
+	}
+	return changed;
+}
+
+bool compactRegisters(PatternBytecode& bc)
+{
+	size_t exprCount = static_cast<size_t>(bc.getExprRegisterCount());
+	size_t boolCount = static_cast<size_t>(bc.getBoolRegisterCount());
+
+	// %e0 (the subject), %b0 (the result) and the pattern variables' registers stay
+	std::vector<bool> exprUsed(exprCount, false);
+	std::vector<bool> boolUsed(boolCount, false);
+	if (exprCount > 0)
+		exprUsed[0] = true;
+	if (boolCount > 0)
+		boolUsed[0] = true;
+	for (const auto& [name, reg] : bc.getLexicalMap())
+		exprUsed[reg] = true;
+	for (const auto& instr : bc.getInstructions())
+	{
+		for (const auto& op : instr.ops)
+		{
+			if (auto* r = std::get_if<ExprRegOp>(&op))
+				exprUsed[r->v] = true;
+			else if (auto* b = std::get_if<BoolRegOp>(&op))
+				boolUsed[b->v] = true;
+		}
+	}
+
+	// Renumber the used registers in order
+	auto densely = [](const std::vector<bool>& used, size_t& next) {
+		std::vector<size_t> map(used.size(), 0);
+		for (size_t r = 0; r < used.size(); ++r)
+			if (used[r])
+				map[r] = next++;
+		return map;
+	};
+	size_t exprNext = 0, boolNext = 0;
+	auto exprMap = densely(exprUsed, exprNext);
+	auto boolMap = densely(boolUsed, boolNext);
+	if (exprNext == exprCount && boolNext == boolCount)
+		return false;
+
+	bc.renameRegisters(exprMap, boolMap);
+	return true;
+}
+
+/*===========================================================================
+ Superinstructions
+===========================================================================*/
+
+namespace
+{
+	/// Registers and labels of a repeated variable's bind-or-compare sequence
+	struct BindOrCompare
+	{
+		size_t end; ///< One past its BRANCH_FALSE
+		ExprRegIndex var; ///< The variable's register
+		ExprRegIndex src; ///< The value it binds or is compared to
+		BoolRegIndex cond; ///< SAMEQ's result
+		Ident name;
+		Label fail;
+		Label join; ///< Where the bind case continues
+	};
+
+	/// Match, at pc, the sequence the compiler emits for a repeated variable:
+	///         MATCH_LITERAL var, $$Failure, Lcmp
+	///         MOVE var, src                       (unless it was dead)
+	///         BIND_VAR name, src
+	///         JUMP Ljoin
+	///   Lcmp: SAMEQ cond, var, src
+	///         BRANCH_FALSE cond, Lfail
+	std::optional<BindOrCompare> matchBindOrCompare(const PatternBytecode& bc, const BytecodeAnalysis::Liveness& live,
+													 size_t pc)
+	{
+		const auto& instrs = bc.getInstructions();
+		const auto& labelMap = bc.getLabelMap();
+		auto targetOf = [&](const Operand& op) {
+			auto it = labelMap.find(std::get<LabelOp>(op).v);
+			return it == labelMap.end() ? instrs.size() : it->second;
+		};
+
+		const auto& test = instrs[pc];
+		if (test.opcode != Opcode::MATCH_LITERAL || !std::get<ImmExpr>(test.ops[1]).sameQ(getExprConstants().failureSymbol))
+			return std::nullopt;
+		ExprRegIndex var = std::get<ExprRegOp>(test.ops[0]).v;
+
+		size_t bind = pc + 1;
+		bool hasMove = bind < instrs.size() && instrs[bind].opcode == Opcode::MOVE;
+		if (hasMove)
+			++bind;
+		size_t end = bind + 4;
+		if (end > instrs.size() || instrs[bind].opcode != Opcode::BIND_VAR || instrs[bind + 1].opcode != Opcode::JUMP
+			|| instrs[bind + 2].opcode != Opcode::SAMEQ || instrs[bind + 3].opcode != Opcode::BRANCH_FALSE)
+			return std::nullopt;
+
+		ExprRegIndex src = std::get<ExprRegOp>(instrs[bind].ops[1]).v;
+		BoolRegIndex cond = std::get<BoolRegOp>(instrs[bind + 2].ops[0]).v;
+		if (hasMove
+			&& (std::get<ExprRegOp>(instrs[pc + 1].ops[0]).v != var || std::get<ExprRegOp>(instrs[pc + 1].ops[1]).v != src))
+			return std::nullopt;
+		if (std::get<ExprRegOp>(instrs[bind + 2].ops[1]).v != var || std::get<ExprRegOp>(instrs[bind + 2].ops[2]).v != src
+			|| std::get<BoolRegOp>(instrs[bind + 3].ops[0]).v != cond)
+			return std::nullopt;
+		if (targetOf(test.ops[2]) != bind + 2)
+			return std::nullopt;
+
+		// Both cases must meet again at the instruction after the BRANCH_FALSE
+		size_t join = targetOf(instrs[bind + 1].ops[0]);
+		if (join != end
+			&& !(end < instrs.size() && instrs[end].opcode == Opcode::JUMP && targetOf(instrs[end].ops[0]) == join))
+			return std::nullopt;
+
+		// Without the MOVE, the fused instruction's write to var must be one nobody reads
+		if (!hasMove && join < instrs.size() && live.exprIn[join][var])
+			return std::nullopt;
+
+		return BindOrCompare { end,
+							   var,
+							   src,
+							   cond,
+							   std::get<Ident>(instrs[bind].ops[0]),
+							   std::get<LabelOp>(instrs[bind + 3].ops[1]).v,
+							   std::get<LabelOp>(instrs[bind + 1].ops[0]).v };
+	}
+}; // namespace
+
+bool fuseSuperinstructions(PatternBytecode& bc)
+{
+	auto& instrs = bc.getInstructions();
+	const auto& labelMap = bc.getLabelMap();
+	auto targetOf = [&](Label L) {
+		auto it = labelMap.find(L);
+		return it == labelMap.end() ? instrs.size() : it->second;
+	};
+	auto live = BytecodeAnalysis::computeLiveness(bc);
+	auto preds = BytecodeAnalysis::getPredecessors(bc);
+	auto boolLiveAt = [&](size_t pc, BoolRegIndex r) { return pc < instrs.size() && live.boolIn[pc][r]; };
+
+	std::vector<bool> remove(instrs.size(), false);
+	bool changed = false;
+	for (size_t pc = 0; pc < instrs.size(); ++pc)
+	{
+		// Repeated variable: the whole bind-or-compare sequence. Nothing else may
+		// jump into it, and SAMEQ's result must not be read after it
+		if (auto seq = matchBindOrCompare(bc, live, pc))
+		{
+			bool closed = true;
+			for (size_t i = pc + 1; i < seq->end; ++i)
+				for (auto p : preds[i])
+					closed = closed && p >= pc && p < seq->end;
+			if (closed && !boolLiveAt(seq->end, seq->cond) && !boolLiveAt(targetOf(seq->fail), seq->cond))
+			{
+				instrs[pc] = PatternBytecode::Instruction { Opcode::BIND_OR_COMPARE,
+															{ OpExprReg(seq->var), OpExprReg(seq->src), seq->name,
+															  OpLabel(seq->fail) } };
+				std::fill(remove.begin() + static_cast<std::ptrdiff_t>(pc) + 1,
+						  remove.begin() + static_cast<std::ptrdiff_t>(seq->end), true);
 				changed = true;
-				continue; // Check same position again
+				pc = seq->end - 1;
+				continue;
 			}
 		}
-		++i;
+
+		if (pc + 1 >= instrs.size() || (!preds[pc + 1].empty() && preds[pc + 1] != std::vector<size_t> { pc }))
+			continue;
+		const auto& instr = instrs[pc];
+		const auto& next = instrs[pc + 1];
+
+		// SAMEQ %b, lhs, rhs; BRANCH_FALSE %b, L with %b read nowhere else
+		if (instr.opcode == Opcode::SAMEQ && next.opcode == Opcode::BRANCH_FALSE
+			&& std::get<BoolRegOp>(instr.ops[0]) == std::get<BoolRegOp>(next.ops[0]))
+		{
+			BoolRegIndex cond = std::get<BoolRegOp>(instr.ops[0]).v;
+			Label fail = std::get<LabelOp>(next.ops[1]).v;
+			if (boolLiveAt(pc + 2, cond) || boolLiveAt(targetOf(fail), cond))
+				continue;
+			instrs[pc] = PatternBytecode::Instruction { Opcode::SAMEQ_BRANCH,
+														{ instr.ops[1], instr.ops[2], OpLabel(fail) } };
+			remove[pc + 1] = true;
+			changed = true;
+			++pc;
+		}
+		// MOVE dest, src; BIND_VAR name, src
+		else if (instr.opcode == Opcode::MOVE && next.opcode == Opcode::BIND_VAR
+				 && std::get_if<ExprRegOp>(&instr.ops[1]) && std::get<ExprRegOp>(instr.ops[1]) == std::get<ExprRegOp>(next.ops[1]))
+		{
+			instrs[pc] = PatternBytecode::Instruction { Opcode::BIND_FROM, { instr.ops[0], instr.ops[1], next.ops[0] } };
+			remove[pc + 1] = true;
+			changed = true;
+			++pc;
+		}
 	}
 
+	if (changed)
+		bc.eraseInstructions(remove);
+	return changed;
+}
+
+/*===========================================================================
+ Pass Manager
+===========================================================================*/
+
+const std::vector<Pass>& getPasses()
+{
+	static const std::vector<Pass> passes = {
+		{ "eliminateDeadBranches", OptimizationLevel::Basic, eliminateDeadBranches },
+		{ "threadJumps", OptimizationLevel::Basic, threadJumps },
+		{ "hoistCommonAlternativePrefix", OptimizationLevel::Full, hoistCommonAlternativePrefix },
+		{ "eliminateCommonExtractions", OptimizationLevel::Full, eliminateCommonExtractions },
+		{ "eliminateUnreachableCode", OptimizationLevel::Full, eliminateUnreachableCode },
+		{ "eliminateDeadRegisterWrites", OptimizationLevel::Full, eliminateDeadRegisterWrites },
+		{ "fuseSuperinstructions", OptimizationLevel::Full, fuseSuperinstructions },
+		{ "compactRegisters", OptimizationLevel::Full, compactRegisters },
+	};
+	return passes;
+}
+
+std::optional<OptimizationLevel> optimizationLevelFromInteger(mint level)
+{
+	if (level < static_cast<mint>(OptimizationLevel::None) || level > static_cast<mint>(OptimizationLevel::Full))
+		return std::nullopt;
+	return static_cast<OptimizationLevel>(level);
+}
+
+bool runPasses(PatternBytecode& bc, OptimizationLevel level)
+{
+	bool changed = false;
+	for (size_t round = 0; round < MaxPipelineRounds; ++round)
+	{
+		bool roundChanged = false;
+		for (const auto& pass : getPasses())
+		{
+			if (pass.level <= level && pass.run(bc))
+				roundChanged = true;
+		}
+		if (!roundChanged)
+			break;
+		changed = true;
+	}
 	return changed;
 }
 
@@ -2,18 +2,105 @@
 
 #include "VM/PatternBytecode.h"
 
+#include "Expr.h"
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+
 namespace PatternMatcher
 {
 
 /// @brief Bytecode optimization passes for pattern matching bytecode
 namespace BytecodeOptimizer
 {
-	/// @brief Remove dead branch instructions that can never execute
-	/// @note This is SAFE because LOAD_IMM + BRANCH_FALSE sequences are
-	///       compiler-generated and never have labels pointing to them
-	/// @note Pattern: LOAD_IMM %b, <non-zero>; BRANCH_FALSE %b, L
+	/// @brief How much optimization a pattern's bytecode gets
+	enum class OptimizationLevel
+	{
+		None = 0, ///< The bytecode as the compiler emits it
+		Basic = 1, ///< Local passes that look at a few neighbouring instructions
+		Full = 2 ///< Every pass, including those that analyze the whole control flow graph
+	};
+
+	/// Level CompilePatternToBytecode uses unless told otherwise
+	inline constexpr OptimizationLevel DefaultOptimizationLevel = OptimizationLevel::Full;
+
+	/// Most times runPasses repeats the pipeline (each pass can expose work for the others)
+	inline constexpr size_t MaxPipelineRounds = 4;
+
+	/// @brief An optimization pass
+	/// @note A pass edits the bytecode through eraseInstructions/insertInstruction (or
+	///       changes operands in place), so labels stay on the instructions they name,
+	///       and returns true if it changed anything
+	struct Pass
+	{
+		const char* name;
+		OptimizationLevel level; ///< Lowest level the pass runs at
+		bool (*run)(PatternBytecode&);
+	};
+
+	/// @brief Get the passes, in the order they run
+	const std::vector<Pass>& getPasses();
+
+	/// @brief Get the level with the given number (0, 1 or 2)
+	std::optional<OptimizationLevel> optimizationLevelFromInteger(mint level);
+
+	/// @brief Run the passes enabled at a level, repeating the pipeline until nothing changes
+	/// @return True if any pass changed the bytecode
+	/// @note The passes are written for the compiler's registers (before register allocation).
+	///       On allocated bytecode, registers that share a number look written more than
+	///       once, and the passes leave them alone.
+	/// @note Editing instructions drops the choice point save sets: compute them afterwards.
+	bool runPasses(PatternBytecode& bc, OptimizationLevel level);
+
+	/// @brief Remove BRANCH_FALSE instructions that can never branch
+	/// @note Pattern: LOAD_IMM %b, <non-zero>; BRANCH_FALSE %b, L in one basic block
 	bool eliminateDeadBranches(PatternBytecode& bc);
 
+	/// @brief Send every transfer straight to the end of its JUMP chain
+	/// @note innerFail: JUMP outerFail, one per nesting level, becomes a single failure
+	///       transfer; a JUMP to FAIL becomes FAIL, and a JUMP to the next instruction goes
+	/// @note END_BLOCK merges its frame unless it is reached directly by a failure, so a
+	///       failure transfer still ends at the JUMP into an END_BLOCK
+	bool threadJumps(PatternBytecode& bc);
+
+	/// @brief Move the checks and extractions every alternative of a TRY starts with above the TRY
+	/// @note f[x_Integer] | f[x_Real]: both alternatives start with MATCH_SHAPE %e0, f, 1 and
+	///       GET_PART %e0, 1; they now run once, before the choice point is made
+	/// @note A hoisted check fails to where the last alternative's copy failed: when the
+	///       check fails, every alternative fails at it
+	/// @note Works on the compiler's registers (before register allocation)
+	bool hoistCommonAlternativePrefix(PatternBytecode& bc);
+
+	/// @brief Reuse an earlier GET_PART/GET_LENGTH of the same register and part
+	/// @note The earlier extraction must dominate the later one, and the registers
+	///       involved must be written once (so the source cannot have changed)
+	/// @note Works on the compiler's registers (before register allocation)
+	bool eliminateCommonExtractions(PatternBytecode& bc);
+
+	/// @brief Remove the instructions control cannot reach from the entry
+	/// @note Alternatives are reached through their TRY/RETRY (choice-point edges)
+	/// @note BEGIN_BLOCK and END_BLOCK go in pairs, so scopes stay balanced
+	bool eliminateUnreachableCode(PatternBytecode& bc);
+
+	/// @brief Remove MOVE, LOAD_IMM, GET_PART, SAMEQ, ... whose result is never read
+	/// @note MOVE bindReg, %e0 of a variable that is never compared, for instance
+	/// @note Liveness follows choice-point edges: a register an alternative reads is live at
+	///       its TRY, and backtracking restores it from the choice point, not from a later write
+	bool eliminateDeadRegisterWrites(PatternBytecode& bc);
+
+	/// @brief Replace the instruction sequences of repeated variables with superinstructions
+	/// @note f[x_, x_]: MATCH_LITERAL x, $$Failure; MOVE; BIND_VAR; JUMP; SAMEQ; BRANCH_FALSE
+	///       becomes one BIND_OR_COMPARE, so either case runs a single instruction
+	/// @note Elsewhere SAMEQ + BRANCH_FALSE becomes SAMEQ_BRANCH and MOVE + BIND_VAR
+	///       becomes BIND_FROM. Only where nothing jumps between the fused instructions
+	///       and the boolean register is not read afterwards
+	bool fuseSuperinstructions(PatternBytecode& bc);
+
+	/// @brief Renumber the registers densely, dropping those no instruction uses
+	/// @note %e0, %b0 and the pattern variables' registers keep a number
+	bool compactRegisters(PatternBytecode& bc);
+
 } // namespace BytecodeOptimizer
 
 } // namespace PatternMatcher
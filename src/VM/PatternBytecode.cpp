@@ -15,6 +15,8 @@ The disassembly format is designed to be human-readable with:
 ===========================================================================*/
 
 #include "VM/PatternBytecode.h"
+#include "VM/AnalyzePatternBytecode.h"
+#include "VM/CompilePatternToBytecode.h"
 #include "VM/Opcode.h"
 #include "VM/OptimizePatternBytecode.h"
 
@@ -25,9 +27,11 @@ The disassembly format is designed to be human-readable with:
 #include "Expr.h"
 #include "Logger.h"
 
+#include <algorithm>
 #include <iomanip>
 #include <initializer_list>
 #include <memory>
+#include <numeric>
 #include <optional>
 #include <sstream>
 #include <string>
@@ -53,9 +57,9 @@ std::string instructionToString(const PatternBytecode::Instruction& instr)
 {
 	std::stringstream ss;
 
-	// Opcode name (padded to 16 chars for alignment)
-	const char* name = opcodeName(instr.opcode);
-	ss << std::left << std::setw(16) << name;
+	// Opcode name (padded to 16 chars for alignment, always followed by a space)
+	std::string name = opcodeName(instr.opcode);
+	ss << std::left << std::setw(16) << (name.size() < 16 ? name : name + " ");
 
 	// Operands (comma-separated)
 	bool first = true;
@@ -69,6 +73,47 @@ std::string instructionToString(const PatternBytecode::Instruction& instr)
 	return ss.str();
 }
 
+/**
+ * @brief Print the cases of a switch instruction, one per line
+ *
+ * Output format: "<indent>Expr[f] → L6"
+ *
+ * @param ss Stream to print to
+ * @param table The switch table of the instruction
+ * @param indent Prefix of every line
+ */
+static void printSwitchCases(std::stringstream& ss, const PatternBytecode::SwitchTable& table,
+							 const std::string& indent)
+{
+	for (const auto& [key, label] : table.cases)
+		ss << indent << operandToString(OpImm(key)) << " → L" << label << "\n";
+}
+
+/**
+ * @brief Whether an instruction is a jump (annotated and counted as one)
+ *
+ * JUMP and the conditional jumps that are not failure checks: BRANCH_FALSE and
+ * the superinstructions that stand for it.
+ */
+static bool isJumpInstruction(Opcode op)
+{
+	return op == Opcode::JUMP || op == Opcode::BRANCH_FALSE || op == Opcode::SAMEQ_BRANCH
+		|| op == Opcode::BIND_OR_COMPARE;
+}
+
+/**
+ * @brief Print the values of a literal set on one line
+ *
+ * Output format: "<indent>∈ {Expr[1], Expr[2]}"
+ */
+static void printLiteralSet(std::stringstream& ss, const PatternBytecode::LiteralSet& set, const std::string& indent)
+{
+	ss << indent << "∈ {";
+	for (size_t i = 0; i < set.values.size(); ++i)
+		ss << (i > 0 ? ", " : "") << operandToString(OpImm(set.values[i]));
+	ss << "}\n";
+}
+
 /*===========================================================================
  Compact Output Format (toString)
 ===========================================================================*/
@@ -115,6 +160,12 @@ std::string PatternBytecode::toString() const
 		ss << std::setw(maxPCWidth) << pc << "    ";
 		ss << instructionToString(instr);
 		ss << "\n";
+
+		// Switch cases and literal sets below their instruction
+		if (instr.opcode == Opcode::SWITCH_ON_HEAD || instr.opcode == Opcode::SWITCH_ON_LITERAL)
+			printSwitchCases(ss, switchTables[std::get<ImmMint>(instr.ops[1]).v], std::string(maxPCWidth + 6, ' '));
+		if (instr.opcode == Opcode::MATCH_LITERAL_SET)
+			printLiteralSet(ss, literalSets[std::get<ImmMint>(instr.ops[1]).v], std::string(maxPCWidth + 6, ' '));
 	}
 
 	// Minimal footer - just register counts
@@ -209,8 +260,8 @@ std::string PatternBytecode::disassemble() const
 	-----------------------------------------------------------------------*/
 	int blockCount = 0; // Total BEGIN_BLOCK instructions
 	int maxBlockDepth = 0; // Maximum nesting level observed
-	int jumpCount = 0; // JUMP + BRANCH_FALSE instructions
-	int backtrackPoints = 0; // TRY instructions (choice points)
+	int jumpCount = 0; // JUMP, BRANCH_FALSE and the like (isJumpInstruction)
+	int backtrackPoints = 0; // TRY and SPLIT_SEQ instructions (choice points)
 
 	for (size_t pc = 0; pc < instrs.size(); ++pc)
 	{
@@ -221,9 +272,9 @@ std::string PatternBytecode::disassemble() const
 		// Update statistics as we encounter relevant instructions
 		if (instr.opcode == Opcode::BEGIN_BLOCK)
 			blockCount++;
-		if (instr.opcode == Opcode::JUMP || instr.opcode == Opcode::BRANCH_FALSE)
+		if (isJumpInstruction(instr.opcode))
 			jumpCount++;
-		if (instr.opcode == Opcode::TRY)
+		if (instr.opcode == Opcode::TRY || instr.opcode == Opcode::SPLIT_SEQ)
 			backtrackPoints++;
 
 		// Show label marker if this PC is a jump target (L0:, L1:, etc.)
@@ -244,7 +295,7 @@ std::string PatternBytecode::disassemble() const
 		ss << instructionToString(instr);
 
 		// Add inline annotation for control flow: "→ L7" shows jump target
-		if (instr.opcode == Opcode::JUMP || instr.opcode == Opcode::BRANCH_FALSE)
+		if (isJumpInstruction(instr.opcode))
 		{
 			// Find the Label operand and show its destination
 			for (const auto& op : instr.ops)
@@ -258,6 +309,14 @@ std::string PatternBytecode::disassemble() const
 		}
 
 		ss << "\n";
+
+		// Switch cases and literal sets below their instruction, one level deeper
+		if (instr.opcode == Opcode::SWITCH_ON_HEAD || instr.opcode == Opcode::SWITCH_ON_LITERAL)
+			printSwitchCases(ss, switchTables[std::get<ImmMint>(instr.ops[1]).v],
+							 std::string(maxPCWidth + 4 + 2 * (depth + 1), ' '));
+		if (instr.opcode == Opcode::MATCH_LITERAL_SET)
+			printLiteralSet(ss, literalSets[std::get<ImmMint>(instr.ops[1]).v],
+							std::string(maxPCWidth + 4 + 2 * (depth + 1), ' '));
 	}
 
 	/*-----------------------------------------------------------------------
@@ -276,8 +335,8 @@ std::string PatternBytecode::disassemble() const
 	ss << "Statistics:\n";
 	ss << "  Instructions:      " << instrs.size() << "\n";
 	ss << "  Labels:            " << labelMap.size() << "\n";
-	ss << "  Expr registers:    " << exprRegisterCount << "\n";
-	ss << "  Bool registers:    " << boolRegisterCount << "\n";
+	ss << "  Expr registers:    " << exprRegisterCount << " (virtual: " << exprVirtualRegisterCount << ")\n";
+	ss << "  Bool registers:    " << boolRegisterCount << " (virtual: " << boolVirtualRegisterCount << ")\n";
 	ss << "  Blocks:            " << blockCount << " (max depth: " << maxBlockDepth << ")\n";
 	ss << "  Jumps:             " << jumpCount << "\n";
 	ss << "  Backtrack points:  " << backtrackPoints << "\n";
@@ -326,25 +385,25 @@ int PatternBytecode::getMaxBlockDepth() const
 	return maxDepth;
 }
 
-// Includes both unconditional jumps (JUMP) and conditional jumps (BRANCH_FALSE).
+// Includes both unconditional jumps (JUMP) and conditional jumps (BRANCH_FALSE, SAMEQ_BRANCH, BIND_OR_COMPARE).
 int PatternBytecode::getJumpCount() const
 {
 	int count = 0;
 	for (const auto& instr : instrs)
 	{
-		if (instr.opcode == Opcode::JUMP || instr.opcode == Opcode::BRANCH_FALSE)
+		if (isJumpInstruction(instr.opcode))
 			count++;
 	}
 	return count;
 }
 
-// TRY instructions create choice points for backtracking in pattern matching.
+// TRY and SPLIT_SEQ instructions create choice points for backtracking in pattern matching.
 int PatternBytecode::getBacktrackPointCount() const
 {
 	int count = 0;
 	for (const auto& instr : instrs)
 	{
-		if (instr.opcode == Opcode::TRY)
+		if (instr.opcode == Opcode::TRY || instr.opcode == Opcode::SPLIT_SEQ)
 			count++;
 	}
 	return count;
@@ -389,35 +448,147 @@ std::optional<size_t> PatternBytecode::resolveLabel(Label L) const
 }
 
 /*===========================================================================
- Bytecode Optimization
+ Register Renaming
 ===========================================================================*/
 
 /**
- * @brief Optimize bytecode (currently disabled)
- *
- * All optimization passes have been disabled because none apply to real patterns:
+ * @brief Rename registers after register allocation
  *
- * - Dead branch elimination: LOAD_IMM and BRANCH_FALSE never appear adjacent
- *   (LOAD_IMM only in epilogue, BRANCH_FALSE only after SAMEQ)
+ * Rewrites every ExprRegOp/BoolRegOp operand and the lexical bindings through
+ * the maps, and shrinks the register counts to the highest register used.
+ * The counts before renaming remain as the virtual register counts.
+ */
+void PatternBytecode::renameRegisters(const std::vector<size_t>& exprMap, const std::vector<size_t>& boolMap)
+{
+	for (auto& instr : instrs)
+	{
+		for (auto& op : instr.ops)
+		{
+			if (auto* r = std::get_if<ExprRegOp>(&op))
+				r->v = exprMap[r->v];
+			else if (auto* b = std::get_if<BoolRegOp>(&op))
+				b->v = boolMap[b->v];
+		}
+	}
+	for (auto& [name, reg] : lexicalMap)
+		reg = exprMap[reg];
+
+	exprRegisterCount = 0;
+	for (auto r : exprMap)
+		exprRegisterCount = std::max(exprRegisterCount, static_cast<int>(r) + 1);
+	boolRegisterCount = 0;
+	for (auto r : boolMap)
+		boolRegisterCount = std::max(boolRegisterCount, static_cast<int>(r) + 1);
+}
+
+/*===========================================================================
+ Instruction Editing
+===========================================================================*/
+
+// Both edits change PCs: labels are remapped, and choice point save sets
+// (keyed by PC) are dropped, so passes that edit run before computing them
+
+void PatternBytecode::insertInstruction(size_t pc, Instruction instr)
+{
+	instrs.insert(instrs.begin() + static_cast<std::ptrdiff_t>(pc), std::move(instr));
+	for (auto& [label, target] : labelMap)
+		if (target > pc)
+			++target;
+	choicePointSaveSets.clear();
+}
+
+void PatternBytecode::eraseInstructions(const std::vector<bool>& remove)
+{
+	// newPC[pc] = number of remaining instructions before pc
+	std::vector<size_t> newPC(instrs.size() + 1, 0);
+	size_t kept = 0;
+	for (size_t pc = 0; pc < instrs.size(); ++pc)
+	{
+		newPC[pc] = kept;
+		if (remove[pc])
+			continue;
+		if (kept != pc)
+			instrs[kept] = std::move(instrs[pc]);
+		++kept;
+	}
+	newPC[instrs.size()] = kept;
+	instrs.resize(kept);
+
+	for (auto& [label, target] : labelMap)
+		target = newPC[std::min(target, newPC.size() - 1)];
+	choicePointSaveSets.clear();
+}
+
+/*===========================================================================
+ Bytecode Optimization
+===========================================================================*/
+
+/**
+ * @brief Optimize bytecode
  *
- * - MOVE elimination: Would require checking if instruction is a jump target
- *   (complex label tracking with error-prone PC adjustments)
+ * Runs the optimizer's full pipeline (BytecodeOptimizer::runPasses) again on
+ * bytecode that is already compiled. CompilePatternToBytecode runs the same
+ * pipeline at its optimization level, so this only finds work in bytecode
+ * compiled at a lower level.
  *
- * - GET_PART+MOVE fusion: Same label tracking issues
+ * The passes edit the instructions, which drops the choice point save sets;
+ * they are recomputed here.
  *
- * - Jump elimination: Requires control flow graph analysis
+ * @return True if the bytecode changed
+ */
+bool PatternBytecode::optimize()
+{
+	optimizationLevel = BytecodeOptimizer::OptimizationLevel::Full;
+	if (!BytecodeOptimizer::runPasses(*this, BytecodeOptimizer::OptimizationLevel::Full))
+		return false;
+	BytecodeAnalysis::computeChoicePointSaveSets(*this);
+	return true;
+}
+
+/**
+ * @brief Reorder interchangeable alternatives by profile
  *
- * - Unreachable code: Requires understanding backtracking (TRY/TRUST/FAIL)
+ * The branches of a recorded alternative chain never match the same
+ * expression, so at most one of them matches and the others are tried for
+ * nothing: trying the one that matches most often first saves a choice point
+ * restore and a failed attempt per branch skipped. Each Alternatives gets the
+ * stable order of its parts by descending hits, and the pattern is compiled
+ * again with it (CompilePatternToBytecode keys the order by the MExpr node,
+ * so the same pattern tree is compiled).
  *
- * The compiler generates reasonably efficient code already. Real optimization
- * would require proper dataflow analysis and CFG, which is future work.
+ * The bytecode itself is left alone: VMs linked to it keep running it.
  *
- * @return Always false (no optimizations performed)
+ * @return The reordered bytecode, or nullptr if no chain would change
  */
-bool PatternBytecode::optimize()
+std::shared_ptr<PatternBytecode> PatternBytecode::reorderAlternatives(const AlternativeProfile& profile) const
 {
-	// Optimizer disabled - no safe optimizations apply to real patterns
-	return false;
+	AlternativeOrder order = alternativeOrder;
+	bool changed = false;
+	for (const auto& chain : alternativeChains)
+	{
+		auto it = profile.find(chain.alternatives);
+		if (it == profile.end())
+			continue;
+		const auto& hits = it->second;
+		auto hitsOf = [&](mint part) { return static_cast<size_t>(part - 1) < hits.size() ? hits[part - 1] : 0; };
+		auto byHits = [&](mint a, mint b) { return hitsOf(a) > hitsOf(b); };
+
+		auto chainParts = chain.parts;
+		std::stable_sort(chainParts.begin(), chainParts.end(), byHits);
+		changed = changed || chainParts != chain.parts;
+
+		auto& parts = order[chain.alternatives];
+		if (parts.empty())
+		{
+			parts.resize(chain.alternatives->length());
+			std::iota(parts.begin(), parts.end(), 1);
+		}
+		std::stable_sort(parts.begin(), parts.end(), byHits);
+	}
+	if (!changed)
+		return nullptr;
+
+	return CompilePatternToBytecode(pattern, optimizationLevel, order, variableNames);
 }
 
 namespace PatternBytecodeInterface
@@ -434,6 +605,14 @@ namespace PatternBytecodeInterface
 	{
 		return Expr(static_cast<mint>(bytecode->getExprRegisterCount()));
 	}
+	Expr getBoolVirtualRegisterCount(std::shared_ptr<PatternBytecode> bytecode)
+	{
+		return Expr(static_cast<mint>(bytecode->getBoolVirtualRegisterCount()));
+	}
+	Expr getExprVirtualRegisterCount(std::shared_ptr<PatternBytecode> bytecode)
+	{
+		return Expr(static_cast<mint>(bytecode->getExprVirtualRegisterCount()));
+	}
 	Expr getInstructionCount(std::shared_ptr<PatternBytecode> bytecode)
 	{
 		return Expr(static_cast<mint>(bytecode->getInstructionCount()));
@@ -462,6 +641,16 @@ namespace PatternBytecodeInterface
 	{
 		return bytecode->getLexicalBindings();
 	}
+	Expr getVariableSlots(std::shared_ptr<PatternBytecode> bytecode)
+	{
+		const auto& names = bytecode->getVariableNames();
+		Expr res = Expr::createNormal(static_cast<mint>(names.size()), "List");
+		for (size_t i = 0; i < names.size(); ++i)
+		{
+			res.setPart(static_cast<mint>(i + 1), Expr(names[i]));
+		}
+		return res;
+	}
 	Expr getPattern(std::shared_ptr<PatternBytecode> bytecode)
 	{
 		return MExpr::toExpr(bytecode->getPattern());
@@ -492,6 +681,10 @@ void PatternBytecode::initializeEmbedMethods(const char* embedName)
 		embedName, "getBoolRegisterCount");
 	RegisterMethod<std::shared_ptr<PatternBytecode>, PatternBytecodeInterface::getExprRegisterCount>(
 		embedName, "getExprRegisterCount");
+	RegisterMethod<std::shared_ptr<PatternBytecode>, PatternBytecodeInterface::getBoolVirtualRegisterCount>(
+		embedName, "getBoolVirtualRegisterCount");
+	RegisterMethod<std::shared_ptr<PatternBytecode>, PatternBytecodeInterface::getExprVirtualRegisterCount>(
+		embedName, "getExprVirtualRegisterCount");
 	RegisterMethod<std::shared_ptr<PatternBytecode>, PatternBytecodeInterface::getInstructionCount>(
 		embedName, "getInstructionCount");
 	RegisterMethod<std::shared_ptr<PatternBytecode>, PatternBytecodeInterface::getLabelCount>(embedName, "getLabelCount");
@@ -504,6 +697,8 @@ void PatternBytecode::initializeEmbedMethods(const char* embedName)
 	RegisterMethod<std::shared_ptr<PatternBytecode>, PatternBytecodeInterface::getLexicalBindings>(
 		embedName, "getLexicalBindings");
 	RegisterMethod<std::shared_ptr<PatternBytecode>, PatternBytecodeInterface::getPattern>(embedName, "getPattern");
+	RegisterMethod<std::shared_ptr<PatternBytecode>, PatternBytecodeInterface::getVariableSlots>(embedName,
+																								 "getVariableSlots");
 	RegisterMethod<std::shared_ptr<PatternBytecode>, PatternBytecodeInterface::length>(embedName, "length");
 	RegisterMethod<std::shared_ptr<PatternBytecode>, PatternBytecodeInterface::optimize>(embedName, "optimize");
 	RegisterMethod<std::shared_ptr<PatternBytecode>, PatternBytecodeInterface::toBoxes>(embedName, "toBoxes");
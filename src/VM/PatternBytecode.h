@@ -1,5 +1,6 @@
 #pragma once
 
+#include "VM/NativeCondition.h"
 #include "VM/Opcode.h"
 
 #include "ClassSupport.h"
@@ -12,10 +13,16 @@
 #include <optional>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace PatternMatcher
 {
+namespace BytecodeOptimizer
+{
+	enum class OptimizationLevel; // See VM/OptimizePatternBytecode.h
+}
+
 class PatternBytecode
 {
 
@@ -26,6 +33,50 @@ public:
 		std::vector<Operand> ops;
 	};
 
+	/// Registers a choice point must save: those live where it resumes (a TRY's alternatives, or after a SPLIT_SEQ)
+	struct ChoicePointSaveSet
+	{
+		std::vector<ExprRegIndex> exprRegs;
+		std::vector<BoolRegIndex> boolRegs;
+	};
+
+	/// Cases of a SWITCH_ON_HEAD or SWITCH_ON_LITERAL (indexed by its operand 1); the first key SameQ to the value wins
+	struct SwitchTable
+	{
+		std::vector<std::pair<Expr, Label>> cases;
+	};
+
+	/// Values of a MATCH_LITERAL_SET (indexed by its operand 1)
+	struct LiteralSet
+	{
+		std::vector<Expr> values;
+	};
+
+	/// Test of a Condition (indexed by operand 1 of EVAL_CONDITION/EVAL_NATIVE_CONDITION)
+	struct Condition
+	{
+		Expr test; // the condition expression
+		std::vector<size_t> slots; // variable slots the test references
+		std::vector<Expr> symbols; // their symbols, for Block[{x = value, ...}, test]
+		std::optional<NativeCondition> native; // EVAL_NATIVE_CONDITION program, reading the slots in order
+	};
+
+	/// Branches of an Alternatives that one TRY/RETRY/TRUST chain tries in turn, recorded when no
+	/// two of them can match the same expression and they bind the same variables: the order
+	/// they are tried in changes the cost of a match, never its result (see reorderAlternatives)
+	struct AlternativeChain
+	{
+		const MExpr* alternatives; // the Alternatives pattern, a node of getPattern()
+		std::vector<mint> parts; // part of alternatives tried k-th
+		std::vector<Label> resumeLabels; // label of the RETRY or TRUST starting branch k + 1
+	};
+
+	/// Successful matches per branch of each Alternatives (hits[part - 1]), as counted by the VM
+	using AlternativeProfile = std::unordered_map<const MExpr*, std::vector<size_t>>;
+
+	/// Order the compiler tries the interchangeable branches of each Alternatives in (parts, first tried first)
+	using AlternativeOrder = std::unordered_map<const MExpr*, std::vector<mint>>;
+
 	PatternBytecode() = default;
 	~PatternBytecode() = default;
 
@@ -56,6 +107,13 @@ public:
 	/// @brief Get the number of boolean registers used.
 	int getBoolRegisterCount() const { return boolRegisterCount; }
 
+	/// @brief Get the number of expression registers the compiler allocated before register allocation.
+	/// @note getExprRegisterCount() is the peak number live at once after allocation.
+	int getExprVirtualRegisterCount() const { return exprVirtualRegisterCount; }
+
+	/// @brief Get the number of boolean registers the compiler allocated before register allocation.
+	int getBoolVirtualRegisterCount() const { return boolVirtualRegisterCount; }
+
 	/// @brief Get the original pattern expression.
 	std::shared_ptr<MExpr> getPattern() const { return pattern; }
 
@@ -65,15 +123,96 @@ public:
 	/// @brief Get maximum block nesting depth
 	int getMaxBlockDepth() const;
 
-	/// @brief Count total number of jump instructions (JUMP + BRANCH_FALSE)
+	/// @brief Count total number of jump instructions (JUMP, BRANCH_FALSE, SAMEQ_BRANCH, BIND_OR_COMPARE)
 	int getJumpCount() const;
 
-	/// @brief Count number of backtracking choice points (TRY instructions)
+	/// @brief Count number of backtracking choice points (TRY and SPLIT_SEQ instructions)
 	int getBacktrackPointCount() const;
 
 	/// @brief Get the lexical bindings as an Association.
 	Expr getLexicalBindings() const;
 
+	/// @brief Get the lexical bindings (pattern variable -> register).
+	const std::unordered_map<std::string, ExprRegIndex>& getLexicalMap() const { return lexicalMap; }
+
+	/// @brief Get the number of pattern variable slots.
+	size_t getVariableCount() const { return variableNames.size(); }
+
+	/// @brief Get the variable name of a slot (e.g. "Global`x").
+	const std::string& getVariableName(size_t slot) const { return variableNames[slot]; }
+
+	/// @brief Get the variable names in slot order.
+	const std::vector<std::string>& getVariableNames() const { return variableNames; }
+
+	/// @brief Get the choice point save sets, keyed by the PC of their TRY or SPLIT_SEQ.
+	/// @note Computed by BytecodeAnalysis::computeChoicePointSaveSets; a choice point
+	///       without an entry saves every register.
+	const std::unordered_map<size_t, ChoicePointSaveSet>& getChoicePointSaveSets() const
+	{
+		return choicePointSaveSets;
+	}
+
+	/// @brief Set the choice point save sets (keyed by TRY or SPLIT_SEQ PC).
+	void setChoicePointSaveSets(std::unordered_map<size_t, ChoicePointSaveSet> saveSets)
+	{
+		choicePointSaveSets = std::move(saveSets);
+	}
+
+	/// @brief Get the switch tables, indexed by operand 1 of SWITCH_ON_HEAD/SWITCH_ON_LITERAL.
+	const std::vector<SwitchTable>& getSwitchTables() const { return switchTables; }
+
+	/// @brief Get mutable reference to the switch tables (for optimization passes).
+	std::vector<SwitchTable>& getSwitchTables() { return switchTables; }
+
+	/// @brief Add a switch table.
+	/// @return The index to use as the switch instruction's operand 1.
+	mint addSwitchTable(SwitchTable table)
+	{
+		switchTables.push_back(std::move(table));
+		return static_cast<mint>(switchTables.size() - 1);
+	}
+
+	/// @brief Get the literal sets, indexed by operand 1 of MATCH_LITERAL_SET.
+	const std::vector<LiteralSet>& getLiteralSets() const { return literalSets; }
+
+	/// @brief Add a literal set.
+	/// @return The index to use as the MATCH_LITERAL_SET's operand 1.
+	mint addLiteralSet(LiteralSet set)
+	{
+		literalSets.push_back(std::move(set));
+		return static_cast<mint>(literalSets.size() - 1);
+	}
+
+	/// @brief Get the conditions, indexed by operand 1 of EVAL_CONDITION/EVAL_NATIVE_CONDITION.
+	const std::vector<Condition>& getConditions() const { return conditions; }
+
+	/// @brief Add a condition.
+	/// @return The index to use as the condition instruction's operand 1.
+	mint addCondition(Condition condition)
+	{
+		conditions.push_back(std::move(condition));
+		return static_cast<mint>(conditions.size() - 1);
+	}
+
+	/// @brief Get the alternative chains whose branches can be reordered.
+	const std::vector<AlternativeChain>& getAlternativeChains() const { return alternativeChains; }
+
+	/// @brief Record an alternative chain whose branches can be reordered.
+	void addAlternativeChain(AlternativeChain chain) { alternativeChains.push_back(std::move(chain)); }
+
+	/// @brief Get the order the interchangeable alternatives were compiled in (empty: pattern order).
+	const AlternativeOrder& getAlternativeOrder() const { return alternativeOrder; }
+
+	/// @brief Get the optimization level the bytecode was compiled at.
+	BytecodeOptimizer::OptimizationLevel getOptimizationLevel() const { return optimizationLevel; }
+
+	/// @brief Record how the bytecode was compiled (so reorderAlternatives can compile it again).
+	void setCompilation(BytecodeOptimizer::OptimizationLevel level, AlternativeOrder order)
+	{
+		optimizationLevel = level;
+		alternativeOrder = std::move(order);
+	}
+
 	/// @brief Add an instruction to the bytecode.
 	/// @param op The opcode of the instruction.
 	/// @param ops_ The operands of the instruction.
@@ -89,14 +228,33 @@ public:
 	std::optional<size_t> resolveLabel(Label L) const;
 
 	void set_metadata(std::shared_ptr<MExpr> pattern, int exprRegs, int boolRegs,
-					  const std::unordered_map<std::string, ExprRegIndex>& lexicalBindings)
+					  const std::unordered_map<std::string, ExprRegIndex>& lexicalBindings,
+					  std::vector<std::string> variableSlots)
 	{
 		this->pattern = pattern;
 		this->exprRegisterCount = exprRegs;
 		this->boolRegisterCount = boolRegs;
+		this->exprVirtualRegisterCount = exprRegs;
+		this->boolVirtualRegisterCount = boolRegs;
 		this->lexicalMap = lexicalBindings;
+		this->variableNames = std::move(variableSlots);
 	}
 
+	/// @brief Rename every register operand and lexical binding (register allocation).
+	/// @param exprMap Old expression register -> new one
+	/// @param boolMap Old boolean register -> new one
+	/// @note The register counts become the number of registers the maps use.
+	void renameRegisters(const std::vector<size_t>& exprMap, const std::vector<size_t>& boolMap);
+
+	/// @brief Insert an instruction before pc (optimization passes).
+	/// @note Labels of pc label the inserted instruction; later labels move with their instructions.
+	void insertInstruction(size_t pc, Instruction instr);
+
+	/// @brief Remove instructions (optimization passes).
+	/// @param remove pc -> remove the instruction at pc
+	/// @note The labels of a removed instruction move to the next remaining one.
+	void eraseInstructions(const std::vector<bool>& remove);
+
 	/// @brief Converts the bytecode to a string representation (compact format for tests).
 	/// @return The string representation of the bytecode.
 	std::string toString() const;
@@ -105,9 +263,17 @@ public:
 	/// @return The formatted disassembly of the bytecode.
 	std::string disassemble() const;
 
-	/// @brief Optimize the bytecode (e.g., remove no-op instructions).
+	/// @brief Run the optimizer's full pipeline on the compiled bytecode.
+	/// @return True if the bytecode changed.
 	bool optimize();
 
+	/// @brief Compile the pattern again, trying the most frequent branch of every alternative chain first.
+	/// @param profile Successful matches per branch (see VirtualMachine::getAlternativeProfile).
+	/// @return The reordered bytecode, or nullptr if every chain is already in order.
+	/// @note Ties keep their current order. Variable slots keep their numbers, so bindings come
+	///       out in the same order.
+	std::shared_ptr<PatternBytecode> reorderAlternatives(const AlternativeProfile& profile) const;
+
 	/// @brief Initializes the embedded methods for the Bytecode class.
 	/// @param embedName The name to use for embedding.
 	void initializeEmbedMethods(const char* embedName);
@@ -119,7 +285,17 @@ private:
 	// metadata
 	int exprRegisterCount = 0; // number of registers used for Expr values
 	int boolRegisterCount = 0; // number of boolean registers (optional)
+	int exprVirtualRegisterCount = 0; // expr registers allocated by the compiler (before register allocation)
+	int boolVirtualRegisterCount = 0; // bool registers allocated by the compiler (before register allocation)
 	std::unordered_map<std::string, ExprRegIndex> lexicalMap; // pattern variable -> reg
+	std::vector<std::string> variableNames; // variable slot -> pattern variable (dense, first-occurrence order)
+	std::unordered_map<size_t, ChoicePointSaveSet> choicePointSaveSets; // TRY/SPLIT_SEQ pc -> registers to save
+	std::vector<SwitchTable> switchTables; // SWITCH_ON_HEAD/SWITCH_ON_LITERAL cases
+	std::vector<LiteralSet> literalSets; // MATCH_LITERAL_SET values
+	std::vector<Condition> conditions; // EVAL_CONDITION/EVAL_NATIVE_CONDITION tests
+	std::vector<AlternativeChain> alternativeChains; // TRY chains whose branches can be reordered
+	AlternativeOrder alternativeOrder; // order the chains' branches were compiled in
+	BytecodeOptimizer::OptimizationLevel optimizationLevel {}; // level the bytecode was compiled at
 	std::unordered_map<Label, size_t> labelMap;
 };
 
@@ -0,0 +1,139 @@
+#include "VM/TestIntrinsics.h"
+
+#include "Expr.h"
+
+#include <array>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace PatternMatcher
+{
+static constexpr std::array<TestIntrinsic, 11> allIntrinsics = {
+	TestIntrinsic::IntegerQ, TestIntrinsic::StringQ, TestIntrinsic::NumericQ, TestIntrinsic::EvenQ,
+	TestIntrinsic::OddQ, TestIntrinsic::Positive, TestIntrinsic::Negative, TestIntrinsic::NonNegative,
+	TestIntrinsic::AtomQ, TestIntrinsic::ListQ, TestIntrinsic::MachineNumberQ,
+};
+
+const char* testIntrinsicName(TestIntrinsic id)
+{
+	switch (id)
+	{
+		case TestIntrinsic::IntegerQ:
+			return "IntegerQ";
+		case TestIntrinsic::StringQ:
+			return "StringQ";
+		case TestIntrinsic::NumericQ:
+			return "NumericQ";
+		case TestIntrinsic::EvenQ:
+			return "EvenQ";
+		case TestIntrinsic::OddQ:
+			return "OddQ";
+		case TestIntrinsic::Positive:
+			return "Positive";
+		case TestIntrinsic::Negative:
+			return "Negative";
+		case TestIntrinsic::NonNegative:
+			return "NonNegative";
+		case TestIntrinsic::AtomQ:
+			return "AtomQ";
+		case TestIntrinsic::ListQ:
+			return "ListQ";
+		case TestIntrinsic::MachineNumberQ:
+			return "MachineNumberQ";
+	}
+	return "UNKNOWN";
+}
+
+/// The System` symbol of each of allIntrinsics, in the same order
+static const std::vector<Expr>& intrinsicSymbols()
+{
+	// Parsed once, on first use, as getExprConstants does
+	static const std::vector<Expr> symbols = [] {
+		std::vector<Expr> result;
+		result.reserve(allIntrinsics.size());
+		for (auto id : allIntrinsics)
+			result.push_back(Expr::ToExpression((std::string("System`") + testIntrinsicName(id)).c_str()));
+		return result;
+	}();
+	return symbols;
+}
+
+std::optional<TestIntrinsic> getTestIntrinsic(const Expr& test)
+{
+	// Only the System` symbols themselves: IntegerQ[#] &, Not@*IntegerQ, ... go to the kernel
+	const auto& symbols = intrinsicSymbols();
+	for (size_t i = 0; i < allIntrinsics.size(); ++i)
+	{
+		if (test.sameQ(symbols[i]))
+			return allIntrinsics[i];
+	}
+	return std::nullopt;
+}
+
+std::optional<bool> evalTestIntrinsic(TestIntrinsic id, const Expr& value)
+{
+	const auto& constants = getExprConstants();
+	Expr head = value.head();
+
+	// A machine integer is the one value whose test results are all known natively
+	bool integerHead = head.sameQ(constants.integerHead);
+	std::optional<mint> n = integerHead ? value.as<mint>() : std::nullopt;
+
+	switch (id)
+	{
+		case TestIntrinsic::IntegerQ:
+			if (n)
+				return true;
+			if (!integerHead)
+				return false;
+			break;
+		case TestIntrinsic::StringQ:
+			if (value.as<std::string_view>())
+				return true;
+			if (!head.sameQ(constants.stringHead))
+				return false;
+			break;
+		case TestIntrinsic::ListQ:
+			return head.sameQ(constants.listHead);
+		case TestIntrinsic::EvenQ:
+		case TestIntrinsic::OddQ:
+			if (n)
+				return (*n % 2 == 0) == (id == TestIntrinsic::EvenQ);
+			if (!integerHead)
+				return false;
+			break;
+		case TestIntrinsic::Positive:
+			if (n)
+				return *n > 0;
+			break;
+		case TestIntrinsic::Negative:
+			if (n)
+				return *n < 0;
+			break;
+		case TestIntrinsic::NonNegative:
+			if (n)
+				return *n >= 0;
+			break;
+		case TestIntrinsic::NumericQ:
+			if (n)
+				return true;
+			if (head.sameQ(constants.stringHead) || head.sameQ(constants.listHead))
+				return false;
+			break;
+		case TestIntrinsic::AtomQ:
+			if (n || value.as<std::string_view>())
+				return true;
+			if (head.sameQ(constants.listHead))
+				return false;
+			break;
+		case TestIntrinsic::MachineNumberQ:
+			// Only machine reals and complexes are machine numbers
+			if (!head.sameQ(constants.realHead) && !head.sameQ(constants.complexHead))
+				return false;
+			break;
+	}
+	return std::nullopt;
+}
+}; // namespace PatternMatcher
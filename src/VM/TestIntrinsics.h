@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Expr.h"
+
+#include <cstdint>
+#include <optional>
+
+namespace PatternMatcher
+{
+/*===========================================================================
+TestIntrinsics: Native PatternTest Predicates
+
+The predicates most PatternTests use (_?IntegerQ, _Integer?Positive, ...)
+are evaluated in C++ by TEST_INTRINSIC instead of building test[x] and
+evaluating it in the kernel. Each intrinsic answers natively when the
+answer is certain from the value's head and machine-integer value, and
+defers to the kernel otherwise (reals, big integers, symbolic constants
+like Pi, and unevaluated heads such as Integer[]), so results always agree
+with APPLY_TEST.
+===========================================================================*/
+
+enum class TestIntrinsic : uint8_t
+{
+	IntegerQ,
+	StringQ,
+	NumericQ,
+	EvenQ,
+	OddQ,
+	Positive,
+	Negative,
+	NonNegative,
+	AtomQ,
+	ListQ,
+	MachineNumberQ
+};
+
+/// @brief Get the intrinsic for a PatternTest test, if it has one
+/// @param test The test of the PatternTest (e.g. the symbol IntegerQ)
+std::optional<TestIntrinsic> getTestIntrinsic(const Expr& test);
+
+/// @brief Get the name of an intrinsic (e.g. "IntegerQ")
+const char* testIntrinsicName(TestIntrinsic id);
+
+/// @brief Evaluate an intrinsic natively
+/// @return The test result, or std::nullopt if only the kernel can tell
+std::optional<bool> evalTestIntrinsic(TestIntrinsic id, const Expr& value);
+}; // namespace PatternMatcher
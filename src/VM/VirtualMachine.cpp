@@ -1,8 +1,12 @@
 #include "VM/VirtualMachine.h"
 
 #include "VM/CompilePatternToBytecode.h"
+#include "VM/ExecutionEngine.h"
+#include "VM/LinkedBytecode.h"
+#include "VM/NativeCondition.h"
 #include "VM/PatternBytecode.h"
 #include "VM/Opcode.h"
+#include "VM/TestIntrinsics.h"
 
 #include "AST/MExpr.h"
 
@@ -10,6 +14,8 @@
 #include "Expr.h"
 #include "Logger.h"
 
+#include <algorithm>
+#include <iterator>
 #include <memory>
 #include <optional>
 
@@ -25,7 +31,8 @@ This file implements the pattern matching VM. Key design decisions:
 3. %b0 always holds "final match result"
 4. Frames created by BEGIN_BLOCK, popped by END_BLOCK
 5. Backtracking restores state but doesn't pop choice points
-   (RETRY updates them, TRUST removes them)
+   (RETRY updates them, TRUST removes them; a SPLIT_SEQ choice
+   point removes itself when it tries its last split)
 6. Trail records bindings only when choice points exist
 7. EXPORT_BINDINGS copies final bindings to resultFrame
 
@@ -37,21 +44,33 @@ Execution Flow:
 // Structured Trace Helper
 //=============================================================================
 
-#ifdef PM_LOG_LEVEL_TRACE
 /// Helper to emit structured trace data for better WL formatting
 /// Format: "opcode|result|details"
+/// @note Only reached from the Trace engine, which is selected per VM, so the
+///       record is emitted regardless of the global trace flag
 template <typename... Args>
 void traceOpcode(const char* opcode, const char* result, Args&&... args)
 {
-	PM_TRACE(opcode, "|", result, "|", std::forward<Args>(args)...);
+	Logger::traceAlways<Logger::Level::Trace>(__LINE__, __FILE__, __func__, opcode, "|", result, "|",
+											  std::forward<Args>(args)...);
 }
-#else
-// No-op version for release builds
-template <typename... Args>
-inline void traceOpcode(const char*, const char*, Args&&...)
-{
-}
-#endif
+
+/// Emit a trace record from code templated on an instrumentation Policy.
+/// The arguments are only evaluated in the Trace engine.
+#define VM_TRACE(...)                        \
+	do                                       \
+	{                                        \
+		if constexpr (Policy::trace)         \
+			traceOpcode(__VA_ARGS__);        \
+	} while (0)
+
+/// Bump an ExecutionStats counter from code templated on an instrumentation Policy.
+#define VM_STAT(counter)                     \
+	do                                       \
+	{                                        \
+		if constexpr (Policy::stats)         \
+			stats.counter += 1;              \
+	} while (0)
 
 VirtualMachine::VirtualMachine() = default;
 VirtualMachine::~VirtualMachine() = default;
@@ -69,6 +88,21 @@ void VirtualMachine::initialize(const std::shared_ptr<PatternBytecode>& bytecode
 	}
 	initialized = true;
 	bytecode = bytecode_;
+	program = LinkPatternBytecode(bytecode_);
+
+	// Frames are sized for this program's variable slots and reused across matches
+	frames.clear();
+	frameTrail.clear();
+	resultFrame.resize(program->getSlotCount());
+	conditionArgs.assign(program->getSlotCount(), nullptr);
+	buildConditionBlocks();
+
+	// The profile belongs to this program's chains
+	enteredBranches.assign(program->getAlternativeChainCount(), 0);
+	branchHits.clear();
+	for (const auto& chain : bytecode_->getAlternativeChains())
+		branchHits.emplace_back(chain.parts.size(), 0);
+	matchesSinceReorder = 0;
 	reset();
 }
 
@@ -79,12 +113,21 @@ void VirtualMachine::shutdown()
 
 	// Clear all state
 	bytecode.reset();
+	program.reset();
 	exprRegs.clear();
 	boolRegs.clear();
 	frames.clear();
+	frameDepth = 0;
+	frameTrail.clear();
+	frameTrailDepth = 0;
 	choiceStack.clear();
+	choiceDepth = 0;
 	trail.clear();
-	resultFrame.reset();
+	resultFrame.resize(0);
+	conditionArgs.clear();
+	conditionBlocks.clear();
+	enteredBranches.clear();
+	branchHits.clear();
 
 	initialized = false;
 	halted = false;
@@ -96,149 +139,261 @@ void VirtualMachine::reset()
 	pc = 0;
 	cycles = 0;
 	halted = false;
-	backtracking = false;
-	unwindingFailure = false;
+	failureCycle = NoFailureCycle;
 
-	// Clear result frame
+	// Clear result frame and statistics
 	resultFrame.reset();
+	stats.reset();
 
 	if (!bytecode)
 		return;
 
-	// Allocate registers based on bytecode metadata
-	exprRegs.assign(bytecode.value()->getExprRegisterCount(), Expr::ToExpression("Null"));
-	boolRegs.assign(bytecode.value()->getBoolRegisterCount(), false);
+	// Size registers from the bytecode metadata; after the first match this
+	// overwrites the existing storage and neither allocates nor parses
+	exprRegs.assign(bytecode.value()->getExprRegisterCount(), getExprConstants().nullSymbol);
+	boolRegs.assign(bytecode.value()->getBoolRegisterCount());
 
-	// Clear runtime state
-	frames.clear();
-	choiceStack.clear();
+	// Clear runtime state (the frame and choice point pools and the trails keep their allocations)
+	frameDepth = 0;
+	frameTrailDepth = 0;
+	choiceDepth = 0;
 	trail.clear();
+	std::fill(enteredBranches.begin(), enteredBranches.end(), 0);
+}
+
+void VirtualMachine::pushFrame()
+{
+	if (frameDepth == frames.size())
+	{
+		frames.emplace_back();
+		frames.back().resize(program->getSlotCount());
+	}
+	else
+	{
+		frames[frameDepth].reset();
+	}
+	frames[frameDepth].choiceMark = choiceDepth;
+	frameDepth++;
+}
+
+void VirtualMachine::popFrame()
+{
+	frameDepth--;
+
+	// A choice point made since the push may backtrack into this block: keep the frame
+	if (choiceDepth > frames[frameDepth].choiceMark)
+	{
+		if (frameTrailDepth == frameTrail.size())
+		{
+			frameTrail.emplace_back();
+			frameTrail.back().frame.resize(program->getSlotCount());
+		}
+		auto& saved = frameTrail[frameTrailDepth++];
+		saved.index = frameDepth;
+		std::swap(saved.frame, frames[frameDepth]);
+	}
+}
+
+void VirtualMachine::restoreFrames(size_t mark)
+{
+	while (frameTrailDepth > mark)
+	{
+		auto& saved = frameTrail[--frameTrailDepth];
+		std::swap(saved.frame, frames[saved.index]);
+	}
+}
+
+std::vector<std::pair<std::string, Expr>> VirtualMachine::getResultBindings() const
+{
+	std::vector<std::pair<std::string, Expr>> bindings;
+	bindings.reserve(resultFrame.boundCount);
+	resultFrame.forEachBinding(
+		[&](size_t slot, const Expr& value) { bindings.emplace_back(program->getSlotName(slot), value); });
+	return bindings;
 }
 
 /*===============================================================
 	Opcode Methods
 ================================================================*/
 
-void VirtualMachine::jump(LabelOp label, bool isFailure)
+template <typename Policy>
+void VirtualMachine::jump(size_t targetPC, bool isFailure)
 {
 	if (isFailure)
 	{
-		unwindingFailure = true;
+		failureCycle = cycles;
+		VM_STAT(failureJumps);
 	}
-	pc = bytecode.value()->resolveLabel(label.v).value();
-	traceOpcode(isFailure ? "FAIL_JUMP" : "JUMP", "INFO", "L", label.v, "pc=", pc);
+	pc = targetPC;
+	VM_TRACE(isFailure ? "FAIL_JUMP" : "JUMP", "INFO", "pc=", pc);
 }
 
+template <typename Policy>
 void VirtualMachine::saveBindings(Frame& tgtFrame)
 {
-	PM_ASSERT(!frames.empty(), "saveBindings: No frames available");
+	PM_ASSERT(frameDepth > 0, "saveBindings: No frames available");
 
 	// Copy bindings from current frame to target
-	const auto& srcFrame = frames.back();
-	for (const auto& [varName, value] : srcFrame.bindings)
-	{
-		tgtFrame.bindVariable(varName, value);
-	}
+	const auto& srcFrame = currentFrame();
+	srcFrame.forEachBinding([&](size_t slot, const Expr& value) { tgtFrame.bindVariable(slot, value); });
 
-	traceOpcode("SAVE_BINDINGS", "INFO", srcFrame.bindings.size(), "bindings copied");
+	VM_TRACE("SAVE_BINDINGS", "INFO", srcFrame.boundCount, "bindings copied");
 }
 
 //=============================================================================
 // Backtracking Support
 //=============================================================================
 
-void VirtualMachine::createChoicePoint(size_t nextAlternative)
+template <typename Policy>
+VirtualMachine::ChoicePoint& VirtualMachine::createChoicePoint(size_t nextAlternative,
+															   const LinkedBytecode::SaveSet& saveSet)
 {
-	choiceStack.emplace_back(pc, // Current PC (for debugging)
-							 nextAlternative, // Where to jump on FAIL
-							 exprRegs, // Copy current expression registers
-							 boolRegs, // Copy current boolean registers
-							 trail.size(), // Current trail position
-							 frames.size() // Current frame depth
+	auto& cp = pushChoicePoint();
+	cp.save(pc, // Current PC (for debugging)
+			nextAlternative, // Where to jump on FAIL
+			saveSet, // Registers live at the alternatives
+			exprRegs, // Copy the live expression registers
+			boolRegs, // Snapshot the boolean registers
+			trail.size(), // Current trail position
+			frameDepth, // Current frame depth
+			frameTrailDepth // Current frame trail position
 	);
 
-	traceOpcode("CHOICE_POINT", "INFO", "alternatives at L", nextAlternative, "depth=", choiceStack.size());
+	VM_STAT(choicePoints);
+	VM_TRACE("CHOICE_POINT", "INFO", "alternatives at pc=", nextAlternative, "depth=", choiceDepth,
+			 "saved=", saveSet.exprRegs.size());
+	return cp;
+}
+
+/// Split a Sequence into its first `length` parts and the rest (SPLIT_SEQ)
+static void splitSequence(const Expr& source, mint length, Expr& prefix, Expr& rest)
+{
+	const auto& sequenceHead = getExprConstants().sequenceHead;
+	mint total = source.length();
+
+	Expr first = Expr::createNormal(length, sequenceHead);
+	for (mint i = 1; i <= length; ++i)
+		first.setPart(i, source.part(i));
+
+	Expr second = Expr::createNormal(total - length, sequenceHead);
+	for (mint i = length + 1; i <= total; ++i)
+		second.setPart(i - length, source.part(i));
+
+	prefix = std::move(first);
+	rest = std::move(second);
 }
 
+template <typename Policy>
 bool VirtualMachine::backtrack()
 {
-	if (choiceStack.empty())
+	if (choiceDepth == 0)
 	{
-		traceOpcode("BACKTRACK", "TERMINAL", "no choice points");
+		VM_TRACE("BACKTRACK", "TERMINAL", "no choice points");
 		return false;
 	}
 
 	// Peek at choice point (don't pop - RETRY/TRUST handle that)
-	auto& cp = choiceStack.back();
+	auto& cp = currentChoicePoint();
 
-	// Restore registers from choice point
-	exprRegs = cp.savedExprRegs;
-	boolRegs = cp.savedBoolRegs;
+	// Restore the registers live at the alternative (the rest are dead there)
+	cp.restore(exprRegs, boolRegs);
 
-	// Restore frame stack to saved depth
-	while (frames.size() > cp.frameMark)
-	{
-		frames.pop_back();
-	}
+	// Restore the frame stack: bring back frames popped since the choice point
+	// was made (see SavedFrame), then drop frames pushed since
+	restoreFrames(cp.frameTrailMark);
+	frameDepth = cp.frameMark;
 
 	// Unwind trail to undo bindings made after choice point
-	unwindTrail(cp.trailMark);
+	unwindTrail<Policy>(cp.trailMark);
+
+	// Jump to next alternative (resolved to a PC at link time)
+	pc = cp.nextAlternative;
 
-	// Jump to next alternative (resolve label to instruction index)
-	auto nextPC = bytecode.value()->resolveLabel(cp.nextAlternative);
-	PM_ASSERT(nextPC.has_value(), "Failed to resolve label L", cp.nextAlternative);
-	pc = nextPC.value();
+	// SPLIT_SEQ: retry with the next length, removing the choice point at the last one
+	if (cp.split)
+	{
+		mint length = ++cp.splitLength;
+		splitSequence(cp.splitSource, length, exprRegs[cp.splitDst], exprRegs[cp.splitRest]);
+		VM_TRACE("BACKTRACK", "INFO", "split length=", length, "of", cp.splitMaxLength);
+		if (length == cp.splitMaxLength)
+		{
+			popChoicePoint();
+		}
+	}
 
-	traceOpcode("BACKTRACK", "INFO", "jumping to L", cp.nextAlternative, "pc=", pc);
+	VM_TRACE("BACKTRACK", "INFO", "jumping to pc=", pc);
 
-	// Set flags
-	backtracking = true;
-	unwindingFailure = true;
+	// The next instruction is reached by failure (see isUnwindingFailure)
+	failureCycle = cycles;
+	VM_STAT(backtracks);
 
 	// Choice point remains on stack!
 	// RETRY will update it, TRUST will remove it
 	return true;
 }
 
+template <typename Policy>
 void VirtualMachine::commit()
 {
-	if (!choiceStack.empty())
+	if (choiceDepth != 0)
 	{
-		traceOpcode("COMMIT", "INFO", "removing", choiceStack.size(), "choice points");
-		choiceStack.clear();
+		VM_TRACE("COMMIT", "INFO", "removing", choiceDepth, "choice points");
+		choiceDepth = 0;
+		frameTrailDepth = 0;
 	}
 }
-void VirtualMachine::trailBind(const std::string& varName, const Expr& value)
+template <typename Policy>
+void VirtualMachine::trailBind(size_t slot, const Expr& value)
 {
 	// Ensure we have a frame to bind in
 	// TODO: Is this a hack?
-	if (frames.empty())
+	if (frameDepth == 0)
 	{
-		frames.emplace_back();
+		pushFrame();
 	}
 
-	auto& currentFrame = frames.back();
+	auto& frame = currentFrame();
 
-	// If variable already bound, record it for potential undo
-	// This allows us to restore the old binding on backtrack
-	if (currentFrame.hasVariable(varName))
+	// Record the binding for undo if backtracking can return to this frame: it
+	// was pushed before the newest choice point (backtracking drops frames
+	// pushed after it), so a first binding must be undone too, or a retried
+	// alternative or SPLIT_SEQ would see the failed attempt's variables
+	if (frame.isBound(slot) || choiceDepth > frame.choiceMark)
 	{
-		trail.emplace_back(varName, frames.size() - 1);
-		traceOpcode("TRAIL", "INFO", "recording", varName, "size=", trail.size());
+		trail.emplace_back(slot, frameDepth - 1);
+		VM_TRACE("TRAIL", "INFO", "recording", program->getSlotName(slot), "size=", trail.size());
 	}
 
 	// Bind the variable (overwrites existing binding if any)
-	currentFrame.bindVariable(varName, value);
+	frame.bindVariable(slot, value);
 
-	traceOpcode("BIND_VAR", "INFO", varName, "←", value.toString(), "(trailed)");
+	VM_TRACE("BIND_VAR", "INFO", program->getSlotName(slot), "←", value.toString(), "(trailed)");
+}
+
+template <typename Policy>
+void VirtualMachine::bindVariable(size_t slot, const Expr& value)
+{
+	// Use trail if choice points exist (for backtracking)
+	// Otherwise bind directly (optimization)
+	if (hasChoicePoints())
+	{
+		trailBind<Policy>(slot, value);
+	}
+	else
+	{
+		PM_ASSERT(frameDepth > 0, "BIND_VAR: No active frame");
+		currentFrame().bindVariable(slot, value);
+		VM_TRACE("BIND_VAR", "INFO", program->getSlotName(slot), "←", value.toString(), "(no trail)");
+	}
 }
 
+template <typename Policy>
 void VirtualMachine::unwindTrail(size_t mark)
 {
 	if (trail.size() <= mark)
 		return; // Nothing to unwind
 
-	traceOpcode("UNWIND_TRAIL", "INFO", "from", trail.size(), "to", mark);
+	VM_TRACE("UNWIND_TRAIL", "INFO", "from", trail.size(), "to", mark);
 
 	// Undo bindings in reverse order (LIFO)
 	while (trail.size() > mark)
@@ -246,17 +401,82 @@ void VirtualMachine::unwindTrail(size_t mark)
 		const auto& entry = trail.back();
 
 		// Remove binding from frame (if frame still exists)
-		if (entry.frameIndex < frames.size())
+		if (entry.frameIndex < frameDepth)
 		{
-			auto& frame = frames[entry.frameIndex];
-			frame.bindings.erase(entry.varName);
-			traceOpcode("UNBIND", "INFO", entry.varName, "frame=", entry.frameIndex);
+			frames[entry.frameIndex].unbindVariable(entry.slot);
+			VM_TRACE("UNBIND", "INFO", program->getSlotName(entry.slot), "frame=", entry.frameIndex);
 		}
 
 		trail.pop_back();
 	}
 }
 
+/// Load the values of a condition's variables from the current frame into conditionArgs
+void VirtualMachine::loadConditionArgs(const PatternBytecode::Condition& condition)
+{
+	const Frame& frame = currentFrame();
+	for (size_t i = 0; i < condition.slots.size(); ++i)
+		conditionArgs[i] = frame.findVariable(condition.slots[i]);
+}
+
+/// Build the Block of every condition once; evaluations only fill in the values
+void VirtualMachine::buildConditionBlocks()
+{
+	const auto& constants = getExprConstants();
+	conditionBlocks.clear();
+	for (const auto& condition : program->getConditions())
+	{
+		// Block[{x = Null, y = Null, ...}, condition]
+		Expr assignmentList = Expr::createNormal(static_cast<mint>(condition.symbols.size()), constants.listHead);
+		std::vector<Expr> assignments;
+		assignments.reserve(condition.symbols.size());
+		for (size_t i = 0; i < condition.symbols.size(); ++i)
+		{
+			assignments.push_back(Expr::construct(constants.setHead, condition.symbols[i], constants.nullSymbol));
+			assignmentList.setPart(static_cast<mint>(i + 1), assignments.back());
+		}
+		conditionBlocks.push_back(
+			ConditionBlock { Expr::construct(constants.blockHead, assignmentList, condition.test), std::move(assignments) });
+	}
+}
+
+/// Evaluate a condition with the variables it references in scope:
+/// Block[{x = value1, y = value2, ...}, condition]
+/// Expects loadConditionArgs()
+Expr VirtualMachine::evalConditionInBlock(LinkedBytecode::Word index)
+{
+	const auto& condition = program->getCondition(index);
+	const auto& constants = getExprConstants();
+	size_t count = condition.slots.size();
+	size_t bound = static_cast<size_t>(
+		std::count_if(conditionArgs.begin(), conditionArgs.begin() + count, [](const Expr* v) { return v != nullptr; }));
+
+	if (bound == 0)
+		return condition.test.eval();
+
+	// A variable the pattern has not bound (yet) keeps its global value: leave it out of the Block
+	if (bound < count)
+	{
+		Expr assignmentList = Expr::createNormal(static_cast<mint>(bound), constants.listHead);
+		mint part = 1;
+		for (size_t i = 0; i < count; ++i)
+			if (conditionArgs[i])
+				assignmentList.setPart(part++, Expr::construct(constants.setHead, condition.symbols[i], *conditionArgs[i]));
+		return Expr::construct(constants.blockHead, assignmentList, condition.test).eval();
+	}
+
+	// Fill the values into the prebuilt Block (its x = value parts are updated in place)
+	auto& conditionBlock = conditionBlocks[index];
+	for (size_t i = 0; i < count; ++i)
+		conditionBlock.assignments[i].setPart(2, *conditionArgs[i]);
+	Expr result = conditionBlock.block.eval();
+
+	// Don't keep the values alive until the next evaluation
+	for (size_t i = 0; i < count; ++i)
+		conditionBlock.assignments[i].setPart(2, constants.nullSymbol);
+	return result;
+}
+
 //=============================================================================
 // Instruction Execution
 //=============================================================================
@@ -264,341 +484,545 @@ void VirtualMachine::unwindTrail(size_t mark)
 bool VirtualMachine::step()
 {
 	// Precondition checks
-	if (!initialized || halted || !bytecode)
+	if (!initialized || halted || !program)
 		return false;
 
-	const auto& instrs = bytecode.value()->getInstructions();
-	if (pc >= instrs.size())
+	if (pc >= program->length())
 	{
-		PM_WARNING("PC out of bounds: ", pc, " >= ", instrs.size());
+		PM_WARNING("PC out of bounds: ", pc, " >= ", program->length());
 		halted = true;
 		return false;
 	}
 
-	// Fetch instruction
-	const auto& instr = instrs[pc];
+	return executeWithEngine<true>();
+}
+
+/*
+ * Dispatch macros for execute().
+ *
+ * Each opcode handler is written once and shared by both executors:
+ * - VM_CASE(op) labels a handler (a switch case, plus a goto label when threaded)
+ * - VM_NEXT() finishes a handler: the single-step executor returns, the run
+ *   loop fetches the next instruction and dispatches to its handler
+ *
+ * On GCC/Clang the run loop uses computed goto ("labels as values"), so every
+ * handler ends in its own indirect jump and the branch predictor sees one
+ * dispatch site per opcode. Other compilers fall back to a switch loop
+ * (define PM_THREADED_DISPATCH=0 to force it).
+ *
+ * Computed goto does not run destructors of objects that go out of scope, so
+ * VM_NEXT() must only appear where no handler local is alive: after the
+ * handler's closing brace.
+ */
+#ifndef PM_THREADED_DISPATCH
+#if defined(__GNUC__) || defined(__clang__)
+#define PM_THREADED_DISPATCH 1
+#else
+#define PM_THREADED_DISPATCH 0
+#endif
+#endif
+
+#define VM_FETCH()                                                         \
+	instr = &instrs[pc];                                                   \
+	ops = instr->ops.data();                                               \
+	pc += 1;                                                               \
+	cycles += 1;                                                           \
+	if constexpr (Policy::stats)                                           \
+	stats.opcodeCounts[static_cast<size_t>(instr->opcode)] += 1
+
+#if PM_THREADED_DISPATCH
+#define VM_CASE(op) \
+	case Opcode::op: \
+	op_##op
+#define VM_NEXT()                                                       \
+	do                                                                  \
+	{                                                                   \
+		if constexpr (SingleStep)                                       \
+			return !halted;                                             \
+		VM_FETCH();                                                     \
+		goto* dispatchTable[static_cast<size_t>(instr->opcode)];        \
+	} while (0)
+#else
+#define VM_CASE(op) case Opcode::op
+#define VM_NEXT()                 \
+	do                            \
+	{                             \
+		if constexpr (SingleStep) \
+			return !halted;       \
+		goto dispatch;            \
+	} while (0)
+#endif
+
+template <typename Policy, bool SingleStep>
+bool VirtualMachine::execute()
+{
+#if PM_THREADED_DISPATCH
+	// Handler addresses, in Opcode enum order
+	static const void* const dispatchTable[] = {
+		&&op_MOVE,
+		&&op_LOAD_IMM,
+		&&op_GET_LENGTH,
+		&&op_GET_PART,
+		&&op_MATCH_HEAD,
+		&&op_MATCH_LENGTH,
+		&&op_MATCH_SHAPE,
+		&&op_MATCH_LITERAL,
+		&&op_MATCH_LITERAL_SET,
+		&&op_APPLY_TEST,
+		&&op_TEST_INTRINSIC,
+		&&op_EVAL_CONDITION,
+		&&op_EVAL_NATIVE_CONDITION,
+		&&op_MATCH_MIN_LENGTH,
+		&&op_MATCH_SHAPE_MIN,
+		&&op_MATCH_SEQ_HEADS,
+		&&op_MAKE_SEQUENCE,
+		&&op_SPLIT_SEQ,
+		&&op_SAMEQ,
+		&&op_SAMEQ_BRANCH,
+		&&op_BIND_VAR,
+		&&op_LOAD_VAR,
+		&&op_BIND_FROM,
+		&&op_BIND_OR_COMPARE,
+		&&op_JUMP,
+		&&op_BRANCH_FALSE,
+		&&op_SWITCH_ON_HEAD,
+		&&op_SWITCH_ON_LITERAL,
+		&&op_HALT,
+		&&op_BEGIN_BLOCK,
+		&&op_END_BLOCK,
+		&&op_EXPORT_BINDINGS,
+		&&op_TRY,
+		&&op_RETRY,
+		&&op_TRUST,
+		&&op_CUT,
+		&&op_FAIL,
+		&&op_DEBUG_PRINT,
+	};
+	static_assert(std::size(dispatchTable) == OpcodeCount, "dispatchTable must have one entry per opcode");
+#endif
+
+	const auto& instrs = program->getInstructions();
+	const LinkedBytecode::Instruction* instr;
+	const LinkedBytecode::Word* ops;
 
-	// Update state
-	pc += 1;
-	cycles += 1;
-	backtracking = false;
-	unwindingFailure = false;
+#if !PM_THREADED_DISPATCH
+dispatch:
+#endif
+	VM_FETCH();
 
 	// Decode and execute
-	switch (instr.opcode)
+	switch (instr->opcode)
 	{
 			//=====================================================================
 			// DEBUG
 			//=====================================================================
 
-		case Opcode::DEBUG_PRINT:
+		VM_CASE(DEBUG_PRINT):
 		{
-			if (!instr.ops.empty())
+			// The linked form has no printable operands; trace from the source bytecode
+			if constexpr (Policy::trace)
 			{
-				traceOpcode("DEBUG_PRINT", "INFO", operandToString(instr.ops[0]));
+				const auto& srcInstr = program->getSource()->getInstructions()[pc - 1];
+				if (!srcInstr.ops.empty())
+				{
+					traceOpcode("DEBUG_PRINT", "INFO", operandToString(srcInstr.ops[0]));
+				}
 			}
-			break;
 		}
+		VM_NEXT();
 
 			//=====================================================================
 			// DATA MOVEMENT
 			//=====================================================================
 
-		case Opcode::LOAD_IMM:
+		VM_CASE(LOAD_IMM):
 		{
 			// Immediate can be loaded into expr or bool register
-			if (auto dstExprReg = std::get_if<ExprRegOp>(&instr.ops[0]))
+			if (instr->kinds[0] == LinkedBytecode::OperandKind::ExprReg)
 			{
-				// Load Expr immediate
-				auto immExpr = std::get<ImmExpr>(instr.ops[1]);
-				exprRegs[dstExprReg->v] = immExpr;
-				traceOpcode("LOAD_IMM", "INFO", "%e", dstExprReg->v, "←", immExpr.toString());
+				// Load Expr immediate (from the constant pool)
+				exprRegs[ops[0]] = program->getConstant(ops[1]);
+				VM_TRACE("LOAD_IMM", "INFO", "%e", ops[0], "←", exprRegs[ops[0]].toString());
 			}
 			else
 			{
 				// Load boolean immediate (from mint: 0=false, non-zero=true)
-				auto dstBoolReg = std::get<BoolRegOp>(instr.ops[0]);
-				auto immMint = std::get<ImmMint>(instr.ops[1]);
-				bool value = (immMint.v != 0);
-				boolRegs[dstBoolReg.v] = value;
-				traceOpcode("LOAD_IMM", "INFO", "%b", dstBoolReg.v, "←", (value ? "True" : "False"));
+				bool value = (ops[1] != 0);
+				boolRegs.set(ops[0], value);
+				VM_TRACE("LOAD_IMM", "INFO", "%b", ops[0], "←", (value ? "True" : "False"));
 			}
-			break;
 		}
+		VM_NEXT();
 
-		case Opcode::MOVE:
+		VM_CASE(MOVE):
 		{
-			auto dst = std::get<ExprRegOp>(instr.ops[0]);
-			auto src = std::get<ExprRegOp>(instr.ops[1]);
-			exprRegs[dst.v] = exprRegs[src.v];
-			traceOpcode("MOVE", "INFO", "%e", dst.v, "←%e", src.v, "=", exprRegs[src.v].toString());
-			break;
+			auto dst = ops[0];
+			auto src = ops[1];
+			exprRegs[dst] = exprRegs[src];
+			VM_TRACE("MOVE", "INFO", "%e", dst, "←%e", src, "=", exprRegs[src].toString());
 		}
+		VM_NEXT();
 
 			//=====================================================================
 			// EXPRESSION INTROSPECTION
 			//=====================================================================
 
-		case Opcode::GET_PART:
+		VM_CASE(GET_PART):
 		{
-			auto dst = std::get<ExprRegOp>(instr.ops[0]);
-			auto src = std::get<ExprRegOp>(instr.ops[1]);
-			auto idx = std::get<ImmMint>(instr.ops[2]);
+			auto dst = ops[0];
+			auto src = ops[1];
+			auto idx = ops[2];
 
-			exprRegs[dst.v] = exprRegs[src.v].part(idx.v);
-			traceOpcode("GET_PART", "INFO", "%e", dst.v, ":=part(%e", src.v, ",", idx.v, ")");
-			break;
+			exprRegs[dst] = exprRegs[src].part(idx);
+			VM_TRACE("GET_PART", "INFO", "%e", dst, ":=part(%e", src, ",", idx, ")");
 		}
+		VM_NEXT();
 
-		case Opcode::GET_LENGTH:
+		VM_CASE(GET_LENGTH):
 		{
-			auto dst = std::get<ExprRegOp>(instr.ops[0]);
-			auto src = std::get<ExprRegOp>(instr.ops[1]);
+			auto dst = ops[0];
+			auto src = ops[1];
 
 			// Store length as integer expression
-			mint len = static_cast<mint>(exprRegs[src.v].length());
-			exprRegs[dst.v] = Expr(len);
+			mint len = static_cast<mint>(exprRegs[src].length());
+			exprRegs[dst] = Expr(len);
 
-			traceOpcode("GET_LENGTH", "INFO", "%e", dst.v, ":=length(%e", src.v, ")=", len);
-			break;
+			VM_TRACE("GET_LENGTH", "INFO", "%e", dst, ":=length(%e", src, ")=", len);
 		}
+		VM_NEXT();
 
 			//=====================================================================
 			// COMPARISON
 			//=====================================================================
 
-		case Opcode::APPLY_TEST:
+		VM_CASE(APPLY_TEST):
 		{
-			auto src = std::get<ExprRegOp>(instr.ops[0]);
-			auto patternTest = std::get<ImmExpr>(instr.ops[1]);
-			auto failLabel = std::get<LabelOp>(instr.ops[2]);
+			auto src = ops[0];
+			const Expr& patternTest = program->getConstant(ops[1]);
+			auto failTarget = ops[2];
 
-			Expr testRes = Expr::construct(patternTest, exprRegs[src.v]).eval();
+			Expr testRes = Expr::construct(patternTest, exprRegs[src]).eval();
 			bool success = static_cast<bool>(testRes);
 
-			traceOpcode("APPLY_TEST", success ? "SUCCESS" : "FAILURE", "%e", src.v, "test=", patternTest.toString());
+			VM_TRACE("APPLY_TEST", success ? "SUCCESS" : "FAILURE", "%e", src, "test=", patternTest.toString());
 
 			if (!success)
 			{
-				jump(failLabel, true);
+				jump<Policy>(failTarget, true);
 			}
-			break;
 		}
+		VM_NEXT();
 
-		case Opcode::EVAL_CONDITION:
+		VM_CASE(TEST_INTRINSIC):
 		{
-			auto condExpr = std::get<ImmExpr>(instr.ops[0]);
-			auto failLabel = std::get<LabelOp>(instr.ops[1]);
+			auto src = ops[0];
+			auto id = static_cast<TestIntrinsic>(ops[1]);
+			auto failTarget = ops[3];
+
+			// Fall back to the kernel when the native check cannot decide
+			auto nativeResult = evalTestIntrinsic(id, exprRegs[src]);
+			bool success = nativeResult
+							   ? *nativeResult
+							   : static_cast<bool>(Expr::construct(program->getConstant(ops[2]), exprRegs[src]).eval());
+
+			VM_TRACE("TEST_INTRINSIC", success ? "SUCCESS" : "FAILURE", "%e", src, "test=", testIntrinsicName(id),
+					 nativeResult ? "(native)" : "(kernel)");
+
+			if (!success)
+			{
+				jump<Policy>(failTarget, true);
+			}
+		}
+		VM_NEXT();
+
+		VM_CASE(EVAL_CONDITION):
+		{
+			const Expr& condExpr = program->getConstant(ops[0]);
+			auto index = ops[1];
+			auto failTarget = ops[2];
 
 			// Use Block to temporarily bind pattern variables during condition evaluation
 			// This mimics WL's pattern condition semantics: pattern /; condition
-			PM_ASSERT(!frames.empty(), "EVAL_CONDITION: No active frame");
+			PM_ASSERT(frameDepth > 0, "EVAL_CONDITION: No active frame");
 
-			Expr result = condExpr;
+			loadConditionArgs(program->getCondition(index));
+			Expr result = evalConditionInBlock(index);
 
-			// Build Block[{x = value1, y = value2, ...}, condition]
-			if (!frames.back().bindings.empty())
-			{
-				std::vector<Expr> assignments;
-				assignments.reserve(frames.back().bindings.size());
-				for (const auto& [varName, value] : frames.back().bindings)
-				{
-					// varName is like "Global`x"
-					// We need to create: x = value (where x is a symbol, not Symbol[...])
-					// Use ToExpression to parse "Global`x" as a symbol
-					Expr symbolExpr = Expr::ToExpression(varName.c_str());
-					Expr assignment = Expr::construct("Set", symbolExpr, value);
-					assignments.push_back(assignment);
-				}
+			VM_TRACE("EVAL_CONDITION", result ? "SUCCESS" : "FAILURE", "cond=", condExpr.toInputFormString(),
+						"result=", result.toInputFormString());
 
-				// Create {x = value1, y = value2, ...}
-				Expr assignmentList = Expr::createNormal(assignments.size(), "List");
-				for (size_t i = 0; i < assignments.size(); ++i)
-				{
-					assignmentList.setPart(static_cast<mint>(i + 1), assignments[i]);
-				}
-				// Evaluate: Block[{assignments}, condition]
-				Expr blockedExpr = Expr::construct("Block", assignmentList, condExpr);
-				result = blockedExpr.eval();
+			if (!result)
+			{
+				jump<Policy>(failTarget, true);
 			}
-			else
+		}
+		VM_NEXT();
+
+		VM_CASE(EVAL_NATIVE_CONDITION):
+		{
+			const Expr& condExpr = program->getConstant(ops[0]);
+			auto index = ops[1];
+			auto failTarget = ops[2];
+
+			PM_ASSERT(frameDepth > 0, "EVAL_NATIVE_CONDITION: No active frame");
+
+			// Fall back to the kernel (as EVAL_CONDITION) when the native code cannot decide
+			const auto& condition = program->getCondition(index);
+			loadConditionArgs(condition);
+			auto nativeResult = condition.native->evaluate(conditionArgs.data());
+			bool success = nativeResult ? *nativeResult : static_cast<bool>(evalConditionInBlock(index));
+
+			VM_TRACE("EVAL_NATIVE_CONDITION", success ? "SUCCESS" : "FAILURE", "cond=", condExpr.toInputFormString(),
+					 nativeResult ? "(native)" : "(kernel)");
+
+			if (!success)
 			{
-				// No bindings, just evaluate the condition directly
-				result = condExpr.eval();
+				jump<Policy>(failTarget, true);
 			}
+		}
+		VM_NEXT();
 
-			traceOpcode("EVAL_CONDITION", result ? "SUCCESS" : "FAILURE", "cond=", condExpr.toInputFormString(),
-						"result=", result.toInputFormString());
+		VM_CASE(SAMEQ):
+		{
+			auto dstBool = ops[0];
+			auto lhs = ops[1];
+			auto rhs = ops[2];
 
-			if (!result)
+			bool result = exprRegs[lhs].sameQ(exprRegs[rhs]);
+			boolRegs.set(dstBool, result);
+
+			VM_TRACE("SAMEQ", result ? "TRUE" : "FALSE", "%b", dstBool, ":=(%e", lhs, "==%e", rhs, ")");
+		}
+		VM_NEXT();
+
+		VM_CASE(SAMEQ_BRANCH):
+		{
+			auto lhs = ops[0];
+			auto rhs = ops[1];
+			auto target = static_cast<size_t>(ops[2]);
+
+			if (!exprRegs[lhs].sameQ(exprRegs[rhs]))
 			{
-				jump(failLabel, true);
+				pc = target;
+				VM_TRACE("SAMEQ_BRANCH", "TAKEN", "%e", lhs, "!=%e", rhs, "⟹pc=", pc);
+			}
+			else
+			{
+				VM_TRACE("SAMEQ_BRANCH", "SKIP", "%e", lhs, "==%e", rhs);
 			}
-			break;
 		}
+		VM_NEXT();
 
-		case Opcode::SAMEQ:
+		VM_CASE(MATCH_LENGTH):
 		{
-			auto dstBool = std::get<BoolRegOp>(instr.ops[0]);
-			auto lhs = std::get<ExprRegOp>(instr.ops[1]);
-			auto rhs = std::get<ExprRegOp>(instr.ops[2]);
+			auto src = ops[0];
+			auto expectedLen = ops[1];
+			auto failTarget = ops[2];
 
-			bool result = exprRegs[lhs.v].sameQ(exprRegs[rhs.v]);
-			boolRegs[dstBool.v] = result;
+			size_t actualLen = exprRegs[src].length();
+			bool matches = (actualLen == static_cast<size_t>(expectedLen));
 
-			traceOpcode("SAMEQ", result ? "TRUE" : "FALSE", "%b", dstBool.v, ":=(%e", lhs.v, "==%e", rhs.v, ")");
-			break;
+			VM_TRACE("MATCH_LENGTH", matches ? "SUCCESS" : "FAILURE", "%e", src, "len=", actualLen,
+						"expected=", expectedLen);
+
+			if (!matches)
+			{
+				jump<Policy>(failTarget, true);
+			}
 		}
+		VM_NEXT();
 
+		VM_CASE(MATCH_HEAD):
+		{
+			auto src = ops[0];
+			const Expr& expected = program->getConstant(ops[1]);
+			auto failTarget = ops[2];
+
+			bool matches = exprRegs[src].head().sameQ(expected);
 
+			VM_TRACE("MATCH_HEAD", matches ? "SUCCESS" : "FAILURE", "%e", src, "==", expected.toString());
 
-		case Opcode::MATCH_LENGTH:
+			if (!matches)
+			{
+				jump<Policy>(failTarget, true);
+			}
+		}
+		VM_NEXT();
+
+		VM_CASE(MATCH_SHAPE):
 		{
-			auto src = std::get<ExprRegOp>(instr.ops[0]);
-			auto expectedLen = std::get<ImmMint>(instr.ops[1]);
-			auto failLabel = std::get<LabelOp>(instr.ops[2]);
+			auto src = ops[0];
+			const Expr& expectedHead = program->getConstant(ops[1]);
+			auto expectedLen = ops[2];
+			auto failTarget = ops[3];
 
-			size_t actualLen = exprRegs[src.v].length();
-			bool matches = (actualLen == static_cast<size_t>(expectedLen.v));
+			// Arity first: it is an integer compare, while the head check extracts part 0
+			const Expr& srcExpr = exprRegs[src];
+			size_t actualLen = srcExpr.length();
+			bool matches = actualLen == static_cast<size_t>(expectedLen) && srcExpr.head().sameQ(expectedHead);
 
-			traceOpcode("MATCH_LENGTH", matches ? "SUCCESS" : "FAILURE", "%e", src.v, "len=", actualLen,
-						"expected=", expectedLen.v);
+			VM_TRACE("MATCH_SHAPE", matches ? "SUCCESS" : "FAILURE", "%e", src, "len=", actualLen,
+						"expected=", expectedHead.toString(), "/", expectedLen);
 
 			if (!matches)
 			{
-				jump(failLabel, true);
+				jump<Policy>(failTarget, true);
 			}
-			break;
 		}
+		VM_NEXT();
 
-		case Opcode::MATCH_HEAD:
+		VM_CASE(MATCH_LITERAL):
 		{
-			auto src = std::get<ExprRegOp>(instr.ops[0]);
-			auto expected = std::get<ImmExpr>(instr.ops[1]);
-			auto failLabel = std::get<LabelOp>(instr.ops[2]);
+			auto src = ops[0];
+			const Expr& expected = program->getConstant(ops[1]);
+			auto failTarget = ops[2];
 
-			bool matches = exprRegs[src.v].head().sameQ(expected);
+			bool matches = exprRegs[src].sameQ(expected);
 
-			traceOpcode("MATCH_HEAD", matches ? "SUCCESS" : "FAILURE", "%e", src.v, "==", expected.toString());
+			VM_TRACE("MATCH_LITERAL", matches ? "SUCCESS" : "FAILURE", "%e", src, "==", expected.toString());
 
 			if (!matches)
 			{
-				jump(failLabel, true);
+				jump<Policy>(failTarget, true);
 			}
-			break;
 		}
+		VM_NEXT();
 
-		case Opcode::MATCH_LITERAL:
+		VM_CASE(MATCH_LITERAL_SET):
 		{
-			auto src = std::get<ExprRegOp>(instr.ops[0]);
-			auto expected = std::get<ImmExpr>(instr.ops[1]);
-			auto failLabel = std::get<LabelOp>(instr.ops[2]);
+			auto src = ops[0];
+			const auto& set = program->getLiteralSet(ops[1]);
+			auto failTarget = ops[2];
 
-			bool matches = exprRegs[src.v].sameQ(expected);
+			bool matches = set.contains(exprRegs[src]);
 
-			traceOpcode("MATCH_LITERAL", matches ? "SUCCESS" : "FAILURE", "%e", src.v, "==", expected.toString());
+			VM_TRACE("MATCH_LITERAL_SET", matches ? "SUCCESS" : "FAILURE", "%e", src, "∈ set", ops[1]);
 
 			if (!matches)
 			{
-				jump(failLabel, true);
+				jump<Policy>(failTarget, true);
 			}
-			break;
 		}
+		VM_NEXT();
 
 			//=====================================================================
 			// SEQUENCE MATCHING
 			//=====================================================================
 
-		case Opcode::MATCH_MIN_LENGTH:
+		VM_CASE(MATCH_MIN_LENGTH):
 		{
-			auto src = std::get<ExprRegOp>(instr.ops[0]);
-			auto minLen = std::get<ImmMint>(instr.ops[1]);
-			auto failLabel = std::get<LabelOp>(instr.ops[2]);
+			auto src = ops[0];
+			auto minLen = ops[1];
+			auto failTarget = ops[2];
 
-			size_t actualLen = exprRegs[src.v].length();
-			bool matches = (actualLen >= static_cast<size_t>(minLen.v));
+			size_t actualLen = exprRegs[src].length();
+			bool matches = (actualLen >= static_cast<size_t>(minLen));
 
-			traceOpcode("MATCH_MIN_LENGTH", matches ? "SUCCESS" : "FAILURE", "%e", src.v, "len=", actualLen,
-						"min=", minLen.v);
+			VM_TRACE("MATCH_MIN_LENGTH", matches ? "SUCCESS" : "FAILURE", "%e", src, "len=", actualLen,
+						"min=", minLen);
 
 			if (!matches)
 			{
-				jump(failLabel, true);
+				jump<Policy>(failTarget, true);
+			}
+		}
+		VM_NEXT();
+
+		VM_CASE(MATCH_SHAPE_MIN):
+		{
+			auto src = ops[0];
+			const Expr& expectedHead = program->getConstant(ops[1]);
+			auto minLen = ops[2];
+			auto failTarget = ops[3];
+
+			const Expr& srcExpr = exprRegs[src];
+			size_t actualLen = srcExpr.length();
+			bool matches = actualLen >= static_cast<size_t>(minLen) && srcExpr.head().sameQ(expectedHead);
+
+			VM_TRACE("MATCH_SHAPE_MIN", matches ? "SUCCESS" : "FAILURE", "%e", src, "len=", actualLen,
+						"expected=", expectedHead.toString(), "/", minLen, "+");
+
+			if (!matches)
+			{
+				jump<Policy>(failTarget, true);
 			}
-			break;
 		}
+		VM_NEXT();
 
-		case Opcode::MATCH_SEQ_HEADS:
+		VM_CASE(MATCH_SEQ_HEADS):
 		{
-			auto src = std::get<ExprRegOp>(instr.ops[0]);
-			auto startIdx = std::get<ImmMint>(instr.ops[1]);
-			auto endReg = std::get<ExprRegOp>(instr.ops[2]);
-			auto expectedHead = std::get<ImmExpr>(instr.ops[3]);
-			auto failLabel = std::get<LabelOp>(instr.ops[4]);
+			auto src = ops[0];
+			mint startIdx = ops[1];
+			auto endReg = ops[2];
+			const Expr& expectedHead = program->getConstant(ops[3]);
+			auto failTarget = ops[4];
 
 			// End index is in a register (as an integer stored in Expr)
-			mint actualEnd = exprRegs[endReg.v].as<mint>().value();
-			mint srcLen = static_cast<mint>(exprRegs[src.v].length());
+			mint actualEnd = exprRegs[endReg].as<mint>().value();
+			mint srcLen = static_cast<mint>(exprRegs[src].length());
 
 			// Handle empty range: if actualEnd < startIdx, the range is empty
 			// Empty range succeeds (vacuous truth: all 0 elements have the right head)
-			if (actualEnd < startIdx.v)
+			if (actualEnd < startIdx)
 			{
-				traceOpcode("MATCH_SEQ_HEADS", "EMPTY_RANGE", "%e", src.v, "[", startIdx.v, "..", actualEnd, "]",
+				VM_TRACE("MATCH_SEQ_HEADS", "EMPTY_RANGE", "%e", src, "[", startIdx, "..", actualEnd, "]",
 							"- vacuously true");
-				break;
 			}
-
 			// Validate bounds for non-empty range
-			if (startIdx.v < 1 || actualEnd > srcLen)
+			else if (startIdx < 1 || actualEnd > srcLen)
 			{
-				traceOpcode("MATCH_SEQ_HEADS", "INVALID", "%e", src.v, "[", startIdx.v, "..", actualEnd, "]",
+				VM_TRACE("MATCH_SEQ_HEADS", "INVALID", "%e", src, "[", startIdx, "..", actualEnd, "]",
 							"srcLen=", srcLen);
-				jump(failLabel, true);
-				break;
+				jump<Policy>(failTarget, true);
 			}
-
-			// Check each part's head in range [startIdx, actualEnd]
-			const Expr& srcExpr = exprRegs[src.v];
-			for (mint i = startIdx.v; i <= actualEnd; ++i)
+			else
 			{
-				if (!srcExpr.part(static_cast<size_t>(i)).head().sameQ(expectedHead))
+				// Check each part's head in range [startIdx, actualEnd]
+				const Expr& srcExpr = exprRegs[src];
+				mint i = startIdx;
+				while (i <= actualEnd && srcExpr.part(static_cast<size_t>(i)).head().sameQ(expectedHead))
+				{
+					++i;
+				}
+
+				if (i <= actualEnd)
 				{
-					traceOpcode("MATCH_SEQ_HEADS", "FAILURE", "%e", src.v, "[", startIdx.v, "..", actualEnd,
+					VM_TRACE("MATCH_SEQ_HEADS", "FAILURE", "%e", src, "[", startIdx, "..", actualEnd,
 								"]==", expectedHead.toString(), "at", i);
-					jump(failLabel, true);
-					break;
+					jump<Policy>(failTarget, true);
+				}
+				else
+				{
+					VM_TRACE("MATCH_SEQ_HEADS", "SUCCESS", "%e", src, "[", startIdx, "..", actualEnd,
+								"]==", expectedHead.toString());
 				}
 			}
-
-			traceOpcode("MATCH_SEQ_HEADS", "SUCCESS", "%e", src.v, "[", startIdx.v, "..", actualEnd,
-						"]==", expectedHead.toString());
-			break;
 		}
+		VM_NEXT();
 
-		case Opcode::MAKE_SEQUENCE:
+		VM_CASE(MAKE_SEQUENCE):
 		{
-			auto dst = std::get<ExprRegOp>(instr.ops[0]);
-			auto src = std::get<ExprRegOp>(instr.ops[1]);
-			auto startIdx = std::get<ImmMint>(instr.ops[2]);
+			auto dst = ops[0];
+			auto src = ops[1];
+			mint startIdx = ops[2];
 
-			mint srcLength = static_cast<mint>(exprRegs[src.v].length());
+			mint srcLength = static_cast<mint>(exprRegs[src].length());
 
 			// Fourth operand can be either ImmMint or ExprRegOp (for dynamic length)
 			mint actualEnd;
-			if (auto* immEnd = std::get_if<ImmMint>(&instr.ops[3]))
+			if (instr->kinds[3] == LinkedBytecode::OperandKind::Mint)
 			{
-				actualEnd = immEnd->v;
+				actualEnd = ops[3];
 				// Support negative indices: -1 = last, -2 = second-to-last, etc.
 				if (actualEnd < 0)
 				{
 					actualEnd = srcLength + actualEnd + 1;
 				}
 			}
-			else if (auto* regEnd = std::get_if<ExprRegOp>(&instr.ops[3]))
+			else if (instr->kinds[3] == LinkedBytecode::OperandKind::ExprReg)
 			{
 				// End index is in a register (as an integer stored in Expr)
-				mint endVal = exprRegs[regEnd->v].as<mint>().value();
+				mint endVal = exprRegs[ops[3]].as<mint>().value();
 				actualEnd = endVal < 0 ? srcLength + endVal + 1 : endVal;
 			}
 			else
@@ -608,276 +1032,323 @@ bool VirtualMachine::step()
 			}
 
 			// Validate indices (compiler should ensure validity, but check in debug mode)
-			PM_ASSERT(startIdx.v >= 1 && startIdx.v <= srcLength + 1, "MAKE_SEQUENCE: invalid start index");
+			PM_ASSERT(startIdx >= 1 && startIdx <= srcLength + 1, "MAKE_SEQUENCE: invalid start index");
 			PM_ASSERT(actualEnd >= 0 && actualEnd <= srcLength, "MAKE_SEQUENCE: invalid end index");
 
 			// Handle empty sequence (startIdx > actualEnd for nullable sequences)
-			if (startIdx.v > actualEnd)
+			if (startIdx > actualEnd)
 			{
 				// Create empty Sequence[]
-				exprRegs[dst.v] = Expr::createNormal(0, "System`Sequence");
-				traceOpcode("MAKE_SEQUENCE", "INFO", "%e", dst.v, ":=Sequence[]", "(empty)");
-				break;
-			}
-
-			// Extract subsequence and wrap in Sequence
-			size_t numParts = static_cast<size_t>(actualEnd - startIdx.v + 1);
-			std::vector<Expr> parts;
-			parts.reserve(numParts);
-
-			for (mint i = startIdx.v; i <= actualEnd; ++i)
-			{
-				parts.push_back(exprRegs[src.v].part(static_cast<size_t>(i)));
+				exprRegs[dst] = Expr::createNormal(0, getExprConstants().sequenceHead);
+				VM_TRACE("MAKE_SEQUENCE", "INFO", "%e", dst, ":=Sequence[]", "(empty)");
 			}
-
-			// Create Sequence[part1, part2, ...]
-			Expr seqExpr = Expr::createNormal(parts.size(), "System`Sequence");
-			for (size_t i = 0; i < parts.size(); ++i)
+			else
 			{
-				seqExpr.setPart(i + 1, parts[i]);
-			}
+				// Extract subsequence and wrap in Sequence[part1, part2, ...]
+				size_t numParts = static_cast<size_t>(actualEnd - startIdx + 1);
+				Expr seqExpr = Expr::createNormal(numParts, getExprConstants().sequenceHead);
+				for (mint i = startIdx; i <= actualEnd; ++i)
+				{
+					seqExpr.setPart(i - startIdx + 1, exprRegs[src].part(static_cast<size_t>(i)));
+				}
 
-			exprRegs[dst.v] = seqExpr;
+				exprRegs[dst] = seqExpr;
 
-			traceOpcode("MAKE_SEQUENCE", "INFO", "%e", dst.v, ":=Sequence[%e", src.v, "[[", startIdx.v, "..", actualEnd, "]]");
-			break;
+				VM_TRACE("MAKE_SEQUENCE", "INFO", "%e", dst, ":=Sequence[%e", src, "[[", startIdx, "..", actualEnd,
+							"]]");
+			}
 		}
+		VM_NEXT();
 
-		case Opcode::SPLIT_SEQ:
+		VM_CASE(SPLIT_SEQ):
 		{
-			auto src = std::get<ExprRegOp>(instr.ops[0]);
-			auto splitPos = std::get<ImmMint>(instr.ops[1]);
-			auto minRest = std::get<ImmMint>(instr.ops[2]);
-			auto nextLabel = std::get<LabelOp>(instr.ops[3]);
-			auto failLabel = std::get<LabelOp>(instr.ops[4]);
-
-			// This creates a choice point for sequence splitting
-			// On backtrack, we'll try the next split position
+			auto dst = ops[0];
+			auto rest = ops[1];
+			mint minLen = ops[2];
+			mint minRest = ops[3];
 
-			// Calculate if this split is valid
-			mint totalLen = static_cast<mint>(exprRegs[src.v].length());
-			mint seqLen = splitPos.v;
-			mint remaining = totalLen - seqLen;
+			// The later segments need at least minRest parts, which bounds this one
+			Expr source = exprRegs[rest];
+			mint maxLen = source.length() - minRest;
 
-			if (remaining < minRest.v || seqLen < 1)
+			if (maxLen < minLen)
 			{
-				// Invalid split, jump to fail
-				traceOpcode("SPLIT_SEQ", "INVALID", "splitPos=", splitPos.v, "minRest=", minRest.v, "totalLen=", totalLen);
-				jump(failLabel, true);
+				// No split leaves room for the later segments: fail like FAIL
+				VM_TRACE("SPLIT_SEQ", "FAILURE", "%e", rest, "minLen=", minLen, "maxLen=", maxLen);
+				if (!backtrack<Policy>())
+				{
+					halted = true;
+					boolRegs.set(0, false);
+					return false;
+				}
 			}
 			else
 			{
-				// Valid split - create choice point
-				// On backtrack, decrement splitPos and retry
-				traceOpcode("SPLIT_SEQ", "INFO", "choice point splitPos=", splitPos.v, "nextLabel=", nextLabel.v);
-
-				// TODO: Implement proper choice point with split position tracking
-				// For now, this is a placeholder that doesn't actually create backtracking state
-				PM_WARNING("SPLIT_SEQ choice point creation not fully implemented");
+				// Shortest split first; the choice point tries the longer ones on backtrack
+				if (minLen < maxLen)
+				{
+					auto& cp = createChoicePoint<Policy>(pc, program->getSaveSet(ops[4]));
+					cp.split = true;
+					cp.splitSource = source;
+					cp.splitDst = static_cast<size_t>(dst);
+					cp.splitRest = static_cast<size_t>(rest);
+					cp.splitLength = minLen;
+					cp.splitMaxLength = maxLen;
+				}
 
-				// Continue with current split
+				splitSequence(source, minLen, exprRegs[dst], exprRegs[rest]);
+				VM_TRACE("SPLIT_SEQ", "INFO", "%e", dst, ":=", minLen, "parts of %e", rest, "maxLen=", maxLen);
 			}
-			break;
 		}
+		VM_NEXT();
 
 			//=====================================================================
 			// CONTROL FLOW
 			//=====================================================================
 
-		case Opcode::JUMP:
+		VM_CASE(JUMP):
 		{
-			auto label = std::get<LabelOp>(instr.ops[0]);
-			jump(label, false);
-			break;
+			jump<Policy>(ops[0], false);
 		}
+		VM_NEXT();
 
-		case Opcode::BRANCH_FALSE:
+		VM_CASE(BRANCH_FALSE):
 		{
-			auto condReg = std::get<BoolRegOp>(instr.ops[0]);
-			auto label = std::get<LabelOp>(instr.ops[1]);
+			auto condReg = ops[0];
+			auto target = static_cast<size_t>(ops[1]);
 
-			if (!boolRegs[condReg.v])
+			if (!boolRegs.get(condReg))
 			{
-				auto targetPC = bytecode.value()->resolveLabel(label.v);
-				PM_ASSERT(targetPC.has_value(), "Failed to resolve label L", label.v);
-				pc = targetPC.value();
-				traceOpcode("BRANCH_FALSE", "TAKEN", "%b", condReg.v, "⟹L", label.v, "pc=", pc);
+				pc = target;
+				VM_TRACE("BRANCH_FALSE", "TAKEN", "%b", condReg, "⟹pc=", pc);
 			}
 			else
 			{
-				traceOpcode("BRANCH_FALSE", "SKIP", "%b", condReg.v, "(true)");
+				VM_TRACE("BRANCH_FALSE", "SKIP", "%b", condReg, "(true)");
 			}
-			break;
 		}
+		VM_NEXT();
+
+		VM_CASE(SWITCH_ON_HEAD):
+		{
+			auto src = ops[0];
+			const auto& table = program->getJumpTable(ops[1]);
+			auto target = table.lookup(exprRegs[src].head(), ops[2]);
+
+			VM_TRACE("SWITCH_ON_HEAD", target == ops[2] ? "DEFAULT" : "CASE", "%e", src, "⟹pc=", target);
+			jump<Policy>(static_cast<size_t>(target), false);
+		}
+		VM_NEXT();
+
+		VM_CASE(SWITCH_ON_LITERAL):
+		{
+			auto src = ops[0];
+			const auto& table = program->getJumpTable(ops[1]);
+			auto target = table.lookup(exprRegs[src], ops[2]);
+
+			VM_TRACE("SWITCH_ON_LITERAL", target == ops[2] ? "DEFAULT" : "CASE", "%e", src, "⟹pc=", target);
+			jump<Policy>(static_cast<size_t>(target), false);
+		}
+		VM_NEXT();
 
-		case Opcode::HALT:
+		VM_CASE(HALT):
 		{
 			halted = true;
-			traceOpcode("HALT", "INFO", "stopping execution", "cycles=", cycles);
-			break;
+			VM_TRACE("HALT", "INFO", "stopping execution", "cycles=", cycles);
+			return false;
 		}
 
 			//=====================================================================
 			// VARIABLE BINDING
 			//=====================================================================
 
-		case Opcode::BIND_VAR:
+		VM_CASE(BIND_VAR):
+		{
+			auto slot = static_cast<size_t>(ops[0]);
+			auto reg = ops[1];
+
+			bindVariable<Policy>(slot, exprRegs[reg]);
+		}
+		VM_NEXT();
+
+		VM_CASE(BIND_FROM):
+		{
+			auto dst = ops[0];
+			auto src = ops[1];
+			auto slot = static_cast<size_t>(ops[2]);
+
+			exprRegs[dst] = exprRegs[src];
+			VM_TRACE("BIND_FROM", "INFO", "%e", dst, "←%e", src);
+			bindVariable<Policy>(slot, exprRegs[src]);
+		}
+		VM_NEXT();
+
+		VM_CASE(BIND_OR_COMPARE):
 		{
-			auto varName = std::get<Ident>(instr.ops[0]);
-			auto reg = std::get<ExprRegOp>(instr.ops[1]);
+			auto var = ops[0];
+			auto src = ops[1];
+			auto slot = static_cast<size_t>(ops[2]);
+			auto target = static_cast<size_t>(ops[3]);
 
-			// Use trail if choice points exist (for backtracking)
-			// Otherwise bind directly (optimization)
-			if (hasChoicePoints())
+			// First occurrence binds; later occurrences must be SameQ to the stored value
+			if (exprRegs[var].sameQ(getExprConstants().failureSymbol))
 			{
-				trailBind(varName, exprRegs[reg.v]);
+				exprRegs[var] = exprRegs[src];
+				VM_TRACE("BIND_OR_COMPARE", "BIND", "%e", var, "←%e", src);
+				bindVariable<Policy>(slot, exprRegs[src]);
+			}
+			else if (!exprRegs[var].sameQ(exprRegs[src]))
+			{
+				pc = target;
+				VM_TRACE("BIND_OR_COMPARE", "TAKEN", "%e", var, "!=%e", src, "⟹pc=", pc);
 			}
 			else
 			{
-				PM_ASSERT(!frames.empty(), "BIND_VAR: No active frame");
-				frames.back().bindVariable(varName, exprRegs[reg.v]);
-				traceOpcode("BIND_VAR", "INFO", varName, "←%e", reg.v, "=", exprRegs[reg.v].toString(), "(no trail)");
+				VM_TRACE("BIND_OR_COMPARE", "SKIP", "%e", var, "==%e", src);
 			}
-			break;
 		}
+		VM_NEXT();
 
-		case Opcode::LOAD_VAR:
+		VM_CASE(LOAD_VAR):
 		{
-			auto reg = std::get<ExprRegOp>(instr.ops[0]);
-			auto varName = std::get<Ident>(instr.ops[1]);
+			auto reg = ops[0];
+			auto slot = static_cast<size_t>(ops[1]);
 
 			// Search for variable in frame stack (innermost to outermost)
-			PM_ASSERT(!frames.empty(), "LOAD_VAR: No active frame");
+			PM_ASSERT(frameDepth > 0, "LOAD_VAR: No active frame");
 
-			std::optional<Expr> value;
-			for (auto it = frames.rbegin(); it != frames.rend(); ++it)
+			const Expr* value = nullptr;
+			for (size_t depth = frameDepth; depth > 0 && !value; --depth)
 			{
-				value = it->getVariable(varName);
-				if (value.has_value())
-					break;
+				value = frames[depth - 1].findVariable(slot);
 			}
 
-			if (value.has_value())
+			if (value)
 			{
 				// Variable is bound - load its value
-				exprRegs[reg.v] = value.value();
-				traceOpcode("LOAD_VAR", "BOUND", "%e", reg.v, "←", varName, "=", exprRegs[reg.v].toString());
+				exprRegs[reg] = *value;
+				VM_TRACE("LOAD_VAR", "BOUND", "%e", reg, "←", program->getSlotName(slot), "=", exprRegs[reg].toString());
 			}
 			else
 			{
 				// Variable is unbound - load $$Failure as a sentinel value
 				// The pattern compiler will handle the bind-vs-compare logic
-				exprRegs[reg.v] = Expr::ToExpression("$$Failure");
-				traceOpcode("LOAD_VAR", "UNBOUND", "%e", reg.v, "←", varName, "(unbound → $$Failure)");
+				exprRegs[reg] = getExprConstants().failureSymbol;
+				VM_TRACE("LOAD_VAR", "UNBOUND", "%e", reg, "←", program->getSlotName(slot), "(unbound → $$Failure)");
 			}
-			break;
 		}
+		VM_NEXT();
 
 			//=====================================================================
 			// SCOPE MANAGEMENT
 			//=====================================================================
 
-		case Opcode::BEGIN_BLOCK:
+		VM_CASE(BEGIN_BLOCK):
 		{
-			auto label = std::get<LabelOp>(instr.ops[0]);
-			frames.emplace_back();
-			traceOpcode("BEGIN_BLOCK", "INFO", "L", label.v, "depth=", frames.size());
-			break;
+			pushFrame();
+			VM_TRACE("BEGIN_BLOCK", "INFO", "pc=", ops[0], "depth=", frameDepth);
 		}
+		VM_NEXT();
 
-		case Opcode::END_BLOCK:
+		VM_CASE(END_BLOCK):
 		{
-			auto label = std::get<LabelOp>(instr.ops[0]);
-			PM_ASSERT(!frames.empty(), "END_BLOCK L", label.v, " with no matching BEGIN_BLOCK");
+			PM_ASSERT(frameDepth > 0, "END_BLOCK pc=", ops[0], " with no matching BEGIN_BLOCK");
 
 			// On success path (not unwinding failure), merge bindings upward
-			if (frames.size() > 1 && !unwindingFailure)
+			bool unwinding = isUnwindingFailure();
+			if (frameDepth > 1 && !unwinding)
 			{
-				auto& parentFrame = frames[frames.size() - 2];
-				saveBindings(parentFrame);
+				auto& parentFrame = frames[frameDepth - 2];
+				saveBindings<Policy>(parentFrame);
 			}
 
 			// Pop the frame
-			frames.pop_back();
-			traceOpcode("END_BLOCK", "INFO", "L", label.v, "depth=", frames.size(),
-						unwindingFailure ? "(unwinding)" : "(merged)");
-			break;
+			popFrame();
+			VM_TRACE("END_BLOCK", "INFO", "pc=", ops[0], "depth=", frameDepth,
+						unwinding ? "(unwinding)" : "(merged)");
 		}
+		VM_NEXT();
 
-		case Opcode::EXPORT_BINDINGS:
+		VM_CASE(EXPORT_BINDINGS):
 		{
-			PM_ASSERT(!frames.empty(), "EXPORT_BINDINGS with no active frame");
-			saveBindings(resultFrame);
-			traceOpcode("EXPORT_BINDINGS", "INFO", "saved", resultFrame.bindings.size(), "bindings");
-			break;
+			PM_ASSERT(frameDepth > 0, "EXPORT_BINDINGS with no active frame");
+			saveBindings<Policy>(resultFrame);
+			VM_TRACE("EXPORT_BINDINGS", "INFO", "saved", resultFrame.boundCount, "bindings");
 		}
+		VM_NEXT();
 
 			//=====================================================================
 			// BACKTRACKING
 			//=====================================================================
 
-		case Opcode::TRY:
+		VM_CASE(TRY):
 		{
-			auto nextAlt = std::get<LabelOp>(instr.ops[0]);
-			createChoicePoint(nextAlt.v);
-			traceOpcode("TRY", "INFO", "choice point", "⟹L", nextAlt.v, "depth=", choiceStack.size());
-			break;
+			auto nextAlt = static_cast<size_t>(ops[0]);
+			createChoicePoint<Policy>(nextAlt, program->getSaveSet(ops[1]));
+			if (ops[2] != 0)
+				enterBranch(ops[2]);
+			VM_TRACE("TRY", "INFO", "choice point", "⟹pc=", nextAlt, "depth=", choiceDepth);
 		}
+		VM_NEXT();
 
-		case Opcode::RETRY:
+		VM_CASE(RETRY):
 		{
-			auto nextAlt = std::get<LabelOp>(instr.ops[0]);
+			auto nextAlt = static_cast<size_t>(ops[0]);
 
-			if (!choiceStack.empty())
+			if (choiceDepth != 0)
 			{
-				choiceStack.back().nextAlternative = nextAlt.v;
-				traceOpcode("RETRY", "INFO", "updated choice point", "⟹L", nextAlt.v);
+				currentChoicePoint().nextAlternative = nextAlt;
+				VM_TRACE("RETRY", "INFO", "updated choice point", "⟹pc=", nextAlt);
 			}
 			else
 			{
 				PM_WARNING("RETRY with no choice point on stack");
 			}
-			break;
+			if (ops[1] != 0)
+				enterBranch(ops[1]);
 		}
+		VM_NEXT();
 
-		case Opcode::TRUST:
+		VM_CASE(TRUST):
 		{
-			if (!choiceStack.empty())
+			if (choiceDepth != 0)
 			{
-				choiceStack.pop_back();
-				traceOpcode("TRUST", "INFO", "removed choice point", "(last alternative)");
+				popChoicePoint();
+				VM_TRACE("TRUST", "INFO", "removed choice point", "(last alternative)");
 			}
 			else
 			{
 				PM_WARNING("TRUST with no choice point on stack");
 			}
-			break;
+			if (ops[0] != 0)
+				enterBranch(ops[0]);
 		}
+		VM_NEXT();
 
-		case Opcode::FAIL:
+		VM_CASE(FAIL):
 		{
-			if (!backtrack())
+			if (!backtrack<Policy>())
 			{
 				// No choice points left - permanent failure
 				halted = true;
-				boolRegs[0] = false;
-				traceOpcode("FAIL", "TERMINAL", "no choice points", "halting");
+				boolRegs.set(0, false);
+				VM_TRACE("FAIL", "TERMINAL", "no choice points", "halting");
 				return false;
 			}
 			else
 			{
-				traceOpcode("FAIL", "INFO", "backtracking", "depth=", choiceStack.size());
+				VM_TRACE("FAIL", "INFO", "backtracking", "depth=", choiceDepth);
 			}
-			break;
 		}
+		VM_NEXT();
 
-		case Opcode::CUT:
+		VM_CASE(CUT):
 		{
-			size_t removed = choiceStack.size();
-			commit();
-			traceOpcode("CUT", "INFO", "removed", removed, "choice points");
-			break;
+			size_t removed = choiceDepth;
+			commit<Policy>();
+			VM_TRACE("CUT", "INFO", "removed", removed, "choice points");
 		}
+		VM_NEXT();
 
 			//=====================================================================
 			// UNKNOWN OPCODE
@@ -885,7 +1356,7 @@ bool VirtualMachine::step()
 
 		default:
 		{
-			PM_ERROR("Unknown or unimplemented opcode: ", static_cast<int>(instr.opcode));
+			PM_ERROR("Unknown or unimplemented opcode: ", static_cast<int>(instr->opcode));
 			PM_ASSERT(false, "Unimplemented opcode");
 			halted = true;
 			return false;
@@ -894,38 +1365,146 @@ bool VirtualMachine::step()
 	return !halted;
 }
 
+#undef VM_FETCH
+#undef VM_CASE
+#undef VM_NEXT
+
+template <bool SingleStep>
+bool VirtualMachine::executeWithEngine()
+{
+	switch (getEngine())
+	{
+		case ExecutionEngine::Trace:
+			return execute<TracePolicy, SingleStep>();
+		case ExecutionEngine::Stats:
+			return execute<StatsPolicy, SingleStep>();
+		case ExecutionEngine::NoTrace:
+		default:
+			return execute<NoTracePolicy, SingleStep>();
+	}
+}
+
+ExecutionEngine VirtualMachine::getEngine() const
+{
+	// Without an explicit choice, follow the global trace flag (PatternMatcherEnableTrace[True|False])
+	if (engine)
+		return engine.value();
+	return Logger::isTraceEnabled() ? ExecutionEngine::Trace : ExecutionEngine::NoTrace;
+}
+
 //=============================================================================
 // High-Level Execution
 //=============================================================================
 
-bool VirtualMachine::match(Expr input)
+bool VirtualMachine::match(const Expr& input)
 {
-	if (!initialized || !bytecode)
+	if (!initialized || !program)
 	{
 		PM_ERROR("match() called on uninitialized VM");
 		return false;
 	}
 
+	// Reorder before the match, so its bindings stay readable afterwards
+	if (reorderInterval != 0 && matchesSinceReorder >= reorderInterval)
+		reorderAlternatives();
+	matchesSinceReorder++;
+
+	size_t acquireMark = ExprRefcountAudit::acquireCount;
+	size_t releaseMark = ExprRefcountAudit::releaseCount;
+
 	// Reset state and load input
 	reset();
 	exprRegs[0] = input; // Convention: %e0 holds input
 
 	// Execute until HALT or error
+	executeWithEngine<false>();
+
+	refcountAudit.acquires = ExprRefcountAudit::acquireCount - acquireMark;
+	refcountAudit.releases = ExprRefcountAudit::releaseCount - releaseMark;
+
+	// Convention: %b0 holds final match result
+	bool matched = currentBoolResult();
+	if (matched)
+		countBranchHits();
+	return matched;
+}
+
+bool VirtualMachine::matchStepwise(const Expr& input)
+{
+	if (!initialized || !program)
+	{
+		PM_ERROR("matchStepwise() called on uninitialized VM");
+		return false;
+	}
+
+	// Reset state and load input
+	reset();
+	exprRegs[0] = input; // Convention: %e0 holds input
+
+	// Execute one instruction at a time until HALT or error
 	while (!halted)
 	{
 		if (!step())
 			break;
 	}
 
-	// Convention: %b0 holds final match result
-	return currentBoolResult();
+	bool matched = currentBoolResult();
+	if (matched)
+		countBranchHits();
+	return matched;
+}
+
+void VirtualMachine::countBranchHits()
+{
+	for (size_t chain = 0; chain < enteredBranches.size(); ++chain)
+	{
+		if (enteredBranches[chain] != 0)
+			branchHits[chain][enteredBranches[chain] - 1]++;
+	}
+}
+
+//=============================================================================
+// Alternative Profile
+//=============================================================================
+
+PatternBytecode::AlternativeProfile VirtualMachine::getAlternativeProfile() const
+{
+	PatternBytecode::AlternativeProfile profile;
+	if (!bytecode)
+		return profile;
+
+	const auto& chains = bytecode.value()->getAlternativeChains();
+	for (size_t c = 0; c < chains.size() && c < branchHits.size(); ++c)
+	{
+		auto& hits = profile[chains[c].alternatives];
+		hits.resize(chains[c].alternatives->length(), 0);
+		for (size_t k = 0; k < chains[c].parts.size(); ++k)
+			hits[chains[c].parts[k] - 1] += branchHits[c][k];
+	}
+	return profile;
+}
+
+bool VirtualMachine::reorderAlternatives()
+{
+	if (!initialized || !bytecode)
+		return false;
+
+	matchesSinceReorder = 0;
+	auto reordered = bytecode.value()->reorderAlternatives(getAlternativeProfile());
+	if (!reordered)
+		return false;
+
+	// Relink to the reordered bytecode (the engine and reorder interval carry over)
+	shutdown();
+	initialize(reordered);
+	return true;
 }
 
 bool VirtualMachine::currentBoolResult()
 {
 	if (boolRegs.empty())
 		return false;
-	return boolRegs[0];
+	return boolRegs.get(0);
 }
 
 //=============================================================================
@@ -934,9 +1513,15 @@ bool VirtualMachine::currentBoolResult()
 
 namespace MethodInterface
 {
-	Expr compilePattern(VirtualMachine* vm, Expr expr)
+	Expr compilePattern(VirtualMachine* vm, Expr expr, Expr levelExpr)
 	{
-		auto bytecode = CompilePatternToBytecode(expr);
+		auto number = levelExpr.as<mint>();
+		auto level = number ? BytecodeOptimizer::optimizationLevelFromInteger(number.value()) : std::nullopt;
+		if (!level)
+		{
+			return Expr::throwError("Unknown optimization level; expected 0, 1 or 2", levelExpr);
+		}
+		auto bytecode = CompilePatternToBytecode(expr, level.value());
 		return EmbedObject(bytecode);
 	}
 	Expr getBytecode(VirtualMachine* vm)
@@ -951,13 +1536,57 @@ namespace MethodInterface
 	{
 		return Expr(static_cast<mint>(vm->getCycles()));
 	}
+	Expr getEngine(VirtualMachine* vm)
+	{
+		return Expr(engineName(vm->getEngine()));
+	}
+	Expr getStatistics(VirtualMachine* vm)
+	{
+		const auto& stats = vm->getStatistics();
+
+		std::vector<Expr> opcodeRules;
+		for (size_t i = 0; i < OpcodeCount; ++i)
+		{
+			if (stats.opcodeCounts[i] > 0)
+			{
+				opcodeRules.push_back(Expr::construct("Rule", Expr(opcodeName(static_cast<Opcode>(i))),
+													  Expr(static_cast<mint>(stats.opcodeCounts[i]))));
+			}
+		}
+		Expr opcodeCounts = Expr::createNormal(static_cast<mint>(opcodeRules.size()), "Association");
+		for (size_t i = 0; i < opcodeRules.size(); ++i)
+		{
+			opcodeCounts.setPart(static_cast<mint>(i + 1), opcodeRules[i]);
+		}
+
+		return Expr::construct(
+			"Association", Expr::construct("Rule", Expr("Cycles"), Expr(static_cast<mint>(vm->getCycles()))),
+			Expr::construct("Rule", Expr("OpcodeCounts"), opcodeCounts),
+			Expr::construct("Rule", Expr("FailureJumps"), Expr(static_cast<mint>(stats.failureJumps))),
+			Expr::construct("Rule", Expr("ChoicePoints"), Expr(static_cast<mint>(stats.choicePoints))),
+			Expr::construct("Rule", Expr("Backtracks"), Expr(static_cast<mint>(stats.backtracks))));
+	}
+	Expr getAlternativeProfile(VirtualMachine* vm)
+	{
+		auto profile = vm->getAlternativeProfile();
+		Expr profileExpr = Expr::createNormal(static_cast<mint>(profile.size()), "Association");
+		mint i = 1;
+		for (const auto& [alternatives, hits] : profile)
+		{
+			Expr hitsExpr = Expr::createNormal(static_cast<mint>(hits.size()), "List");
+			for (size_t k = 0; k < hits.size(); ++k)
+				hitsExpr.setPart(static_cast<mint>(k + 1), Expr(static_cast<mint>(hits[k])));
+			profileExpr.setPart(i++, Expr::construct("Rule", alternatives->getExpr(), hitsExpr));
+		}
+		return profileExpr;
+	}
 	Expr getPC(VirtualMachine* vm)
 	{
 		return Expr(static_cast<mint>(vm->getPC()));
 	}
 	Expr getResultBindings(VirtualMachine* vm)
 	{
-		const auto& bindings = vm->getResultBindings();
+		auto bindings = vm->getResultBindings();
 		Expr bindingsExpr = Expr::createNormal(static_cast<mint>(bindings.size()), "Association");
 		mint i = 1;
 		for (const auto& [varName, value] : bindings)
@@ -975,7 +1604,7 @@ namespace MethodInterface
 		}
 		auto bytecode = bytecodeOpt.value();
 		vm->initialize(bytecode);
-		return Expr::ToExpression("Null");
+		return getExprConstants().nullSymbol;
 	}
 	Expr isHalted(VirtualMachine* vm)
 	{
@@ -990,15 +1619,62 @@ namespace MethodInterface
 		bool res = vm->match(input);
 		return toExpr(res);
 	}
+	Expr getRefcountAudit(VirtualMachine* vm)
+	{
+		if (!ExprRefcountAudit::enabled)
+		{
+			return Expr::construct("Missing", Expr("NotAvailable"));
+		}
+		const auto& audit = vm->getRefcountAudit();
+		return Expr::construct("Association",
+							   Expr::construct("Rule", Expr("Acquire"), Expr(static_cast<mint>(audit.acquires))),
+							   Expr::construct("Rule", Expr("Release"), Expr(static_cast<mint>(audit.releases))));
+	}
+	Expr matchStepwise(VirtualMachine* vm, Expr input)
+	{
+		bool res = vm->matchStepwise(input);
+		return toExpr(res);
+	}
+	Expr reorderAlternatives(VirtualMachine* vm)
+	{
+		return toExpr(vm->reorderAlternatives());
+	}
 	Expr reset(VirtualMachine* vm)
 	{
 		vm->reset();
-		return Expr::ToExpression("Null");
+		return getExprConstants().nullSymbol;
+	}
+	Expr setEngine(VirtualMachine* vm, Expr nameExpr)
+	{
+		auto name = nameExpr.as<std::string>();
+		if (name && name.value() == "Automatic")
+		{
+			vm->setEngine(std::nullopt);
+			return getExprConstants().nullSymbol;
+		}
+		auto engine = name ? engineFromName(name.value()) : std::nullopt;
+		if (!engine)
+		{
+			return Expr::throwError("Unknown engine; expected \"NoTrace\", \"Trace\", \"Stats\" or \"Automatic\"",
+									nameExpr);
+		}
+		vm->setEngine(engine);
+		return getExprConstants().nullSymbol;
+	}
+	Expr setReorderInterval(VirtualMachine* vm, Expr nExpr)
+	{
+		auto n = nExpr.as<mint>();
+		if (!n || n.value() < 0)
+		{
+			return Expr::throwError("Reorder interval must be a non-negative integer", nExpr);
+		}
+		vm->setReorderInterval(static_cast<size_t>(n.value()));
+		return getExprConstants().nullSymbol;
 	}
 	Expr shutdown(VirtualMachine* vm)
 	{
 		vm->shutdown();
-		return Expr::ToExpression("Null");
+		return getExprConstants().nullSymbol;
 	}
 	Expr step(VirtualMachine* vm)
 	{
@@ -1018,15 +1694,23 @@ namespace MethodInterface
 void VirtualMachine::initializeEmbedMethods(const char* embedName)
 {
 	RegisterMethod<VirtualMachine*, MethodInterface::compilePattern>(embedName, "compilePattern");
+	RegisterMethod<VirtualMachine*, MethodInterface::getAlternativeProfile>(embedName, "getAlternativeProfile");
 	RegisterMethod<VirtualMachine*, MethodInterface::getCycles>(embedName, "getCycles");
 	RegisterMethod<VirtualMachine*, MethodInterface::getBytecode>(embedName, "getBytecode");
+	RegisterMethod<VirtualMachine*, MethodInterface::getEngine>(embedName, "getEngine");
 	RegisterMethod<VirtualMachine*, MethodInterface::getPC>(embedName, "getPC");
+	RegisterMethod<VirtualMachine*, MethodInterface::getRefcountAudit>(embedName, "getRefcountAudit");
 	RegisterMethod<VirtualMachine*, MethodInterface::getResultBindings>(embedName, "getResultBindings");
+	RegisterMethod<VirtualMachine*, MethodInterface::getStatistics>(embedName, "getStatistics");
 	RegisterMethod<VirtualMachine*, MethodInterface::initialize>(embedName, "initialize");
 	RegisterMethod<VirtualMachine*, MethodInterface::isHalted>(embedName, "isHalted");
 	RegisterMethod<VirtualMachine*, MethodInterface::isInitialized>(embedName, "isInitialized");
 	RegisterMethod<VirtualMachine*, MethodInterface::match>(embedName, "match");
+	RegisterMethod<VirtualMachine*, MethodInterface::matchStepwise>(embedName, "matchStepwise");
+	RegisterMethod<VirtualMachine*, MethodInterface::reorderAlternatives>(embedName, "reorderAlternatives");
 	RegisterMethod<VirtualMachine*, MethodInterface::reset>(embedName, "reset");
+	RegisterMethod<VirtualMachine*, MethodInterface::setEngine>(embedName, "setEngine");
+	RegisterMethod<VirtualMachine*, MethodInterface::setReorderInterval>(embedName, "setReorderInterval");
 	RegisterMethod<VirtualMachine*, MethodInterface::shutdown>(embedName, "shutdown");
 	RegisterMethod<VirtualMachine*, MethodInterface::step>(embedName, "step");
 	RegisterMethod<VirtualMachine*, MethodInterface::toBoxes>(embedName, "toBoxes");
@@ -1,13 +1,20 @@
 #pragma once
 
+#include "VM/BoolRegisterFile.h"
+#include "VM/ExecutionEngine.h"
+#include "VM/LinkedBytecode.h"
 #include "VM/PatternBytecode.h"
 
 #include "ClassSupport.h"
 #include "Expr.h"
 
+#include <algorithm>
+#include <bit>
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 #include <unordered_map>
 
@@ -29,7 +36,7 @@ Architecture:
 - Trail for undoing variable bindings on backtrack
 
 Execution Model:
-1. Load bytecode via initialize()
+1. Load bytecode via initialize() (links it into a LinkedBytecode)
 2. Set input expression in %e0
 3. Execute instructions via match() or step()
 4. Result in %b0, bindings in resultFrame
@@ -57,35 +64,76 @@ public:
 	/// @brief Represents a call frame for variable bindings
 	///
 	/// Each frame corresponds to a lexical scope (created by BEGIN_BLOCK).
-	/// Bindings are stored as name -> value mappings.
+	/// Bindings are stored by variable slot (assigned by the compiler, see
+	/// PatternBytecode::getVariableNames): a flat value array plus one bound
+	/// bit per slot. Names are only materialized by getResultBindings().
 	/// Frames can be nested (frame stack), and bindings can be merged
 	/// from child frames to parent frames on successful pattern match.
 	struct Frame
 	{
-		using Bindings = std::unordered_map<std::string, Expr>;
-		Bindings bindings; ///< Variable name -> bound value
+		std::vector<Expr> values; ///< Slot -> bound value (stale while the slot is unbound)
+		std::vector<uint64_t> boundBits; ///< One bit per slot: bound in this frame?
+		size_t boundCount = 0; ///< Number of bound slots
+		size_t choiceMark = 0; ///< Choice stack depth when the frame was pushed (frame stack only)
 
-		/// Bind or update a variable in this frame
-		void bindVariable(const std::string& name, const Expr& value)
+		/// Size the frame for a program's variable slots (all unbound)
+		void resize(size_t slotCount)
 		{
-			bindings.insert_or_assign(name, value);
-			return;
+			values.assign(slotCount, Expr(static_cast<ExprStruct>(nullptr)));
+			boundBits.assign((slotCount + 63) / 64, 0);
+			boundCount = 0;
 		}
 
-		/// Check if variable is bound in this frame
-		bool hasVariable(const std::string& name) const { return bindings.find(name) != bindings.end(); }
+		/// Check if a slot is bound in this frame
+		bool isBound(size_t slot) const { return (boundBits[slot >> 6] >> (slot & 63)) & 1; }
 
-		/// Get a variable binding (nullopt if not found)
-		std::optional<Expr> getVariable(const std::string& name) const
+		/// Bind or update a slot in this frame
+		void bindVariable(size_t slot, const Expr& value)
 		{
-			auto it = bindings.find(name);
-			if (it != bindings.end())
-				return it->second;
-			return std::nullopt;
+			if (!isBound(slot))
+			{
+				boundBits[slot >> 6] |= uint64_t(1) << (slot & 63);
+				boundCount++;
+			}
+			values[slot] = value;
 		}
 
-		/// Clear all bindings in this frame
-		void reset() { bindings.clear(); }
+		/// Unbind a slot in this frame
+		void unbindVariable(size_t slot)
+		{
+			if (isBound(slot))
+			{
+				boundBits[slot >> 6] &= ~(uint64_t(1) << (slot & 63));
+				boundCount--;
+			}
+		}
+
+		/// Borrow a slot's binding (nullptr if unbound)
+		const Expr* findVariable(size_t slot) const { return isBound(slot) ? &values[slot] : nullptr; }
+
+		/// Check if no slot is bound
+		bool empty() const { return boundCount == 0; }
+
+		/// Call f(slot, value) for every bound slot, in slot order
+		template <typename F>
+		void forEachBinding(F&& f) const
+		{
+			for (size_t w = 0; w < boundBits.size(); ++w)
+			{
+				for (uint64_t bits = boundBits[w]; bits != 0; bits &= bits - 1)
+				{
+					size_t slot = w * 64 + static_cast<size_t>(std::countr_zero(bits));
+					f(slot, values[slot]);
+				}
+			}
+		}
+
+		/// Unbind all slots (values are overwritten by the next bind)
+		void reset()
+		{
+			std::fill(boundBits.begin(), boundBits.end(), 0);
+			boundCount = 0;
+		}
 	};
 
 	//=========================================================================
@@ -95,37 +143,72 @@ public:
 	/// @brief Represents a saved state for backtracking (alternatives)
 	///
 	/// When TRY creates a choice point, it saves:
-	/// - All registers (for restoration on backtrack)
-	/// - Frame depth (to pop inner frames)
+	/// - The expression registers live at its alternatives (its save set,
+	///   computed by the compiler); every other one is dead there and is not copied
+	/// - The whole boolean register file (a single word in the common case)
+	/// - Frame depth and frame trail position (to restore the frame stack)
 	/// - Trail position (to undo variable bindings)
-	/// - Next alternative label (where to jump on FAIL)
+	/// - Next alternative PC (where to jump on FAIL)
 	///
 	/// Choice points implement non-deterministic choice in patterns like:
 	///   p1 | p2 | p3
 	///
 	/// If p1 fails, FAIL triggers backtrack:
-	/// - Restore registers from choice point
-	/// - Pop frames to saved depth
+	/// - Restore the saved registers from choice point
+	/// - Restore the frame stack (see SavedFrame)
 	/// - Unwind trail to undo bindings
 	/// - Jump to next alternative (p2)
+	///
+	/// SPLIT_SEQ choice points instead enumerate the lengths of one sequence
+	/// segment, as in {a__, b__}: each backtrack retries at pc + 1 with the
+	/// next length written to the SPLIT_SEQ destination and rest registers.
 	struct ChoicePoint
 	{
-		size_t returnPC; ///< PC when choice point was created (for debugging)
-		size_t nextAlternative; ///< Label to jump to on backtrack
-		std::vector<Expr> savedExprRegs; ///< Snapshot of expression registers
-		std::vector<bool> savedBoolRegs; ///< Snapshot of boolean registers
-		size_t trailMark; ///< Trail size to restore to
-		size_t frameMark; ///< Frame stack depth to restore to
-
-		ChoicePoint(size_t returnPC_, size_t nextAlt_, const std::vector<Expr>& exprRegs_,
-					const std::vector<bool>& boolRegs_, size_t trailMark_, size_t frameMark_)
-			: returnPC(returnPC_)
-			, nextAlternative(nextAlt_)
-			, savedExprRegs(exprRegs_)
-			, savedBoolRegs(boolRegs_)
-			, trailMark(trailMark_)
-			, frameMark(frameMark_)
+		size_t returnPC = 0; ///< PC when choice point was created (for debugging)
+		size_t nextAlternative = 0; ///< PC to jump to on backtrack (resolved at link time)
+		const LinkedBytecode::SaveSet* saveSet = nullptr; ///< Registers saved by this choice point
+		std::vector<Expr> savedExprRegs; ///< Values of saveSet->exprRegs, in order (may have stale extra entries)
+		BoolRegisterFile::Snapshot savedBoolRegs; ///< Whole boolean file (one word when <= 64 registers)
+		size_t trailMark = 0; ///< Trail size to restore to
+		size_t frameMark = 0; ///< Frame stack depth to restore to
+		size_t frameTrailMark = 0; ///< Saved frame count to restore to
+
+		/// SPLIT_SEQ state (split is false for TRY choice points)
+		bool split = false;
+		Expr splitSource = Expr(static_cast<ExprStruct>(nullptr)); ///< Sequence being split
+		size_t splitDst = 0; ///< Register receiving the first splitLength parts
+		size_t splitRest = 0; ///< Register receiving the remaining parts
+		mint splitLength = 0; ///< Length of the split being tried
+		mint splitMaxLength = 0; ///< Longest split allowed by the later segments
+
+		/// Record the machine state; reuses savedExprRegs' capacity from earlier choice points
+		void save(size_t returnPC_, size_t nextAlt_, const LinkedBytecode::SaveSet& saveSet_,
+				  const std::vector<Expr>& exprRegs_, const BoolRegisterFile& boolRegs_, size_t trailMark_,
+				  size_t frameMark_, size_t frameTrailMark_)
+		{
+			returnPC = returnPC_;
+			nextAlternative = nextAlt_;
+			saveSet = &saveSet_;
+			trailMark = trailMark_;
+			frameMark = frameMark_;
+			frameTrailMark = frameTrailMark_;
+			split = false;
+
+			// Overwrite in place; only grow (never shrink) so the storage is kept for reuse
+			size_t n = saveSet_.exprRegs.size();
+			if (savedExprRegs.size() < n)
+				savedExprRegs.resize(n, getExprConstants().nullSymbol);
+			for (size_t i = 0; i < n; ++i)
+				savedExprRegs[i] = exprRegs_[saveSet_.exprRegs[i]];
+			boolRegs_.save(savedBoolRegs);
+		}
+
+		/// Write the saved registers back into the register file
+		void restore(std::vector<Expr>& exprRegs_, BoolRegisterFile& boolRegs_) const
 		{
+			for (size_t i = 0; i < saveSet->exprRegs.size(); ++i)
+				exprRegs_[saveSet->exprRegs[i]] = savedExprRegs[i];
+			boolRegs_.restore(savedBoolRegs);
 		}
 	};
 
@@ -141,22 +224,34 @@ public:
 	///
 	/// Example: In pattern (x_Integer | x_Real) matching 4.2:
 	/// 1. TRY creates choice point (trailMark=0)
-	/// 2. First alt binds x -> 4.2 (trail=[{x, frame=1}])
+	/// 2. First alt binds x -> 4.2 (trail=[{slot of x, frame=1}])
 	/// 3. _Integer fails, FAIL unwinds trail (unbinds x)
 	/// 4. Second alt binds x -> 4.2 again
 	/// 5. _Real matches -> success
 	struct TrailEntry
 	{
-		std::string varName; ///< Variable to unbind
+		size_t slot; ///< Variable slot to unbind
 		size_t frameIndex; ///< Which frame the binding is in
 
-		TrailEntry(std::string name, size_t frame)
-			: varName(std::move(name))
+		TrailEntry(size_t slot_, size_t frame)
+			: slot(slot_)
 			, frameIndex(frame)
 		{
 		}
 	};
 
+	//=========================================================================
+	// RefcountAudit: Expr Refcount Traffic of the Last match()
+	//=========================================================================
+
+	/// @brief Number of Expression_Acquire/Release calls made by the last match()
+	/// @note Only counted when built with PM_REFCOUNT_AUDIT (see ExprRefcountAudit)
+	struct RefcountAudit
+	{
+		size_t acquires = 0;
+		size_t releases = 0;
+	};
+
 	//=========================================================================
 	// State Accessors (Read-Only)
 	//=========================================================================
@@ -177,12 +272,51 @@ public:
 	bool isInitialized() const { return initialized; }
 
 	/// Get the final result bindings after successful match
-	/// @return Map of variable name -> bound value
+	/// @return (variable name, bound value) pairs in slot order
 	/// @note Only valid after match() returns true and EXPORT_BINDINGS executed
-	const Frame::Bindings& getResultBindings() const { return resultFrame.bindings; }
+	std::vector<std::pair<std::string, Expr>> getResultBindings() const;
+
+	/// Get the refcount traffic of the last match() (zero unless built with PM_REFCOUNT_AUDIT)
+	const RefcountAudit& getRefcountAudit() const { return refcountAudit; }
+
+	/// @brief Select the execution engine used by step() and match()
+	/// @param engine_ The engine, or nullopt to follow PatternMatcherEnableTrace
+	void setEngine(std::optional<ExecutionEngine> engine_) { engine = engine_; }
+
+	/// Get the execution engine step() and match() will use
+	ExecutionEngine getEngine() const;
+
+	/// Get the counters collected by the Stats engine since the last reset()
+	const ExecutionStats& getStatistics() const { return stats; }
 
 	/// Check if there are active choice points (for backtracking)
-	bool hasChoicePoints() const { return !choiceStack.empty(); }
+	bool hasChoicePoints() const { return choiceDepth != 0; }
+
+	//=========================================================================
+	// Alternative Profile
+	//
+	// The branches of a recorded alternative chain (see
+	// PatternBytecode::AlternativeChain) can be tried in any order. The VM
+	// counts, per branch, the successful matches that entered it last, and
+	// reorderAlternatives() relinks the VM to the pattern compiled with the
+	// most frequent branches first.
+	//=========================================================================
+
+	/// @brief Get the successful matches per branch since initialize()
+	/// @note Chains of the same Alternatives add up
+	PatternBytecode::AlternativeProfile getAlternativeProfile() const;
+
+	/// @brief Reorder the alternatives of the loaded bytecode by the profile
+	/// @return true if the VM now runs a reordered bytecode (the profile starts over)
+	/// @note The loaded bytecode is not modified; other VMs running it are unaffected
+	bool reorderAlternatives();
+
+	/// @brief Reorder the alternatives automatically every n matches
+	/// @param n Number of match() calls between reorders, 0 to never reorder (the default)
+	void setReorderInterval(size_t n) { reorderInterval = n; }
+
+	/// Get the number of match() calls between automatic reorders (0: never)
+	size_t getReorderInterval() const { return reorderInterval; }
 
 	//=========================================================================
 	// Lifecycle Management
@@ -211,10 +345,18 @@ public:
 	/// @return true if pattern matches, false otherwise
 	/// @note Executes until HALT or error
 	/// @note Bindings available via getResultBindings() on success
-	bool match(Expr input);
+	bool match(const Expr& input);
+
+	/// @brief Execute a pattern match one instruction at a time via step()
+	/// @param input The expression to match against
+	/// @return true if pattern matches, false otherwise
+	/// @note Same result, bindings and cycle count as match(); exists to compare
+	///       the single-step path against the threaded run loop
+	bool matchStepwise(const Expr& input);
 
 	/// @brief Execute a single instruction (for debugging/tracing)
 	/// @return false if halted or error, true otherwise
+	/// @note match() does not use this; it runs the threaded executor
 	bool step();
 
 	/// @brief Get the current match result from %b0
@@ -223,35 +365,45 @@ public:
 
 	//=========================================================================
 	// Internal Operations (used by instruction implementations)
+	//
+	// Templated on the executor's instrumentation policy (see ExecutionEngine.h)
+	// so tracing and statistics compile away in the NoTrace engine.
 	//=========================================================================
 
-	/// @brief Jump to a label (unconditional or on failure)
-	/// @param label The label to jump to
+	/// @brief Jump to an instruction (unconditional or on failure)
+	/// @param targetPC The absolute PC to jump to (labels are resolved at link time)
 	/// @param isFailure true if this is a failure jump (sets unwinding flag)
-	void jump(LabelOp label, bool isFailure);
+	template <typename Policy>
+	void jump(size_t targetPC, bool isFailure);
 
 	/// @brief Save bindings from current frame to target frame
 	/// @param frame The frame to save bindings into
 	/// @note Used by END_BLOCK and EXPORT_BINDINGS
+	template <typename Policy>
 	void saveBindings(Frame& frame);
 
 	//=========================================================================
 	// Backtracking Operations
 	//=========================================================================
 
-	/// @brief Create a choice point for backtracking (TRY instruction)
-	/// @param nextAlternative Label to jump to on backtrack
-	/// @note Saves current state: registers, frames, trail
-	void createChoicePoint(size_t nextAlternative);
+	/// @brief Create a choice point for backtracking (TRY and SPLIT_SEQ instructions)
+	/// @param nextAlternative PC to jump to on backtrack
+	/// @param saveSet Registers live at the alternatives (the only ones saved)
+	/// @return The new choice point (SPLIT_SEQ fills in its split state)
+	/// @note Saves current state: live registers, frames, trail
+	template <typename Policy>
+	ChoicePoint& createChoicePoint(size_t nextAlternative, const LinkedBytecode::SaveSet& saveSet);
 
 	/// @brief Backtrack to most recent choice point (FAIL instruction)
 	/// @return false if no choice points exist (permanent failure)
 	/// @note Restores state and jumps to next alternative
 	/// @note Does NOT pop the choice point (RETRY/TRUST handle that)
+	template <typename Policy>
 	bool backtrack();
 
 	/// @brief Remove all choice points (CUT instruction)
 	/// @note Commits to current choice, prevents backtracking
+	template <typename Policy>
 	void commit();
 
 	//=========================================================================
@@ -259,14 +411,23 @@ public:
 	//=========================================================================
 
 	/// @brief Bind a variable with trail support
-	/// @param varName Variable name to bind
+	/// @param slot Variable slot to bind
 	/// @param value Value to bind to
 	/// @note Creates trail entry if choice points exist
-	void trailBind(const std::string& varName, const Expr& value);
+	template <typename Policy>
+	void trailBind(size_t slot, const Expr& value);
+
+	/// @brief Bind a variable in the current frame
+	/// @param slot Variable slot to bind
+	/// @param value Value to bind to
+	/// @note Goes through trailBind while choice points exist, binds directly otherwise
+	template <typename Policy>
+	void bindVariable(size_t slot, const Expr& value);
 
 	/// @brief Unwind trail to a previous mark (undo bindings)
 	/// @param mark Trail size to restore to
 	/// @note Called by backtrack() to undo failed alternative's bindings
+	template <typename Policy>
 	void unwindTrail(size_t mark);
 
 	//=========================================================================
@@ -277,6 +438,33 @@ public:
 	void initializeEmbedMethods(const char* embedName);
 
 private:
+	/// @brief Executor shared by step() and match()
+	/// @tparam Policy Instrumentation policy (NoTracePolicy, TracePolicy, StatsPolicy)
+	/// @tparam SingleStep true: execute one instruction and return (step())
+	///                    false: run from pc until HALT, FAIL without choice points, or error (match())
+	/// @return false if halted or error, true otherwise
+	/// @note The run loop does no per-instruction bookkeeping beyond the cycle count
+	///       and uses computed-goto dispatch where the compiler supports it
+	template <typename Policy, bool SingleStep>
+	bool execute();
+
+	/// Run execute() instantiated for the engine selected by getEngine()
+	template <bool SingleStep>
+	bool executeWithEngine();
+
+	/// Load the values of a condition's variables (see conditionArgs)
+	void loadConditionArgs(const PatternBytecode::Condition& condition);
+
+	/// Build conditionBlocks for the loaded program
+	void buildConditionBlocks();
+
+	/// Evaluate a condition in the kernel, inside a Block of the variables it references
+	Expr evalConditionInBlock(LinkedBytecode::Word index);
+
+	/// True when the current instruction was reached by a failure transfer
+	/// (END_BLOCK then discards the frame instead of merging its bindings)
+	bool isUnwindingFailure() const { return failureCycle + 1 == cycles; }
+
 	//=========================================================================
 	// VM State
 	//=========================================================================
@@ -285,9 +473,11 @@ private:
 	bool initialized = false; ///< Has bytecode been loaded?
 	bool halted = false; ///< Has execution stopped?
 
-	/// Execution flags
-	bool backtracking = false; ///< Currently backtracking?
-	bool unwindingFailure = false; ///< Unwinding after failure?
+	/// Failure tracking: cycle of the last failure transfer (failure jump or backtrack).
+	/// Recording the cycle instead of a per-instruction flag lets the run loop skip
+	/// resetting state on every dispatch.
+	static constexpr size_t NoFailureCycle = static_cast<size_t>(-1);
+	size_t failureCycle = NoFailureCycle;
 
 	/// Execution state
 	size_t pc = 0; ///< Program counter (current instruction index)
@@ -296,26 +486,118 @@ private:
 	/// Loaded bytecode
 	std::optional<std::shared_ptr<PatternBytecode>> bytecode = std::nullopt;
 
+	/// Executable (linked) form of the loaded bytecode, built by initialize()
+	std::shared_ptr<LinkedBytecode> program;
+
 	//=========================================================================
 	// Runtime State
 	//=========================================================================
 
-	/// Lexical scope stack (BEGIN_BLOCK/END_BLOCK)
+	/// Lexical scope stack (BEGIN_BLOCK/END_BLOCK): frames[0, frameDepth) are live.
+	/// Popped frames stay allocated and are reused by the next BEGIN_BLOCK.
 	std::vector<Frame> frames;
+	size_t frameDepth = 0;
+
+	/// Push a frame with every slot unbound
+	void pushFrame();
+
+	/// Pop the innermost frame, saving it if a live choice point was made inside it
+	void popFrame();
+
+	/// @brief A frame popped by END_BLOCK while a choice point made inside it was live
+	///
+	/// Backtracking into such a choice point (e.g. a SPLIT_SEQ retried by a
+	/// failing condition outside the block, as in {a__, b__} /; test) resumes
+	/// inside the block, so the frame must come back. The popped frame is
+	/// swapped into the frame trail rather than copied; restoreFrames() swaps
+	/// it back to its stack index.
+	struct SavedFrame
+	{
+		size_t index; ///< Frame stack index the frame was popped from
+		Frame frame;
+	};
+
+	/// Frame trail: frameTrail[0, frameTrailDepth) are saved frames, oldest first
+	std::vector<SavedFrame> frameTrail;
+	size_t frameTrailDepth = 0;
+
+	/// Swap back every frame saved after the mark (newest first, so the oldest copy of an index wins)
+	void restoreFrames(size_t mark);
+
+	/// The innermost live frame
+	Frame& currentFrame() { return frames[frameDepth - 1]; }
+	const Frame& currentFrame() const { return frames[frameDepth - 1]; }
 
 	/// Register file
 	std::vector<Expr> exprRegs; ///< Expression registers (%e0, %e1, ...)
-	std::vector<bool> boolRegs; ///< Boolean registers (%b0, %b1, ...)
+	BoolRegisterFile boolRegs; ///< Boolean registers (%b0, %b1, ...), one bit each
 
 	/// Result frame (for EXPORT_BINDINGS)
 	Frame resultFrame;
 
+	/// Values of the variables of the condition being evaluated, nullptr if unbound
+	/// (sized once: a condition reads at most every slot)
+	std::vector<const Expr*> conditionArgs;
+
+	/// Prebuilt Block[{x = Null, ...}, test] of a condition, by condition index
+	struct ConditionBlock
+	{
+		Expr block;
+		std::vector<Expr> assignments; ///< The x = value parts of block, updated in place
+	};
+	std::vector<ConditionBlock> conditionBlocks;
+
+	/// Refcount traffic of the last match()
+	RefcountAudit refcountAudit;
+
+	/// Selected execution engine (nullopt: follow the global trace flag)
+	std::optional<ExecutionEngine> engine = std::nullopt;
+
+	/// Counters of the Stats engine since the last reset()
+	ExecutionStats stats;
+
+	/// Branch each alternative chain entered last in this match, plus 1 (0: none), by chain
+	std::vector<size_t> enteredBranches;
+
+	/// Successful matches per branch of each alternative chain, by chain
+	std::vector<std::vector<size_t>> branchHits;
+
+	/// Automatic reorder interval (see setReorderInterval) and match() calls since the last reorder
+	size_t reorderInterval = 0;
+	size_t matchesSinceReorder = 0;
+
+	/// Record that the branch of a TRY, RETRY or TRUST branch point operand was entered
+	void enterBranch(LinkedBytecode::Word point)
+	{
+		const auto& branchPoint = program->getBranchPoint(point);
+		enteredBranches[branchPoint.chain] = static_cast<size_t>(branchPoint.branch) + 1;
+	}
+
+	/// Count the branches entered by a successful match
+	void countBranchHits();
+
 	//=========================================================================
 	// Backtracking State
 	//=========================================================================
 
-	/// Choice point stack (for alternatives)
+	/// Choice point stack (for alternatives): choiceStack[0, choiceDepth) are live.
+	/// Popped choice points keep their register storage for the next TRY.
 	std::vector<ChoicePoint> choiceStack;
+	size_t choiceDepth = 0;
+
+	/// Push an uninitialized choice point (the caller fills it with ChoicePoint::save)
+	ChoicePoint& pushChoicePoint()
+	{
+		if (choiceDepth == choiceStack.size())
+			choiceStack.emplace_back();
+		return choiceStack[choiceDepth++];
+	}
+
+	/// Pop the innermost choice point
+	void popChoicePoint() { choiceDepth--; }
+
+	/// The innermost live choice point
+	ChoicePoint& currentChoicePoint() { return choiceStack[choiceDepth - 1]; }
 
 	/// Trail (undo log for variable bindings)
 	std::vector<TrailEntry> trail;